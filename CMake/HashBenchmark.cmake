@@ -0,0 +1,19 @@
+# CVar: Console variable systems support library
+# license: Apache, see LICENCE file
+# file: HashBenchmark.cmake - runtime hash throughput benchmark
+# author: Karl-Mihkel Ott
+
+set(HASH_BENCHMARK_TARGET HashBenchmark)
+set(HASH_BENCHMARK_HEADERS)
+set(HASH_BENCHMARK_SOURCES
+    ${CMAKE_CURRENT_SOURCE_DIR}/Demos/HashBenchmark.cpp)
+
+add_executable(${HASH_BENCHMARK_TARGET}
+    ${HASH_BENCHMARK_HEADERS}
+    ${HASH_BENCHMARK_SOURCES})
+
+add_dependencies(${HASH_BENCHMARK_TARGET}
+    ${CVAR_TARGET})
+
+target_link_libraries(${HASH_BENCHMARK_TARGET}
+    PRIVATE ${CVAR_TARGET})
@@ -0,0 +1,19 @@
+# CVar: Console variable systems support library
+# license: Apache, see LICENCE file
+# file: SerializerBenchmark.cmake - serializer and unserializer throughput benchmark
+# author: Karl-Mihkel Ott
+
+set(SERIALIZER_BENCHMARK_TARGET SerializerBenchmark)
+set(SERIALIZER_BENCHMARK_HEADERS)
+set(SERIALIZER_BENCHMARK_SOURCES
+    ${CMAKE_CURRENT_SOURCE_DIR}/Demos/SerializerBenchmark.cpp)
+
+add_executable(${SERIALIZER_BENCHMARK_TARGET}
+    ${SERIALIZER_BENCHMARK_HEADERS}
+    ${SERIALIZER_BENCHMARK_SOURCES})
+
+add_dependencies(${SERIALIZER_BENCHMARK_TARGET}
+    ${CVAR_TARGET})
+
+target_link_libraries(${SERIALIZER_BENCHMARK_TARGET}
+    PRIVATE ${CVAR_TARGET})
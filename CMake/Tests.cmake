@@ -0,0 +1,42 @@
+# CVar: Console variable systems support library
+# license: Apache, see LICENCE file
+# file: Tests.cmake - unit test executables registered with CTest
+# author: Karl-Mihkel Ott
+
+set(CVAR_TESTS_DIR ${CMAKE_CURRENT_SOURCE_DIR}/Tests)
+set(CVAR_TEST_HEADERS
+    ${CVAR_TESTS_DIR}/TestCommon.h)
+
+# every test is a standalone executable, which returns nonzero if any of its checks failed
+function(cvar_add_test _name)
+    add_executable(${_name}
+        ${CVAR_TEST_HEADERS}
+        ${CVAR_TESTS_DIR}/${_name}.cpp)
+
+    add_dependencies(${_name}
+        ${CVAR_TARGET})
+
+    target_link_libraries(${_name}
+        PRIVATE ${CVAR_TARGET})
+
+    set_target_properties(${_name} PROPERTIES FOLDER Tests)
+    add_test(NAME ${_name} COMMAND ${_name} WORKING_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR})
+endfunction()
+
+cvar_add_test(HandleTests)
+cvar_add_test(HashTests)
+cvar_add_test(WriteTests)
+cvar_add_test(FlatIndexTests)
+cvar_add_test(ObjectMapTests)
+cvar_add_test(PathIndexTests)
+cvar_add_test(SnapshotTests)
+cvar_add_test(StatsTests)
+cvar_add_test(TreeVisitorTests)
+cvar_add_test(AtomicTests)
+cvar_add_test(StaticTests)
+cvar_add_test(SubscriptionTests)
+cvar_add_test(PackedListTests)
+cvar_add_test(JournalTests)
+cvar_add_test(IncrementalSaveTests)
+cvar_add_test(SerializerTests)
+cvar_add_test(ScannerTests)
@@ -6,20 +6,54 @@
 set(CVAR_TARGET cvar)
 set(CVAR_HEADERS
     ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/Api.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/Arena.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/AtomicCVar.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/BinaryFormat.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/BinarySerializer.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/BinaryUnserializer.h
 	${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/BufferedInputStream.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/CVarPath.h
     ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/CVarSystem.h
     ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/CVarTypes.h
     ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/ISerializer.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/JSONScanner.h
     ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/JSONSerializer.h
     ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/JSONUnserializer.h
-    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/SID.h)
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/Journal.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/MappedConfig.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/MessagePackSerializer.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/MessagePackUnserializer.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/OrderedMap.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/PathIndex.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/SerializationCache.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/SID.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/Snapshot.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/StaticCVar.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/Stats.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/TreeVisitor.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/YAMLSerializer.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/cvar/YAMLUnserializer.h)
 
 set(CVAR_SOURCES
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/Arena.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/BinarySerializer.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/BinaryUnserializer.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/Sources/CVarSystem.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/Sources/CVarTypes.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/JSONScanner.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/Sources/JSONSerializer.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/Sources/JSONUnserializer.cpp
-    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/SID.cpp)
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/Journal.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/MappedConfig.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/MessagePackSerializer.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/MessagePackUnserializer.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/PathIndex.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/SerializationCache.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/SID.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/StaticCVar.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/Stats.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/YAMLSerializer.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/YAMLUnserializer.cpp)
 
 if (NOT CVAR_STATIC)
     add_library(${CVAR_TARGET} SHARED
@@ -35,5 +69,15 @@ else()
 		PUBLIC CVAR_STATIC)
 endif()
 
+if (CVAR_HASH_BACKEND STREQUAL "CRC32C")
+    target_compile_definitions(${CVAR_TARGET}
+        PUBLIC CVAR_HASH_BACKEND=CVAR_HASH_CRC32C)
+endif()
+
 target_include_directories(${CVAR_TARGET}
     PUBLIC ${CMAKE_CURRENT_SOURCE_DIR}/Include)
+
+# journal writes snapshots and syncs files from a background thread
+find_package(Threads REQUIRED)
+target_link_libraries(${CVAR_TARGET}
+    PUBLIC Threads::Threads)
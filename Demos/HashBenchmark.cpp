@@ -0,0 +1,78 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: HashBenchmark.cpp - runtime hash throughput benchmark
+// author: Karl-Mihkel Ott
+
+#include <cvar/SID.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// reference implementation processing one byte per table lookup, as RuntimeCrc64() used to do
+static uint64_t ByteWiseCrc64(const char* _szData, size_t _uLen) {
+    uint64_t uHash = 0;
+    for (size_t i = 0; i < _uLen; i++)
+        uHash = (uHash >> 8) ^ cvar::crc64_table[(uHash ^ _szData[i]) & 0xff];
+    return uHash ^ 0xffffffffffffffff;
+}
+
+template <typename Fn>
+static void Measure(const char* _szName, const std::vector<std::string>& _keys, Fn&& _fn) {
+    size_t uBytes = 0;
+    for (const std::string& sKey : _keys)
+        uBytes += sKey.size();
+
+    // repeat until roughly 256 MiB have been hashed, so that short keys are measured over enough iterations
+    const size_t uRounds = (256ull << 20) / uBytes + 1;
+    uint64_t uSink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < uRounds; r++) {
+        for (const std::string& sKey : _keys)
+            uSink ^= _fn(sKey.data(), sKey.size());
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    double fGiBps = static_cast<double>(uBytes) * uRounds / elapsed.count() / (1ull << 30);
+    std::printf("  %-24s %8.3f GiB/s (%016llx)\n", _szName, fGiBps, static_cast<unsigned long long>(uSink));
+}
+
+static void RunAll(const std::vector<std::string>& _keys) {
+    Measure("crc64 byte-wise", _keys, ByteWiseCrc64);
+    Measure("crc64 slicing-by-8", _keys, [](const char* _szData, size_t _uLen) {
+        return cvar::RuntimeCrc64(_szData, _uLen);
+    });
+    Measure("crc32 slicing-by-8", _keys, [](const char* _szData, size_t _uLen) {
+        return static_cast<uint64_t>(cvar::RuntimeCrc32(_szData, _uLen));
+    });
+    Measure("crc32c software", _keys, [](const char* _szData, size_t _uLen) {
+        return static_cast<uint64_t>(cvar::RuntimeCrc32cSoftware(_szData, _uLen));
+    });
+    if (cvar::HasHardwareCrc32c()) {
+        Measure("crc32c hardware", _keys, [](const char* _szData, size_t _uLen) {
+            return static_cast<uint64_t>(cvar::RuntimeCrc32c(_szData, _uLen));
+        });
+    }
+}
+
+int main() {
+    std::printf("Hardware CRC-32C: %s\n", cvar::HasHardwareCrc32c() ? "yes" : "no");
+    std::printf("Key hash backend: %s\n", CVAR_HASH_BACKEND == CVAR_HASH_CRC32C ? "CRC32C" : "CRC");
+
+    std::srand(1234);
+    const size_t arrLengths[] = { 8, 16, 32, 64, 65536 };
+    for (size_t uLen : arrLengths) {
+        std::vector<std::string> keys(uLen >= 4096 ? 4 : 4096);
+        for (std::string& sKey : keys) {
+            sKey.resize(uLen);
+            for (char& c : sKey)
+                c = static_cast<char>('a' + std::rand() % 26);
+        }
+
+        std::printf("%zu byte keys:\n", uLen);
+        RunAll(keys);
+    }
+
+    return 0;
+}
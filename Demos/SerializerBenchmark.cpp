@@ -0,0 +1,149 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: SerializerBenchmark.cpp - serializer and unserializer throughput benchmark
+// author: Karl-Mihkel Ott
+
+#include <cvar/BinarySerializer.h>
+#include <cvar/BinaryUnserializer.h>
+#include <cvar/JSONScanner.h>
+#include <cvar/JSONSerializer.h>
+#include <cvar/JSONUnserializer.h>
+#include <cvar/MessagePackSerializer.h>
+#include <cvar/MessagePackUnserializer.h>
+#include <cvar/YAMLSerializer.h>
+#include <cvar/YAMLUnserializer.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// tree of nested objects with mixed scalars, strings and packed lists
+static cvar::ObjectMap GenerateTree(size_t _uObjects, size_t _uEntries) {
+    cvar::ObjectMap root;
+    for (size_t i = 0; i < _uObjects; i++) {
+        auto pObject = std::make_shared<cvar::Object>();
+        cvar::ObjectMap& contents = pObject->GetContents();
+        for (size_t j = 0; j < _uEntries; j++) {
+            const std::string sKey = "var" + std::to_string(j);
+            switch (j % 5) {
+                case 0:
+                    contents[cvar::Symbol(sKey)] = static_cast<cvar::Int>(i * j);
+                    break;
+
+                case 1:
+                    contents[cvar::Symbol(sKey)] = static_cast<cvar::Float>(i) / static_cast<cvar::Float>(j);
+                    break;
+
+                case 2:
+                    contents[cvar::Symbol(sKey)] = (i + j) % 2 == 0;
+                    break;
+
+                case 3:
+                    contents[cvar::Symbol(sKey)] = cvar::String("value of " + sKey + " in object " + std::to_string(i));
+                    break;
+
+                default:
+                {
+                    cvar::List list;
+                    for (cvar::Int k = 0; k < 16; k++)
+                        list.PushBack(k * static_cast<cvar::Int>(j));
+                    contents[cvar::Symbol(sKey)] = std::move(list);
+                    break;
+                }
+            }
+        }
+
+        root[cvar::Symbol("object" + std::to_string(i))] = std::move(pObject);
+    }
+
+    return root;
+}
+
+
+template <typename Serializer, typename Unserializer>
+static void Measure(const char* _szName, cvar::ObjectMap& _root, size_t _uRounds) {
+    std::string sData;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < _uRounds; r++) {
+        std::stringstream ss;
+        Serializer serializer(ss, _root);
+        serializer.Serialize(false);
+        sData = ss.str();
+    }
+    std::chrono::duration<double> serializeTime = std::chrono::steady_clock::now() - start;
+
+    size_t uEntries = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < _uRounds; r++) {
+        std::stringstream ss(sData);
+        Unserializer unserializer(ss);
+        uEntries += unserializer.Get().size();
+    }
+    std::chrono::duration<double> unserializeTime = std::chrono::steady_clock::now() - start;
+
+    const double fMiB = static_cast<double>(sData.size()) * _uRounds / (1 << 20);
+    std::printf("  %-12s %10zu bytes  serialize %8.1f MiB/s  unserialize %8.1f MiB/s (%zu)\n", _szName, sData.size(),
+                fMiB / serializeTime.count(), fMiB / unserializeTime.count(), uEntries);
+}
+
+
+// first stage of JSONUnserializer alone, for every backend that the CPU supports
+static void MeasureJSONScan(cvar::ObjectMap& _root, size_t _uRounds) {
+    std::stringstream ss;
+    cvar::JSONSerializer serializer(ss, _root);
+    serializer.Serialize(false);
+    const std::string sData = ss.str();
+
+    const cvar::JSONScanBackend arrBackends[] = {
+        cvar::JSONScanBackend::Scalar, cvar::JSONScanBackend::SSE2, cvar::JSONScanBackend::AVX2
+    };
+
+    std::vector<uint32_t> indices;
+    for (cvar::JSONScanBackend backend : arrBackends) {
+        if (backend > cvar::GetJSONScanBackend())
+            break;
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t r = 0; r < _uRounds; r++) {
+            indices.clear();
+            cvar::ScanJSONStructure(sData.data(), sData.size(), indices, backend);
+        }
+        std::chrono::duration<double> scanTime = std::chrono::steady_clock::now() - start;
+
+        const double fGiB = static_cast<double>(sData.size()) * _uRounds / (1 << 30);
+        std::printf("  JSON scan %-6s %8.2f GiB/s (%zu structural characters)\n", cvar::GetJSONScanBackendName(backend),
+                    fGiB / scanTime.count(), indices.size());
+    }
+}
+
+
+int main(int argc, char* argv[]) {
+    cvar::ObjectMap root;
+    if (argc > 1) {
+        std::ifstream file(argv[1]);
+        if (!file) {
+            std::fprintf(stderr, "Failed to open file '%s'\n", argv[1]);
+            return EXIT_FAILURE;
+        }
+
+        cvar::JSONUnserializer unserializer(file);
+        root = unserializer.Get();
+        std::printf("Input: %s\n", argv[1]);
+    }
+    else {
+        root = GenerateTree(4096, 32);
+        std::printf("Input: generated tree of 4096 objects with 32 entries each\n");
+    }
+
+    const size_t uRounds = 5;
+    Measure<cvar::JSONSerializer, cvar::JSONUnserializer>("JSON", root, uRounds);
+    Measure<cvar::YAMLSerializer, cvar::YAMLUnserializer>("YAML", root, uRounds);
+    Measure<cvar::MessagePackSerializer, cvar::MessagePackUnserializer>("MessagePack", root, uRounds);
+    Measure<cvar::BinarySerializer, cvar::BinaryUnserializer>("Binary", root, uRounds);
+    MeasureJSONScan(root, uRounds * 4);
+    return 0;
+}
@@ -0,0 +1,60 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: Arena.h - arena memory resource for CVar tree nodes header
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <memory>
+#include <memory_resource>
+#include <cvar/Api.h>
+
+#ifndef CVAR_ARENA_BLOCK_SIZE
+    #define CVAR_ARENA_BLOCK_SIZE 65536
+#endif
+
+namespace cvar {
+
+    // Arena hands out memory for object contents and lists from large blocks. Individual deallocations
+    // are no-ops and all blocks are released at once when the arena is destroyed. Every object allocated
+    // from an arena holds a reference to it, thus an arena must always be owned by a std::shared_ptr.
+    class CVAR_API Arena : public std::enable_shared_from_this<Arena> {
+        private:
+            std::pmr::monotonic_buffer_resource m_resource;
+
+        public:
+            Arena(size_t _uBlockSize = CVAR_ARENA_BLOCK_SIZE) :
+                m_resource(_uBlockSize, std::pmr::new_delete_resource()) {}
+            Arena(const Arena&) = delete;
+            Arena& operator=(const Arena&) = delete;
+
+            inline std::pmr::memory_resource* GetResource() {
+                return &m_resource;
+            }
+
+            // arena used by the calling thread, nullptr if nodes are allocated from the heap
+            static Arena* GetCurrent();
+            static std::pmr::memory_resource* GetCurrentResource();
+
+            inline static std::shared_ptr<Arena> GetCurrentRef() {
+                Arena* pArena = GetCurrent();
+                return pArena ? pArena->shared_from_this() : nullptr;
+            }
+
+            friend class ArenaScope;
+    };
+
+
+    // ArenaScope makes the given arena current for the calling thread until the scope ends, null arena
+    // selects heap allocation. The caller must keep the arena referenced for the lifetime of the scope.
+    class CVAR_API ArenaScope {
+        private:
+            Arena* m_pPrevious;
+
+        public:
+            ArenaScope(const std::shared_ptr<Arena>& _pArena);
+            ~ArenaScope();
+            ArenaScope(const ArenaScope&) = delete;
+            ArenaScope& operator=(const ArenaScope&) = delete;
+    };
+}
@@ -0,0 +1,117 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: AtomicCVar.h - lock-free scalar CVar storage header
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+#include <cvar/CVarTypes.h>
+
+#ifndef CVAR_CACHE_LINE_SIZE
+    #define CVAR_CACHE_LINE_SIZE 64
+#endif
+
+namespace cvar {
+
+    // AtomicSlot holds the bits of a single scalar variable. Each slot occupies its own cache line,
+    // so that frequently written variables don't cause false sharing with their neighbours.
+    struct alignas(CVAR_CACHE_LINE_SIZE) AtomicSlot {
+        AtomicSlot(const std::string& _sKey, Type _type, uint32_t _uBits) :
+            uBits(_uBits),
+            type(_type),
+            sKey(_sKey) {}
+
+        std::atomic<uint32_t> uBits;
+        Type type;
+        std::string sKey;
+    };
+
+    template <typename T>
+    struct AtomicTraits {
+        static constexpr bool bSupported = false;
+    };
+
+    template <>
+    struct AtomicTraits<Int> {
+        static constexpr bool bSupported = true;
+        static constexpr Type type = Type_Int;
+    };
+
+    template <>
+    struct AtomicTraits<Float> {
+        static constexpr bool bSupported = true;
+        static constexpr Type type = Type_Float;
+    };
+
+    template <>
+    struct AtomicTraits<Bool> {
+        static constexpr bool bSupported = true;
+        static constexpr Type type = Type_Bool;
+    };
+
+    template <typename T>
+    inline uint32_t ToAtomicBits(T _val) {
+        static_assert(sizeof(T) <= sizeof(uint32_t), "Atomic CVar type must fit into 32 bits");
+        uint32_t uBits = 0;
+        std::memcpy(&uBits, &_val, sizeof(T));
+        return uBits;
+    }
+
+    template <typename T>
+    inline T FromAtomicBits(uint32_t _uBits) {
+        T val;
+        std::memcpy(&val, &_uBits, sizeof(T));
+        return val;
+    }
+
+    inline uint32_t ToAtomicBits(const Value& _val, Type _type) {
+        switch (_type) {
+            case Type_Int:
+                return ToAtomicBits(std::get<Int>(_val));
+
+            case Type_Float:
+                return ToAtomicBits(std::get<Float>(_val));
+
+            case Type_Bool:
+                return ToAtomicBits(std::get<Bool>(_val));
+
+            default:
+                return 0;
+        }
+    }
+
+    // AtomicCVar can be loaded from and stored to from any thread without locking. Stores made through
+    // AtomicCVar are written into the variable tree whenever the variable is read through CVarSystem, before
+    // serialization, statistics and snapshots, or explicitly by CVarSystem::SyncAtomics(), while CVarSystem::Set() writes through to the slot immediately.
+    template <typename T>
+    class AtomicCVar {
+        static_assert(AtomicTraits<T>::bSupported, "Only Int, Float and Bool variables can be stored atomically");
+
+        private:
+            AtomicSlot* m_pSlot = nullptr;
+
+        public:
+            AtomicCVar() = default;
+            AtomicCVar(AtomicSlot* _pSlot) :
+                m_pSlot(_pSlot) {}
+
+            inline T Load(std::memory_order _order = std::memory_order_acquire) const {
+                return FromAtomicBits<T>(m_pSlot->uBits.load(_order));
+            }
+
+            inline void Store(T _val, std::memory_order _order = std::memory_order_release) {
+                m_pSlot->uBits.store(ToAtomicBits(_val), _order);
+            }
+
+            inline bool IsValid() const {
+                return m_pSlot != nullptr;
+            }
+
+            inline explicit operator bool() const {
+                return IsValid();
+            }
+    };
+}
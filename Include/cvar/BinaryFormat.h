@@ -0,0 +1,70 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: BinaryFormat.h - memory mappable binary CVar image layout header
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cvar/SID.h>
+
+namespace cvar {
+
+    // Binary image layout. All blocks are 8 byte aligned and referenced by their offset from the beginning of the
+    // image, thus the image can be used in place wherever it is mapped. Numbers are stored in native byte order.
+    //
+    // header - BinaryHeader
+    // string - BinaryString followed by the text and a terminating zero, used for keys and String values
+    // object - BinaryObject followed by the entries in insertion order and the entry indices sorted by key hash
+    // list - BinaryList followed by the packed scalars or a slot for each element
+
+    static constexpr char s_szBinaryMagic[4] = { 'C', 'V', 'B', '1' };
+    static constexpr size_t s_uBinaryAlignment = 8;
+
+    // key hashes are only valid lookup keys if the image was written with the same hash function
+    static constexpr uint16_t s_uBinaryHashId = static_cast<uint16_t>((CVAR_HASH_BACKEND << 8) | sizeof(hash_t));
+
+    struct BinaryHeader {
+        char szMagic[4];
+        uint16_t uHashId;
+        uint16_t uReserved;
+        uint32_t uRootOffset;
+        uint32_t uSize;
+    };
+
+    // Int and Float bits and Bool values are stored inline, uData of other types is the offset of their block
+    struct BinarySlot {
+        uint8_t uType;
+        uint8_t arrReserved[3];
+        uint32_t uData;
+    };
+
+    struct BinaryString {
+        uint64_t uHash;
+        uint32_t uLength;
+        uint32_t uReserved;
+    };
+
+    struct BinaryEntry {
+        uint64_t uKeyHash;
+        uint32_t uKeyOffset;
+        uint32_t uReserved;
+        BinarySlot slot;
+    };
+
+    struct BinaryObject {
+        uint32_t uCount;
+        uint32_t uReserved;
+    };
+
+    // packed lists store Int and Float elements in 4 bytes and Bool elements in a single byte
+    struct BinaryList {
+        uint32_t uCount;
+        uint32_t uPackedType;
+    };
+
+    static_assert(sizeof(BinaryHeader) == 16 && sizeof(BinarySlot) == 8 && sizeof(BinaryString) == 16 &&
+                  sizeof(BinaryEntry) == 24 && sizeof(BinaryObject) == 8 && sizeof(BinaryList) == 8,
+                  "Binary image blocks must not contain padding");
+}
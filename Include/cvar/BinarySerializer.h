@@ -0,0 +1,40 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: BinarySerializer.h - binary CVar image serializer class header
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <cvar/Api.h>
+#include <cvar/BinaryFormat.h>
+#include <cvar/ISerializer.h>
+
+namespace cvar {
+
+    // BinarySerializer writes the tree as a binary image (see BinaryFormat.h) that can be loaded with
+    // BinaryUnserializer or mapped and read in place with MappedConfig. Images are limited to 4 GiB.
+    class CVAR_API BinarySerializer : public ISerializer<ObjectMap> {
+        private:
+            std::vector<char> m_image;
+            // offsets of written keys, keyed by the address of the interned key text
+            std::unordered_map<const std::string*, uint32_t> m_keys;
+            // pair specification:
+            // first - offset of the slot that refers to the block
+            // second - list or object whose block hasn't been written yet
+            std::vector<std::pair<size_t, const Value*>> m_pending;
+
+        private:
+            uint32_t _Allocate(size_t _uSize);
+            uint32_t _WriteString(std::string_view _sText, hash_t _hshText);
+            BinarySlot _MakeSlot(const Value& _val, size_t _uSlotOffset);
+            uint32_t _WriteObject(const ObjectMap& _contents);
+            uint32_t _WriteList(const List& _list);
+
+        public:
+            BinarySerializer(std::ostream& _stream, ObjectMap& _root);
+            // images have only one representation, thus _bBeautified is ignored
+            virtual void Serialize(bool _bBeautified = true) override;
+    };
+}
@@ -0,0 +1,22 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: BinaryUnserializer.h - binary CVar image unserializer class header
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cvar/Api.h>
+#include <cvar/ISerializer.h>
+
+namespace cvar {
+
+    // BinaryUnserializer reads the whole image with a single read and builds the tree from it. Keys and strings
+    // are created with their stored hashes and packed lists are copied as whole arrays, thus nothing is parsed.
+    class CVAR_API BinaryUnserializer : public IUnserializer<ObjectMap> {
+        private:
+            void _Load();
+
+        public:
+            BinaryUnserializer(std::istream& _stream);
+    };
+}
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <cstring>
 #include <istream>
 #include <ostream>
 #include <cvar/Api.h>
@@ -30,7 +31,7 @@ namespace cvar {
 					return false;
 
 				// check if the last character should be the first one
-				if (m_uBufCounter && m_uBufDataAvail - m_uBufCounter <= 1) {
+				if (m_uBufCounter && m_uBufCounter < m_uBufDataAvail && m_uBufDataAvail - m_uBufCounter == 1) {
 					m_arrData[0] = m_arrData[m_uBufDataAvail - 1];
 					if (m_uStreamDataAvail >= N-1) {
 						m_stream.read(m_arrData + 1, N - 1);
@@ -39,7 +40,7 @@ namespace cvar {
 					}
 					else {
 						m_stream.read(m_arrData + 1, m_uStreamDataAvail);
-						m_uBufDataAvail = m_uStreamDataAvail;
+						m_uBufDataAvail = m_uStreamDataAvail + 1;
 						m_uStreamDataAvail = 0;
 					}
 				}
@@ -78,11 +79,12 @@ namespace cvar {
 			}
 
 			inline char peek() {
-				if (m_uBufCounter >= m_uBufDataAvail - 1) {
-					if (!_ReadBuf())
-						return -1;
-				}
+				if (m_uBufCounter + 1 >= m_uBufDataAvail)
+					_ReadBuf();
 
+				// last buffered character is still available even if the stream itself is exhausted
+				if (m_uBufCounter >= m_uBufDataAvail)
+					return -1;
 				return m_arrData[m_uBufCounter];
 			}
 
@@ -95,8 +97,35 @@ namespace cvar {
 				return m_arrData[m_uBufCounter++];
 			}
 
+			// read up to _uLen bytes, returns the number of bytes read
+			inline size_t read(char* _pData, size_t _uLen) {
+				size_t uRead = 0;
+				while (uRead < _uLen) {
+					if (m_uBufCounter >= m_uBufDataAvail && !_ReadBuf())
+						break;
+
+					const size_t uAvail = m_uBufDataAvail - m_uBufCounter;
+					const size_t uCount = _uLen - uRead < uAvail ? _uLen - uRead : uAvail;
+					std::memcpy(_pData + uRead, m_arrData + m_uBufCounter, uCount);
+					m_uBufCounter += uCount;
+					uRead += uCount;
+				}
+
+				return uRead;
+			}
+
+			// restart reading from the beginning of the stream
+			inline void rewind() {
+				m_stream.clear();
+				m_stream.seekg(0, std::ios_base::beg);
+				m_uStreamDataAvail = m_uStreamLen;
+				m_uBufDataAvail = 0;
+				m_uBufCounter = 0;
+				_ReadBuf();
+			}
+
 			inline bool eof() {
-				return !m_uStreamDataAvail;
+				return !m_uStreamDataAvail && m_uBufCounter >= m_uBufDataAvail;
 			}
 	};
 }
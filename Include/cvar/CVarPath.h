@@ -0,0 +1,66 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: CVarPath.h - compile time hashed CVar path definitions
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <string_view>
+#include <cvar/SID.h>
+
+namespace cvar {
+
+    // CVarPath stores a dotted variable key that has been split into segments and hashed at compile time.
+    // Segment hashes are equal to the hashes computed by RUNTIME_CRC, thus they can be used directly for
+    // looking up String keys.
+    template <size_t N>
+    struct CVarPath {
+        static constexpr size_t uCount = N;
+        hash_t arrHashes[N > 0 ? N : 1]{};
+        std::string_view arrSegments[N > 0 ? N : 1]{};
+        std::string_view sPath;
+        hash_t hshPath = 0;
+    };
+
+    constexpr size_t CountPathSegments(const char* _szPath, size_t _uLen) {
+        size_t uCount = 0;
+        size_t uBeginPos = 0;
+        for (size_t i = 0; i < _uLen; i++) {
+            if (_szPath[i] == '.') {
+                uCount++;
+                uBeginPos = i + 1;
+            }
+        }
+
+        // trailing delimiter does not create a new segment
+        if (uBeginPos != _uLen)
+            uCount++;
+        return uCount;
+    }
+
+    template <size_t N>
+    constexpr CVarPath<N> MakePath(const char* _szPath, size_t _uLen) {
+        CVarPath<N> path;
+        path.sPath = std::string_view(_szPath, _uLen);
+        path.hshPath = static_cast<hash_t>(CONSTEXPR_CRC(_szPath, _uLen));
+
+        size_t uSegment = 0;
+        size_t uBeginPos = 0;
+        for (size_t i = 0; i <= _uLen && uSegment < N; i++) {
+            if (i == _uLen || _szPath[i] == '.') {
+                path.arrSegments[uSegment] = std::string_view(_szPath + uBeginPos, i - uBeginPos);
+                path.arrHashes[uSegment] = static_cast<hash_t>(CONSTEXPR_CRC(_szPath + uBeginPos, i - uBeginPos));
+                uSegment++;
+                uBeginPos = i + 1;
+            }
+        }
+
+        return path;
+    }
+}
+
+// evaluates to a const reference to statically stored CVarPath object
+#define CVAR_PATH(x) ([]() -> const auto& {\
+    static constexpr auto path = cvar::MakePath<cvar::CountPathSegments(x, sizeof(x) - 1)>(x, sizeof(x) - 1);\
+    return path;\
+}())
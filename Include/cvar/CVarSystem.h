@@ -7,43 +7,449 @@
 
 #include <cvar/Api.h>
 #include <cvar/CVarTypes.h>
+#include <cvar/CVarPath.h>
+#include <cvar/PathIndex.h>
+#include <cvar/SerializationCache.h>
+#include <cvar/Snapshot.h>
+#include <cvar/AtomicCVar.h>
+#include <cvar/StaticCVar.h>
+#include <cvar/Stats.h>
+#include <cvar/TreeVisitor.h>
+#include <atomic>
+#include <deque>
 #include <fstream>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
 
 namespace cvar {
 
+    template <typename T>
+    class CVarHandle;
+
+    typedef uint32_t SubscriptionId;
+    typedef std::function<void(const std::string& _sKey, const Value* _pValue)> ChangeCallback;
+
+    enum class NotifyMode {
+        Immediate,  // callback is invoked from within the write
+        Deferred    // changes are coalesced per key and delivered by CVarSystem::DispatchNotifications()
+    };
+
+    struct Subscription {
+        SubscriptionId uId;
+        NotifyMode mode;
+        std::string sPrefix;
+        ChangeCallback callback;
+        // cleared by Unsubscribe(), notifications that are already being delivered skip inactive subscriptions
+        bool bActive = true;
+    };
+
+
+    // CVarBatch collects variable writes that are applied with CVarSystem::Apply() as a single unit
+    class CVarBatch {
+        friend class CVarSystem;
+
+        private:
+            std::vector<std::string> m_keys;
+            std::vector<Value> m_values;
+
+        public:
+            CVarBatch() = default;
+
+            template <typename T>
+            inline void Set(const std::string& _key, const T& _val) {
+                m_keys.push_back(_key);
+                m_values.emplace_back(std::in_place_type<T>, _val);
+            }
+
+            template <typename T, typename = std::enable_if_t<!std::is_lvalue_reference_v<T>>>
+            inline void Set(const std::string& _key, T&& _val) {
+                m_keys.push_back(_key);
+                m_values.emplace_back(std::in_place_type<T>, std::move(_val));
+            }
+
+            inline void Reserve(size_t _uCount) {
+                m_keys.reserve(_uCount);
+                m_values.reserve(_uCount);
+            }
+
+            inline size_t Size() const {
+                return m_keys.size();
+            }
+
+            inline void Clear() {
+                m_keys.clear();
+                m_values.clear();
+            }
+    };
+
     class CVAR_API CVarSystem {
+        template <typename T>
+        friend class CVarHandle;
+        friend class StaticCVarBase;
+
         private:
-            std::unordered_map<String, Value> m_root;
+            // root object is shared with published snapshots, objects that are referenced by more than
+            // the tree itself are copied before modification
+            std::shared_ptr<Object> m_pRoot = std::make_shared<Object>();
+            bool m_bArenaAllocation = false;
+
+            // flat index from the hash of a full dotted path to its node, this allows deep keys to be
+            // looked up with a single probe. The path is compared on every hit, thus a path whose hash
+            // collides with an indexed one is resolved by walking the tree.
+            struct _IndexEntry {
+                Value* pNode;
+                std::string sPath;
+            };
+            std::unordered_map<hash_t, _IndexEntry, NoHash> m_flatIndex;
+
+            // sorted index of full paths for prefix, glob and completion queries, maintained only when enabled
+            bool m_bPathIndexing = false;
+            PathIndex m_pathIndex;
+
+            // text of the last incremental save and the keys written since then, allocated by the first
+            // incremental save
+            std::unique_ptr<SerializationCache> m_pSaveCache;
+            std::unordered_set<std::string> m_dirtyKeys;
+
+            // generation is incremented whenever previously resolved nodes might have been destroyed,
+            // revision is incremented whenever new nodes are inserted into the tree
+            uint64_t m_uGeneration = 0;
+            uint64_t m_uRevision = 0;
+            // share epoch is incremented whenever the current tree becomes shared with a snapshot, nodes
+            // resolved before that must be detached before they can be modified in place
+            uint64_t m_uShareEpoch = 0;
+
+            // snapshot publication state
+            bool m_bPublishSnapshots = false;
+            std::shared_ptr<const Object> m_pPublished;
+            std::atomic<uint64_t> m_uPublishedVersion{0};
+            // recursive since change callbacks are allowed to write variables
+            std::recursive_mutex m_mtxWriter;
+
+            // atomic storage for scalar variables, deque is used since slot addresses must remain stable.
+            // Slots are keyed by the hash of their path, thus colliding paths share a bucket and the key is
+            // compared on every hit.
+            std::deque<AtomicSlot> m_atomicSlots;
+            std::unordered_multimap<hash_t, AtomicSlot*, NoHash> m_atomicIndex;
+
+            // statically defined variables, keyed by the hash of their path. Colliding paths share a bucket
+            // and the key is compared on every hit, a second definition of the same key is rejected.
+            std::unordered_multimap<hash_t, StaticCVarBase*, NoHash> m_staticIndex;
+
+            // subscriptions are keyed by the hash of the subscribed path or prefix, the prefix itself is compared
+            // on every hit. Subscriptions are shared with notifications that are being delivered, since callbacks
+            // are allowed to subscribe and unsubscribe.
+            std::unordered_map<hash_t, std::vector<std::shared_ptr<Subscription>>, NoHash> m_subscriptions;
+            std::unordered_set<std::string> m_pendingChanges;
+            SubscriptionId m_uNextSubscriptionId = 0;
 
         private:
             CVarSystem() = default;
-            std::vector<String> _HashKeyWords(const std::string& _key);
             Value* _FindNode(const std::string& _key);
+            Value* _FindNode(const hash_t* _pHashes, const std::string_view* _pSegments, size_t _uCount, hash_t _hshPath, std::string_view _sPath);
+            Value* _FindWritableNode(const std::string& _key);
+            Value* _FindOrCreateNode(std::string_view _sKey);
+            Value* _FindOrCreateNode(const hash_t* _pHashes, const std::string_view* _pSegments, size_t _uCount);
+            bool _WalkBatch(const std::string* _pKeys, const std::vector<size_t>& _order, bool _bCreate, Value** _ppNodes, hash_t* _pHashes);
+            void _RebuildIndex();
+            void _IndexPath(const std::string_view* _pSegments, size_t _uCount);
+            void _Publish();
+            AtomicSlot* _FindAtomicSlot(hash_t _hshPath, std::string_view _sKey);
+            void _StoreAtomic(hash_t _hshPath, std::string_view _sKey, const Value& _val);
+            bool _SyncAtomic(const AtomicSlot& _slot);
+            void _SyncAtomic(hash_t _hshPath, std::string_view _sKey);
+            void _ReloadAtomics();
+            StaticCVarBase* _FindStatic(hash_t _hshPath, std::string_view _sKey);
+            bool _RegisterStatic(StaticCVarBase* _pStatic);
+            void _UnregisterStatic(StaticCVarBase* _pStatic);
+            bool _WriteStatic(StaticCVarBase* _pStatic, Value&& _val);
+            void _StoreStatic(hash_t _hshPath, std::string_view _sKey, Value& _val);
+            void _ReloadStatic(StaticCVarBase* _pStatic);
+            void _ReloadStatics();
+            void _NotifySubscribers(std::string_view _sKey, const Value* _pValue, NotifyMode _mode);
+            void _NotifyReload();
+
+            // called whenever the value of an existing or a new leaf node is written, statically defined
+            // variables might convert or clamp the written value in place
+            inline void _OnWrite(hash_t _hshPath, std::string_view _sKey, Value& _val) {
+                if (!m_staticIndex.empty())
+                    _StoreStatic(_hshPath, _sKey, _val);
+                if (!m_atomicIndex.empty())
+                    _StoreAtomic(_hshPath, _sKey, _val);
+                if (m_pSaveCache)
+                    m_dirtyKeys.emplace(_sKey);
+                if (m_bPathIndexing && std::holds_alternative<std::shared_ptr<Object>>(_val)) {
+                    m_pathIndex.EraseDescendants(_sKey);
+                    m_pathIndex.InsertDescendants(_sKey, std::get<std::shared_ptr<Object>>(_val)->GetContents());
+                }
+                if (!m_subscriptions.empty())
+                    _NotifySubscribers(_sKey, &_val, NotifyMode::Immediate);
+            }
+
+            // writers are serialized only when snapshots are published, otherwise CVarSystem is single threaded
+            inline std::unique_lock<std::recursive_mutex> _LockWriter() {
+                if (m_bPublishSnapshots)
+                    return std::unique_lock<std::recursive_mutex>(m_mtxWriter);
+                return std::unique_lock<std::recursive_mutex>();
+            }
+
+            // make sure that the object is not shared with any snapshot before it gets modified
+            inline Object* _Detach(std::shared_ptr<Object>& _pObject) {
+                if (_pObject.use_count() > 1) {
+                    _pObject = std::make_shared<Object>(*_pObject);
+                    // previously resolved nodes now belong to a snapshot
+                    m_uGeneration++;
+                    m_flatIndex.clear();
+                }
+                else {
+                    // synchronize with the release of the last snapshot reference
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                }
+
+                return _pObject.get();
+            }
+
+            // previously resolved nodes might have been destroyed
+            inline void _InvalidateResolved() {
+                m_uGeneration++;
+                m_flatIndex.clear();
+            }
+
+            // the object at _sKey is about to be overwritten, which destroys all nodes below it
+            inline void _OnReplaceObject(std::string_view _sKey) {
+                _InvalidateResolved();
+                if (m_bPathIndexing)
+                    m_pathIndex.EraseDescendants(_sKey);
+            }
+
+            inline void _IndexNode(hash_t _hshPath, std::string_view _sPath, Value* _pNode) {
+                _IndexEntry& entry = m_flatIndex[_hshPath];
+                entry.pNode = _pNode;
+                if (entry.sPath != _sPath)
+                    entry.sPath.assign(_sPath.data(), _sPath.size());
+            }
+
+            inline void _CommitWrite(hash_t _hshPath, std::string_view _sKey, Value* _pNode) {
+                _IndexNode(_hshPath, _sKey, _pNode);
+                _OnWrite(_hshPath, _sKey, *_pNode);
+                _Publish();
+            }
+
+            // overwrite the node, values of the same type are assigned to reuse their storage
+            template <typename T, typename U>
+            bool _Write(hash_t _hshPath, std::string_view _sKey, Value* _pNode, U&& _val) {
+                if (!_pNode)
+                    return false;
+
+                if (std::holds_alternative<std::shared_ptr<Object>>(*_pNode))
+                    _OnReplaceObject(_sKey);
+
+                if (T* pVal = std::get_if<T>(_pNode))
+                    *pVal = std::forward<U>(_val);
+                else _pNode->template emplace<T>(std::forward<U>(_val));
+
+                _CommitWrite(_hshPath, _sKey, _pNode);
+                return true;
+            }
+
+            template <typename T, typename... Args>
+            bool _Emplace(hash_t _hshPath, std::string_view _sKey, Value* _pNode, Args&&... _args) {
+                if (!_pNode)
+                    return false;
+
+                if (std::holds_alternative<std::shared_ptr<Object>>(*_pNode))
+                    _OnReplaceObject(_sKey);
+
+                _pNode->template emplace<T>(std::forward<Args>(_args)...);
+                _CommitWrite(_hshPath, _sKey, _pNode);
+                return true;
+            }
+
+            template <typename T>
+            bool _SetExisting(const std::string& _key, const T& _val) {
+                auto lock = _LockWriter();
+                Value* pValue = _FindWritableNode(_key);
+                T* pVal = pValue ? std::get_if<T>(pValue) : nullptr;
+                if (!pVal)
+                    return false;
+
+                *pVal = _val;
+                _OnWrite(RUNTIME_CRC(_key), _key, *pValue);
+                _Publish();
+                return true;
+            }
 
         public:
             static CVarSystem& GetInstance();
 
+            // files are opened in binary mode, since serializers may write binary images (e.g. BinarySerializer)
             template <typename T>
             void Serialize(const std::string& _sFileName, bool bBeautified = true) {
-                std::ofstream stream(_sFileName);
-                T serializer(stream, m_root);
+                SyncAtomics();
+                std::ofstream stream(_sFileName, std::ios::binary);
+                T serializer(stream, m_pRoot->GetContents());
                 serializer.Serialize(bBeautified);
                 stream.close();
             }
 
 
+            // serialize only objects that were written to since the previous incremental save, text of other objects
+            // is reused from the cache kept by CVarSystem. The serializer must support SerializationCache
+            // (e.g. JSONSerializer). Output is the same as from Serialize().
+            // NOTE: values modified through pointers returned by GetValue() are not tracked
+            template <typename T>
+            void SerializeIncremental(const std::string& _sFileName, bool bBeautified = true) {
+                auto lock = _LockWriter();
+                SyncAtomics();
+                if (!m_pSaveCache)
+                    m_pSaveCache = std::make_unique<SerializationCache>();
+
+                for (auto it = m_dirtyKeys.begin(); it != m_dirtyKeys.end(); it++)
+                    m_pSaveCache->MarkDirty(*it);
+                m_dirtyKeys.clear();
+
+                std::ofstream stream(_sFileName, std::ios::binary);
+                T serializer(stream, m_pRoot->GetContents());
+                serializer.Serialize(bBeautified, *m_pSaveCache);
+            }
+
+            // release the text cached by incremental saves
+            inline void ClearSerializationCache() {
+                auto lock = _LockWriter();
+                m_pSaveCache.reset();
+                m_dirtyKeys.clear();
+            }
+
             template <typename T>
             void Unserialize(const std::string& _sFileName) {
-                std::ifstream stream(_sFileName);
+                std::ifstream stream(_sFileName, std::ios::binary);
+                // every loaded tree gets its own arena, which is released as a whole once the last node is gone
+                std::shared_ptr<Arena> pArena = m_bArenaAllocation ? std::make_shared<Arena>() : nullptr;
+                ArenaScope scope(pArena);
                 T unserializer(stream);
-                m_root = std::move(unserializer.Get());
+
+                {
+                    auto lock = _LockWriter();
+                    m_pRoot = std::make_shared<Object>(std::move(unserializer.Get()));
+                    m_uGeneration++;
+                    m_uRevision++;
+                    _RebuildIndex();
+                    _Publish();
+                }
+
+                _ReloadStatics();
+                _ReloadAtomics();
+                _NotifyReload();
             }
 
+            // NOTE: if nodes are removed or replaced through the root reference, Reindex() must be called afterwards.
+            // When snapshots are published, the tree must only be modified through Set().
             inline auto& GetRoot() {
-                return m_root;
+                return m_pRoot->GetContents();
+            }
+
+            inline void Reindex() {
+                m_uGeneration++;
+                _RebuildIndex();
+            }
+
+            // when enabled, full paths of all nodes are kept in a sorted index that answers FindPaths() and
+            // CompletePath() queries. Every write that creates or removes nodes also updates the index.
+            void SetPathIndexing(bool _bEnable);
+
+            inline bool IsPathIndexing() const {
+                return m_bPathIndexing;
+            }
+
+            inline const PathIndex& GetPathIndex() const {
+                return m_pathIndex;
+            }
+
+            // paths matching a glob pattern such as "render.*.enabled" or "net.**", see PathIndex::FindGlob()
+            inline std::vector<std::string> FindPaths(std::string_view _sPattern, size_t _uMax = SIZE_MAX) {
+                auto lock = _LockWriter();
+                return m_pathIndex.FindGlob(_sPattern, _uMax);
+            }
+
+            // candidates for the last partially typed segment of _sPartial, see PathIndex::Complete()
+            inline std::vector<std::string> CompletePath(std::string_view _sPartial, size_t _uMax = SIZE_MAX) {
+                auto lock = _LockWriter();
+                return m_pathIndex.Complete(_sPartial, _uMax);
+            }
+
+            inline uint64_t GetGeneration() const {
+                return m_uGeneration;
+            }
+
+            inline uint64_t GetRevision() const {
+                return m_uRevision;
+            }
+
+            inline uint64_t GetShareEpoch() const {
+                return m_uShareEpoch;
+            }
+
+            // checkpoint the current tree in O(1), nodes are shared with the live tree and subsequent writes
+            // copy only the objects on the path to the modified node.
+            // NOTE: while a snapshot is alive, values must only be modified through Set(), Apply() or handles.
+            inline Snapshot TakeSnapshot() {
+                auto lock = _LockWriter();
+                SyncAtomics();
+                m_uShareEpoch++;
+                return Snapshot(m_pRoot);
+            }
+
+            // roll the tree back to a previously taken snapshot, the snapshot itself stays unmodified
+            void Restore(const Snapshot& _snapshot);
+
+            // when enabled, trees loaded by Unserialize() are allocated from an arena. Objects and lists created or
+            // copied by later writes use the heap, but loaded objects and lists keep allocating from the arena when
+            // keys or items are added to them. Arena memory is only reclaimed once the whole tree is gone.
+            inline void SetArenaAllocation(bool _bEnable) {
+                m_bArenaAllocation = _bEnable;
+            }
+
+            inline bool IsArenaAllocating() const {
+                return m_bArenaAllocation;
+            }
+
+            // when enabled, every write publishes a new immutable snapshot of the tree that can be read from any thread
+            void SetSnapshotPublishing(bool _bEnable);
+
+            inline bool IsPublishingSnapshots() const {
+                return m_bPublishSnapshots;
+            }
+
+            // visit every node under _sPrefix with its full dotted path, see cvar::ForEach()
+            // NOTE: the visitor must not modify the tree
+            template <typename Visitor>
+            inline void ForEach(const std::string& _sPrefix, Visitor&& _visitor) {
+                auto lock = _LockWriter();
+                SyncAtomics();
+                cvar::ForEach(m_pRoot->GetContents(), _sPrefix, std::forward<Visitor>(_visitor));
+            }
+
+            // count nodes and account the memory used by the subtree at _sPrefix, empty prefix selects the whole tree.
+            // Use a sample interval for periodic budget checks or call Snapshot::Stats() from another thread.
+            inline TreeStats Stats(const std::string& _sPrefix = "", const StatsOptions& _options = StatsOptions()) {
+                auto lock = _LockWriter();
+                SyncAtomics();
+                return CollectStats(m_pRoot->GetContents(), _sPrefix, _options);
+            }
+
+            // returns the most recently published snapshot, empty if publishing is disabled
+            inline Snapshot AcquireSnapshot() const {
+                return Snapshot(std::atomic_load(&m_pPublished));
+            }
+
+            inline uint64_t GetPublishedVersion() const {
+                return m_uPublishedVersion.load(std::memory_order_acquire);
             }
 
             inline Value* GetValue(const std::string& _key) {
+                if (!m_atomicIndex.empty())
+                    _SyncAtomic(RUNTIME_CRC(_key), _key);
                 Value* pDesc = _FindNode(_key);
                 if (pDesc)
                     return pDesc;
@@ -52,29 +458,245 @@ namespace cvar {
 
             template <typename T>
             inline T* Get(const std::string& _key) {
+                if (!m_atomicIndex.empty())
+                    _SyncAtomic(RUNTIME_CRC(_key), _key);
                 Value* pDesc = _FindNode(_key);
                 if (pDesc)
                     return std::get_if<T>(pDesc);
                 return nullptr;
             }
 
+            template <size_t N>
+            inline Value* GetValue(const CVarPath<N>& _path) {
+                if (!m_atomicIndex.empty())
+                    _SyncAtomic(_path.hshPath, _path.sPath);
+                return _FindNode(_path.arrHashes, _path.arrSegments, N, _path.hshPath, _path.sPath);
+            }
+
+            template <typename T, size_t N>
+            inline T* Get(const CVarPath<N>& _path) {
+                if (!m_atomicIndex.empty())
+                    _SyncAtomic(_path.hshPath, _path.sPath);
+                Value* pDesc = _FindNode(_path.arrHashes, _path.arrSegments, N, _path.hshPath, _path.sPath);
+                if (pDesc)
+                    return std::get_if<T>(pDesc);
+                return nullptr;
+            }
+
+            // move the variable into atomic storage, if the variable doesn't exist it gets created with default value
+            // returns an invalid AtomicCVar if the variable exists but has a different type
+            template <typename T>
+            AtomicCVar<T> MakeAtomic(const std::string& _key) {
+                auto lock = _LockWriter();
+                const hash_t hshPath = RUNTIME_CRC(_key);
+                if (AtomicSlot* pSlot = _FindAtomicSlot(hshPath, _key))
+                    return pSlot->type == AtomicTraits<T>::type ? AtomicCVar<T>(pSlot) : AtomicCVar<T>();
+
+                if (!GetValue(_key) && !Set<T>(_key, T()))
+                    return AtomicCVar<T>();
+
+                T* pVal = Get<T>(_key);
+                if (!pVal)
+                    return AtomicCVar<T>();
+
+                AtomicSlot& slot = m_atomicSlots.emplace_back(_key, AtomicTraits<T>::type, ToAtomicBits(*pVal));
+                m_atomicIndex.emplace(hshPath, &slot);
+                return AtomicCVar<T>(&slot);
+            }
+
+            // write values stored through AtomicCVar handles back into the variable tree. Get(), handles, Stats(),
+            // ForEach(), TakeSnapshot() and serialization do this implicitly, published snapshots only see
+            // atomic stores once one of these has been called on the writer thread.
+            void SyncAtomics();
+
+            // subscribe to changes of a variable or of any variable under given prefix, empty prefix matches everything
+            SubscriptionId Subscribe(const std::string& _sPrefix, const ChangeCallback& _callback, NotifyMode _mode = NotifyMode::Immediate);
+            void Unsubscribe(SubscriptionId _uId);
+
+            // deliver all coalesced changes to deferred subscribers
+            void DispatchNotifications();
+
+            // resolve the node once and return a handle that can be used for O(1) reads and writes
+            template <typename T>
+            inline CVarHandle<T> Resolve(const std::string& _key) {
+                return CVarHandle<T>(this, _key);
+            }
+
+            // Set() overwrites existing values and creates missing parent objects, false is returned if some
+            // parent node exists but isn't an object
             template <typename T>
             bool Set(const String& _key, const T& _val) {
-                std::vector<String> cvarStrings = _HashKeyWords(_key);
-                std::unordered_map<String, Value>* pTable = &m_root;
-
-                for (size_t i = 0; i < cvarStrings.size() - 1; i++) {
-                    if (pTable->find(cvarStrings[i]) == pTable->end()) {
-                        pTable->insert(std::make_pair(cvarStrings[i], std::make_shared<Object>()));
-                    }
-                    auto pObject = std::get_if<std::shared_ptr<Object>>(&pTable->find(cvarStrings[i])->second);
-                    if (!pObject) 
+                auto lock = _LockWriter();
+                const std::string_view sKey = _key.GetView();
+                return _Write<T>(_key.GetHash(), sKey, _FindOrCreateNode(sKey), _val);
+            }
+
+            // rvalue variant, large String and List payloads are moved into the node
+            template <typename T, typename = std::enable_if_t<!std::is_lvalue_reference_v<T>>>
+            bool Set(const String& _key, T&& _val) {
+                auto lock = _LockWriter();
+                const std::string_view sKey = _key.GetView();
+                return _Write<T>(_key.GetHash(), sKey, _FindOrCreateNode(sKey), std::move(_val));
+            }
+
+            // construct the value of type T directly inside the node
+            template <typename T, typename... Args>
+            bool Emplace(const String& _key, Args&&... _args) {
+                auto lock = _LockWriter();
+                const std::string_view sKey = _key.GetView();
+                return _Emplace<T>(_key.GetHash(), sKey, _FindOrCreateNode(sKey), std::forward<Args>(_args)...);
+            }
+
+            // look up multiple variables at once, keys are sorted so that shared prefixes are walked only once
+            // _ppValues must have room for _uCount pointers, missing variables are set to nullptr
+            void GetBatch(const std::string* _pKeys, size_t _uCount, Value** _ppValues);
+
+            inline std::vector<Value*> GetBatch(const std::vector<std::string>& _keys) {
+                std::vector<Value*> values(_keys.size());
+                GetBatch(_keys.data(), _keys.size(), values.data());
+                return values;
+            }
+
+            // apply all batch writes as a single unit: either all variables are written or, if some key conflicts
+            // with an existing non-object node or with another key in the batch, none of them are
+            bool Apply(CVarBatch&& _batch);
+
+            // compile time hashed path variants, string keys are only constructed for newly created nodes
+            template <typename T, size_t N>
+            bool Set(const CVarPath<N>& _path, const T& _val) {
+                static_assert(N > 0, "CVar path must contain at least one segment");
+                auto lock = _LockWriter();
+                return _Write<T>(_path.hshPath, _path.sPath, _FindOrCreateNode(_path.arrHashes, _path.arrSegments, N), _val);
+            }
+
+            template <typename T, size_t N, typename = std::enable_if_t<!std::is_lvalue_reference_v<T>>>
+            bool Set(const CVarPath<N>& _path, T&& _val) {
+                static_assert(N > 0, "CVar path must contain at least one segment");
+                auto lock = _LockWriter();
+                return _Write<T>(_path.hshPath, _path.sPath, _FindOrCreateNode(_path.arrHashes, _path.arrSegments, N), std::move(_val));
+            }
+
+            template <typename T, size_t N, typename... Args>
+            bool Emplace(const CVarPath<N>& _path, Args&&... _args) {
+                static_assert(N > 0, "CVar path must contain at least one segment");
+                auto lock = _LockWriter();
+                return _Emplace<T>(_path.hshPath, _path.sPath, _FindOrCreateNode(_path.arrHashes, _path.arrSegments, N), std::forward<Args>(_args)...);
+            }
+    };
+
+
+    // CVarHandle keeps a pointer to the resolved node and only looks the key up again if the tree
+    // has been structurally modified since the last resolve. Node type is verified on every access,
+    // thus a handle to a node whose type has changed yields nullptr instead of a wrong value.
+    template <typename T>
+    class CVarHandle {
+        private:
+            CVarSystem* m_pSystem = nullptr;
+            std::string m_sKey;
+            hash_t m_hshPath = 0;
+            Value* m_pValue = nullptr;
+            uint64_t m_uGeneration = 0;
+            uint64_t m_uRevision = 0;
+            uint64_t m_uShareEpoch = 0;
+
+        private:
+            inline void _Resolve() {
+                m_pValue = m_pSystem->GetValue(m_sKey);
+                m_uGeneration = m_pSystem->GetGeneration();
+                m_uRevision = m_pSystem->GetRevision();
+            }
+
+            inline Value* _Validate() {
+                if (!m_pSystem)
+                    return nullptr;
+
+                // unresolved handles are retried only when something new was inserted
+                if (m_uGeneration != m_pSystem->GetGeneration() || (!m_pValue && m_uRevision != m_pSystem->GetRevision()))
+                    _Resolve();
+                return m_pValue;
+            }
+
+        public:
+            CVarHandle() = default;
+            CVarHandle(CVarSystem* _pSystem, const std::string& _key) :
+                m_pSystem(_pSystem),
+                m_sKey(_key),
+                m_hshPath(RUNTIME_CRC(_key))
+            {
+                _Resolve();
+            }
+
+            inline T* Get() {
+                // values stored through AtomicCVar handles are written into the leaf before it is read
+                if (m_pSystem && !m_pSystem->m_atomicIndex.empty())
+                    m_pSystem->_SyncAtomic(m_hshPath, m_sKey);
+                Value* pValue = _Validate();
+                if (pValue)
+                    return std::get_if<T>(pValue);
+                return nullptr;
+            }
+
+            inline bool Set(const T& _val) {
+                // published nodes must not be modified in place
+                if (m_pSystem && m_pSystem->IsPublishingSnapshots())
+                    return m_pSystem->_SetExisting(m_sKey, _val);
+
+                // the node might be shared with a snapshot taken after it was resolved, thus its path
+                // is detached once, after which the handle writes in place again
+                if (m_pSystem && m_uShareEpoch != m_pSystem->GetShareEpoch()) {
+                    if (!m_pSystem->_SetExisting(m_sKey, _val))
                         return false;
-                    pTable = &pObject->get()->GetContents();
+                    m_uShareEpoch = m_pSystem->GetShareEpoch();
+                    return true;
                 }
 
-                pTable->insert(std::make_pair(cvarStrings.back(), _val));
+                T* pVal = Get();
+                if (!pVal)
+                    return false;
+                *pVal = _val;
+                m_pSystem->_OnWrite(m_hshPath, m_sKey, *m_pValue);
                 return true;
             }
+
+            inline bool IsValid() {
+                return Get() != nullptr;
+            }
+
+            inline explicit operator bool() {
+                return IsValid();
+            }
+
+            inline const std::string& GetKey() const {
+                return m_sKey;
+            }
+    };
+
+
+    // SnapshotReader caches the acquired snapshot and only reacquires it when a newer version has been
+    // published. Reading an unchanged snapshot costs a single atomic load, which is why each reader thread
+    // should keep its own SnapshotReader instance.
+    class SnapshotReader {
+        private:
+            const CVarSystem& m_system;
+            Snapshot m_snapshot;
+            uint64_t m_uVersion = 0;
+
+        public:
+            SnapshotReader(const CVarSystem& _system = CVarSystem::GetInstance()) :
+                m_system(_system) {}
+
+            inline const Snapshot& Get() {
+                const uint64_t uVersion = m_system.GetPublishedVersion();
+                if (uVersion != m_uVersion || !m_snapshot) {
+                    m_snapshot = m_system.AcquireSnapshot();
+                    m_uVersion = uVersion;
+                }
+
+                return m_snapshot;
+            }
+
+            inline const Snapshot* operator->() {
+                return &Get();
+            }
     };
 }
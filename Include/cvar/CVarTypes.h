@@ -5,61 +5,234 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstring>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
-#include <unordered_map>
 #include <memory>
+#include <cvar/Api.h>
+#include <cvar/Arena.h>
+#include <cvar/OrderedMap.h>
 #include <cvar/SID.h>
 
 namespace cvar {
 
-    class String {
+    // String is a compact immutable string of pointer size. Text that fits into the String itself is stored
+    // inline, longer text is kept in a reference counted block together with its hash, thus copies never allocate.
+    class CVAR_API String {
         private:
-            std::string m_string;
-            hash_t m_hshString = 0;  
+            struct _Block {
+                _Block(size_t _uLength, hash_t _hshText) :
+                    uRefCount(1),
+                    uLength(_uLength),
+                    hshText(_hshText) {}
+
+                std::atomic<size_t> uRefCount;
+                size_t uLength;
+                hash_t hshText;
+                // followed by uLength characters and a null terminator
+            };
+
+            // inline text is tagged by the lowest bit of the first byte, which is always zero for a block pointer
+            // on little endian targets. The remaining bytes hold the text.
+#if defined(_WIN32) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+            static constexpr size_t s_uInlineCapacity = sizeof(void*) - 1;
+#else
+            static constexpr size_t s_uInlineCapacity = 0;
+#endif
+
+            alignas(void*) unsigned char m_arrData[sizeof(void*)] = {};
+
+        private:
+            inline bool _IsInline() const {
+                return s_uInlineCapacity && (m_arrData[0] & 1);
+            }
+
+            inline _Block* _GetBlock() const {
+                _Block* pBlock;
+                std::memcpy(&pBlock, m_arrData, sizeof(pBlock));
+                return pBlock;
+            }
+
+            inline void _Retain() const {
+                if (_IsInline())
+                    return;
+                if (_Block* pBlock = _GetBlock())
+                    pBlock->uRefCount.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            void _Assign(std::string_view _sText, hash_t _hshText);
+            void _Release();
 
         public:
             String() = default;
-            String(const std::string& _str) :
-                m_string(_str),
-                m_hshString(RUNTIME_CRC(m_string)) {}
-            String(const char* _szString) :
-                m_string(_szString),
-                m_hshString(RUNTIME_CRC(m_string)) {}
-            String(const String&) = default;
-            String(String&&) = default;
-
-            operator std::string&() { return m_string; }
-            operator const std::string& () const { return m_string; }
+            String(const std::string& _str) {
+                _Assign(_str, RUNTIME_CRC(_str));
+            }
+            String(const char* _szString) {
+                const std::string_view sText(_szString);
+                _Assign(sText, RUNTIME_CRC_RANGE(sText.data(), sText.size()));
+            }
+            // construct a string whose hash value is already known (e.g. from CVarPath)
+            String(const std::string_view& _sv, hash_t _hsh) {
+                _Assign(_sv, _hsh);
+            }
+            String(const String& _str) {
+                std::memcpy(m_arrData, _str.m_arrData, sizeof(m_arrData));
+                _Retain();
+            }
+            String(String&& _str) noexcept {
+                std::memcpy(m_arrData, _str.m_arrData, sizeof(m_arrData));
+                std::memset(_str.m_arrData, 0, sizeof(_str.m_arrData));
+            }
+            ~String() {
+                _Release();
+            }
+
+            operator std::string() const { return GetSTDString(); }
 
+            // identical representations are equal, otherwise hashes are compared before the text
             inline bool operator==(const String& _str) const {
-                return m_hshString == _str.GetHash();
+                if (std::memcmp(m_arrData, _str.m_arrData, sizeof(m_arrData)) == 0)
+                    return true;
+                if (_IsInline() || _str._IsInline())
+                    return false;
+
+                const _Block* pFirst = _GetBlock();
+                const _Block* pSecond = _str._GetBlock();
+                return pFirst && pSecond && pFirst->hshText == pSecond->hshText && GetView() == _str.GetView();
+            }
+
+            inline bool operator!=(const String& _str) const {
+                return !(*this == _str);
             }
 
-            inline void operator=(const std::string& _str) {
-                m_string = _str;
-                m_hshString = RUNTIME_CRC(m_string);
+            inline String& operator=(const std::string& _str) {
+                return *this = String(_str);
             }
 
-            inline void operator=(const char* _szString) {
-                m_string = _szString;
-                m_hshString = RUNTIME_CRC(m_string);
+            inline String& operator=(const char* _szString) {
+                return *this = String(_szString);
             }
 
-            inline void operator=(const String& _str) {
-                m_string = _str.GetSTDString();
-                m_hshString = _str.GetHash();
+            inline String& operator=(const String& _str) {
+                if (this != &_str) {
+                    _str._Retain();
+                    _Release();
+                    std::memcpy(m_arrData, _str.m_arrData, sizeof(m_arrData));
+                }
+                return *this;
+            }
+
+            inline String& operator=(String&& _str) noexcept {
+                if (this != &_str) {
+                    _Release();
+                    std::memcpy(m_arrData, _str.m_arrData, sizeof(m_arrData));
+                    std::memset(_str.m_arrData, 0, sizeof(_str.m_arrData));
+                }
+                return *this;
             }
 
-            inline const std::string& GetSTDString() const { return m_string; }
-            inline const hash_t GetHash() const { return m_hshString; }
+            inline std::string_view GetView() const {
+                if (_IsInline())
+                    return std::string_view(reinterpret_cast<const char*>(m_arrData + 1), m_arrData[0] >> 1);
+
+                const _Block* pBlock = _GetBlock();
+                if (!pBlock)
+                    return std::string_view();
+                return std::string_view(reinterpret_cast<const char*>(pBlock + 1), pBlock->uLength);
+            }
+
+            inline std::string GetSTDString() const { return std::string(GetView()); }
+            inline size_t Size() const { return GetView().size(); }
+
+            // heap memory of the text block, inline and empty strings don't allocate. Blocks shared by copies
+            // are accounted by each copy.
+            inline size_t GetAllocatedBytes() const {
+                if (_IsInline())
+                    return 0;
+                const _Block* pBlock = _GetBlock();
+                return pBlock ? sizeof(_Block) + pBlock->uLength + 1 : 0;
+            }
+
+            // inline text is short enough to be hashed on demand
+            inline hash_t GetHash() const {
+                if (!_IsInline()) {
+                    if (const _Block* pBlock = _GetBlock())
+                        return pBlock->hshText;
+                }
+
+                const std::string_view sText = GetView();
+                return RUNTIME_CRC_RANGE(sText.data(), sText.size());
+            }
     };
 
     inline std::ostream& operator<<(std::ostream& _stream, const String& _str) {
-        _stream << _str.GetSTDString();
+        _stream << _str.GetView();
+        return _stream;
+    }
+
+
+    // interned key text, entries are never freed
+    struct SymbolEntry {
+        std::string sText;
+        hash_t hshText;
+    };
+
+    // Symbol is an interned object key. Each distinct key is stored only once in a global table, thus symbols
+    // are compared by their entry address, which is exact even if two keys have the same hash.
+    class CVAR_API Symbol {
+        private:
+            const SymbolEntry* m_pEntry;
+
+        private:
+            static const SymbolEntry* _Intern(std::string_view _sText, hash_t _hshText);
+
+        public:
+            Symbol();
+            Symbol(std::string_view _sText, hash_t _hshText) :
+                m_pEntry(_Intern(_sText, _hshText)) {}
+            Symbol(const std::string& _str) :
+                m_pEntry(_Intern(_str, RUNTIME_CRC(_str))) {}
+            Symbol(const char* _szString) :
+                Symbol(std::string(_szString)) {}
+            Symbol(const String& _str) :
+                m_pEntry(_Intern(_str.GetView(), _str.GetHash())) {}
+
+            inline bool operator==(const Symbol& _symbol) const {
+                return m_pEntry == _symbol.m_pEntry;
+            }
+
+            inline bool operator!=(const Symbol& _symbol) const {
+                return m_pEntry != _symbol.m_pEntry;
+            }
+
+            operator const std::string&() const { return m_pEntry->sText; }
+
+            inline const std::string& GetSTDString() const { return m_pEntry->sText; }
+            inline hash_t GetHash() const { return m_pEntry->hshText; }
+
+            // number of distinct keys that have been interned so far
+            static size_t GetInternedCount();
+    };
+
+    inline std::ostream& operator<<(std::ostream& _stream, const Symbol& _symbol) {
+        _stream << _symbol.GetSTDString();
         return _stream;
     }
+
+    // symbols are compared with each other by address, while lookups by plain text compare the key text
+    struct SymbolEqual {
+        inline bool operator()(const Symbol& _first, const Symbol& _second) const {
+            return _first == _second;
+        }
+
+        inline bool operator()(const Symbol& _symbol, std::string_view _sText) const {
+            return std::string_view(_symbol.GetSTDString()) == _sText;
+        }
+    };
 }
 
 // HACK: create std::hash<String> definitions so that the hash wouldn't get calculated
@@ -70,52 +243,354 @@ struct std::hash<cvar::String> {
     }
 };
 
+template <>
+struct std::hash<cvar::Symbol> {
+    inline std::size_t operator()(const cvar::Symbol& _symbol) const {
+        return _symbol.GetHash();
+    }
+};
+
 namespace cvar {
     typedef int32_t Int;
     typedef float Float;
     typedef bool Bool;
 
+    enum Type : size_t {
+        Type_None,
+        Type_Int,
+        Type_Float,
+        Type_Bool,
+        Type_String,
+        Type_List,
+        Type_Object
+    };
+
     class List;
     class Object;
-    typedef std::variant<std::monostate, Int, Float, Bool, String, std::shared_ptr<List>, std::shared_ptr<Object>> ListItem;
+    class ListIterator;
+
+    // every alternative is at most pointer sized except for the object reference, which is shared with snapshots
+    typedef std::variant<std::monostate, Int, Float, Bool, String, List, std::shared_ptr<Object>> Value;
+    // lists hold the same values as objects, nested lists are stored directly
+    typedef Value ListItem;
+
+    // scalar types that lists store in packed form
+    template <typename T>
+    struct PackedTraits {
+        static constexpr bool bSupported = false;
+    };
+
+    template <>
+    struct PackedTraits<Int> {
+        static constexpr bool bSupported = true;
+        static constexpr Type type = Type_Int;
+    };
+
+    template <>
+    struct PackedTraits<Float> {
+        static constexpr bool bSupported = true;
+        static constexpr Type type = Type_Float;
+    };
+
+    template <>
+    struct PackedTraits<Bool> {
+        static constexpr bool bSupported = true;
+        static constexpr Type type = Type_Bool;
+    };
+
+    // Span is a read-only view to contiguous list elements
+    template <typename T>
+    class Span {
+        private:
+            const T* m_pData = nullptr;
+            size_t m_uSize = 0;
+
+        public:
+            Span() = default;
+            Span(const T* _pData, size_t _uSize) :
+                m_pData(_pData),
+                m_uSize(_uSize) {}
+
+            inline const T* data() const { return m_pData; }
+            inline size_t size() const { return m_uSize; }
+            inline bool empty() const { return m_uSize == 0; }
+            inline const T* begin() const { return m_pData; }
+            inline const T* end() const { return m_pData + m_uSize; }
+            inline const T& operator[](size_t _uIndex) const { return m_pData[_uIndex]; }
+    };
+
+    // List is a pointer sized handle to its items. Storage is allocated from the arena that is current for the
+    // calling thread once the first item is added, copies are made in the current arena as well, while moved
+    // lists keep their memory.
+    // Lists whose elements are all Int, all Float or all Bool are packed into a contiguous array of that type,
+    // which can be read through GetSpan<T>(). Adding an element of another type unpacks the list.
+    class CVAR_API List {
+        friend class ListIterator;
+
+        private:
+            struct _Block;
+            _Block* m_pBlock = nullptr;
 
-    class List {
         private:
-            std::vector<ListItem> m_items;
+            _Block* _GetOrCreateBlock();
+            void _Release();
+            void _Push(ListItem&& _item);
+            void _Unpack();
+            void* _ReservePacked(Type _type, size_t _uCount);
 
         public:
             List() = default;
-            List(const List& _list) :
-                m_items(_list.m_items) {}
-            List(List&& _list) :
-                m_items(std::move(_list.m_items)) {}
-            List(std::initializer_list<ListItem> _initList) {
-                m_items.reserve(_initList.size());
-                for (auto it = _initList.begin(); it != _initList.end(); it++) {
-                    m_items.push_back(*it);
+            List(const List& _list);
+            List(List&& _list) noexcept :
+                m_pBlock(_list.m_pBlock)
+            {
+                _list.m_pBlock = nullptr;
+            }
+            List(std::initializer_list<ListItem> _initList);
+            // create a packed list from an array of scalars
+            template <typename T, typename = std::enable_if_t<PackedTraits<T>::bSupported>>
+            List(const T* _pData, size_t _uCount) {
+                if (_uCount)
+                    std::memcpy(_ReservePacked(PackedTraits<T>::type, _uCount), _pData, _uCount * sizeof(T));
+            }
+            ~List() {
+                _Release();
+            }
+
+            List& operator=(const List& _list);
+            List& operator=(List&& _list) noexcept {
+                if (this != &_list) {
+                    _Release();
+                    m_pBlock = _list.m_pBlock;
+                    _list.m_pBlock = nullptr;
                 }
+                return *this;
             }
 
             template <typename T>
-            inline void PushBack(const T& _val) { m_items.push_back(_val); }
-            inline std::size_t Size() const { return m_items.size(); }
-            inline auto Begin() const { return m_items.begin(); };
-            inline auto End() const { return m_items.end(); };
-            inline auto ReverseBegin() const { return m_items.rbegin(); }
-            inline auto ReverseEnd() const { return m_items.rend(); }
+            inline void PushBack(T&& _val) { _Push(ListItem(std::forward<T>(_val))); }
+            std::size_t Size() const;
+            // memory of the list block, element storage and packed array, excluding memory owned by elements
+            std::size_t GetAllocatedBytes() const;
+            ListIterator Begin() const;
+            ListIterator End() const;
+            ListIterator ReverseBegin() const;
+            ListIterator ReverseEnd() const;
+            // element at given index, packed elements are returned by value
+            ListItem At(size_t _uIndex) const;
+            // mutable access to the last element, packed lists are unpacked first
+            ListItem& Back();
+
+            // element type of packed lists, Type_None for mixed and empty lists
+            Type GetPackedType() const;
+
+            inline bool IsPacked() const {
+                return GetPackedType() != Type_None;
+            }
+
+            // contiguous elements of a list packed with type T, empty span otherwise
+            template <typename T>
+            Span<T> GetSpan() const;
+
+            // pack a mixed list whose elements share a scalar type, lists of Int and Float values are packed as
+            // Float if _bPromote is true. Returns true if the list is packed afterwards.
+            bool Pack(bool _bPromote = false);
     };
 
-    typedef std::variant<std::monostate, Int, Float, Bool, String, List, std::shared_ptr<Object>> Value;
+    // ListIterator walks both mixed and packed lists. Packed elements are materialized into the iterator,
+    // thus references obtained from a packed list are valid only until the iterator is advanced or destroyed.
+    class ListIterator {
+        private:
+            const List::_Block* m_pBlock = nullptr;
+            size_t m_uIndex = 0;
+            bool m_bReverse = false;
+            mutable ListItem m_item;
+
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = ListItem;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const ListItem*;
+            using reference = const ListItem&;
+
+            ListIterator() = default;
+            ListIterator(const List::_Block* _pBlock, size_t _uIndex, bool _bReverse) :
+                m_pBlock(_pBlock),
+                m_uIndex(_uIndex),
+                m_bReverse(_bReverse) {}
+
+            const ListItem& operator*() const;
+
+            inline const ListItem* operator->() const {
+                return &**this;
+            }
+
+            inline ListIterator& operator++() {
+                m_bReverse ? m_uIndex-- : m_uIndex++;
+                return *this;
+            }
+
+            inline ListIterator operator++(int) {
+                ListIterator it = *this;
+                ++*this;
+                return it;
+            }
+
+            inline ListIterator& operator--() {
+                m_bReverse ? m_uIndex++ : m_uIndex--;
+                return *this;
+            }
+
+            inline ListIterator operator--(int) {
+                ListIterator it = *this;
+                --*this;
+                return it;
+            }
+
+            inline ListIterator operator+(difference_type _iOffset) const {
+                return ListIterator(m_pBlock, m_bReverse ? m_uIndex - _iOffset : m_uIndex + _iOffset, m_bReverse);
+            }
+
+            inline ListIterator operator-(difference_type _iOffset) const {
+                return *this + (-_iOffset);
+            }
+
+            inline bool operator==(const ListIterator& _it) const {
+                return m_uIndex == _it.m_uIndex && m_pBlock == _it.m_pBlock;
+            }
+
+            inline bool operator!=(const ListIterator& _it) const {
+                return !(*this == _it);
+            }
+    };
+
+    struct List::_Block {
+        _Block(std::pmr::memory_resource* _pResource) :
+            items(_pResource) {}
+
+        inline std::pmr::memory_resource* GetResource() const {
+            return items.get_allocator().resource();
+        }
+
+        // mixed elements
+        std::pmr::vector<ListItem> items;
+        // packed elements, allocated from the same memory resource as items
+        Type packedType = Type_None;
+        void* pPacked = nullptr;
+        size_t uPackedSize = 0;
+        size_t uPackedCapacity = 0;
+    };
+
+    inline size_t _PackedElementSize(Type _type) {
+        return _type == Type_Bool ? sizeof(Bool) : sizeof(Int);
+    }
+
+    inline List::_Block* List::_GetOrCreateBlock() {
+        if (!m_pBlock) {
+            std::pmr::memory_resource* pResource = Arena::GetCurrentResource();
+            m_pBlock = new (pResource->allocate(sizeof(_Block), alignof(_Block))) _Block(pResource);
+        }
+        return m_pBlock;
+    }
+
+    inline void List::_Release() {
+        if (!m_pBlock)
+            return;
+
+        std::pmr::memory_resource* pResource = m_pBlock->GetResource();
+        if (m_pBlock->pPacked) {
+            pResource->deallocate(m_pBlock->pPacked, m_pBlock->uPackedCapacity * _PackedElementSize(m_pBlock->packedType),
+                                  alignof(Int));
+        }
+        m_pBlock->~_Block();
+        pResource->deallocate(m_pBlock, sizeof(_Block), alignof(_Block));
+        m_pBlock = nullptr;
+    }
+
+    inline std::size_t List::Size() const {
+        if (!m_pBlock)
+            return 0;
+        return m_pBlock->packedType != Type_None ? m_pBlock->uPackedSize : m_pBlock->items.size();
+    }
+
+    inline std::size_t List::GetAllocatedBytes() const {
+        if (!m_pBlock)
+            return 0;
+        return sizeof(_Block) + m_pBlock->items.capacity() * sizeof(ListItem) +
+            m_pBlock->uPackedCapacity * _PackedElementSize(m_pBlock->packedType);
+    }
+
+    inline Type List::GetPackedType() const {
+        return m_pBlock ? m_pBlock->packedType : Type_None;
+    }
+
+    template <typename T>
+    inline Span<T> List::GetSpan() const {
+        static_assert(PackedTraits<T>::bSupported, "Only Int, Float and Bool lists can be packed");
+        if (!m_pBlock || m_pBlock->packedType != PackedTraits<T>::type)
+            return Span<T>();
+        return Span<T>(static_cast<const T*>(m_pBlock->pPacked), m_pBlock->uPackedSize);
+    }
+
+    inline ListIterator List::Begin() const {
+        return ListIterator(m_pBlock, 0, false);
+    }
+
+    inline ListIterator List::End() const {
+        return ListIterator(m_pBlock, Size(), false);
+    }
+
+    inline ListIterator List::ReverseBegin() const {
+        return ListIterator(m_pBlock, Size() - 1, true);
+    }
+
+    inline ListIterator List::ReverseEnd() const {
+        return ListIterator(m_pBlock, static_cast<size_t>(-1), true);
+    }
+
+    inline const ListItem& ListIterator::operator*() const {
+        switch (m_pBlock->packedType) {
+            case Type_Int:
+                m_item.emplace<Int>(static_cast<const Int*>(m_pBlock->pPacked)[m_uIndex]);
+                return m_item;
+
+            case Type_Float:
+                m_item.emplace<Float>(static_cast<const Float*>(m_pBlock->pPacked)[m_uIndex]);
+                return m_item;
+
+            case Type_Bool:
+                m_item.emplace<Bool>(static_cast<const Bool*>(m_pBlock->pPacked)[m_uIndex]);
+                return m_item;
+
+            default:
+                return m_pBlock->items[m_uIndex];
+        }
+    }
+
+    // object contents are kept in insertion order
+    typedef OrderedMap<Symbol, Value, std::hash<Symbol>, SymbolEqual> ObjectMap;
 
     class Object {
         private:
-            using _Contents = std::unordered_map<String, Value>;
+            using _Contents = ObjectMap;
+            // keeps the arena alive for as long as contents use its memory, declared first so that it is released last
+            std::shared_ptr<Arena> m_pArena;
             _Contents m_contents;
 
         public:
-            Object() = default;
+            Object() :
+                m_pArena(Arena::GetCurrentRef()),
+                m_contents(Arena::GetCurrentResource()) {}
+            Object(const Object& _obj) :
+                m_pArena(Arena::GetCurrentRef()),
+                m_contents(_obj.m_contents, Arena::GetCurrentResource()) {}
+            Object(Object&&) = default;
+            Object(_Contents&& _contents) :
+                m_pArena(Arena::GetCurrentRef()),
+                m_contents(std::move(_contents), Arena::GetCurrentResource()) {}
+            Object& operator=(const Object&) = delete;
 
-            inline void PushNode(const String& _key, const Value& _val) {
+            inline void PushNode(const Symbol& _key, const Value& _val) {
                 m_contents.emplace(std::make_pair(_key, _val));
             }
 
@@ -123,17 +598,14 @@ namespace cvar {
             inline const _Contents& GetContents() const { return m_contents; }
     };
 
-    enum Type : size_t {
-        Type_None,
-        Type_Int,
-        Type_Float,
-        Type_Bool,
-        Type_String,
-        Type_List,
-        Type_Object
-    };
+    // tree lookup helpers, keys are walked one dotted segment at a time
+    const Value* FindTreeNode(const ObjectMap& _root, const std::string& _key);
+    const Value* FindTreeNode(const ObjectMap& _root, const hash_t* _pHashes, const std::string_view* _pSegments, size_t _uCount);
 
     // list and object stream serializers
-    std::ostream& operator<<(std::ostream& _stream, List& _list);
+    std::ostream& operator<<(std::ostream& _stream, const List& _list);
     std::ostream& operator<<(std::ostream& _stream, Object& _obj);
+
+    // shortest text that reads back as the same Float and never as an Int, infinity and nan are written as null
+    std::ostream& WriteJSONFloat(std::ostream& _stream, Float _fValue);
 }
@@ -36,8 +36,10 @@ namespace cvar {
             T m_root;
 
         public:
+            // root is allocated from the arena that is current while the unserializer is constructed
             IUnserializer(std::istream& _stream) :
-                m_stream(_stream) {}
+                m_stream(_stream),
+                m_root(typename T::allocator_type(Arena::GetCurrentResource())) {}
 
             inline T&& Get() {
                 return std::move(m_root);
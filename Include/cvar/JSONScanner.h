@@ -0,0 +1,32 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: JSONScanner.h - vectorized JSON structural character scanner header
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cvar {
+
+    enum class JSONScanBackend {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    // fastest backend supported by the CPU, detected on first use
+    JSONScanBackend GetJSONScanBackend();
+    const char* GetJSONScanBackendName(JSONScanBackend _backend);
+
+    // First stage of JSONUnserializer. The text is classified in blocks of 64 bytes into bit masks of operators, quotes,
+    // whitespace and backslashes, from which the offsets of operators, opening and closing quotes and the first
+    // character of every other value outside of strings are appended to _indices. Quotes escaped with a backslash
+    // don't end a string. Returns false if the text contains single quoted strings, which only the tokenizer reads,
+    // or doesn't fit 32 bit offsets.
+    // NOTE: backends that the CPU doesn't support are replaced with the fastest supported one
+    bool ScanJSONStructure(const char* _pData, size_t _uLen, std::vector<uint32_t>& _indices);
+    bool ScanJSONStructure(const char* _pData, size_t _uLen, std::vector<uint32_t>& _indices, JSONScanBackend _backend);
+}
@@ -7,16 +7,19 @@
 
 #include <cvar/Api.h>
 #include <cvar/ISerializer.h>
+#include <cvar/SerializationCache.h>
 
 namespace cvar {
 
-    class CVAR_API JSONSerializer : public ISerializer<std::unordered_map<String, Value>> {
+    class CVAR_API JSONSerializer : public ISerializer<ObjectMap> {
         private:
             void _SerializeBeautified();
             void _SerializeCompact();
 
         public:
-            JSONSerializer(std::ostream& _stream, std::unordered_map<String, Value>& _root);
+            JSONSerializer(std::ostream& _stream, ObjectMap& _root);
             virtual void Serialize(bool bBeautified = true) override;
+            // produces the same output as Serialize(), reusing the text of objects that are cached and clean
+            void Serialize(bool _bBeautified, SerializationCache& _cache);
     };
 }
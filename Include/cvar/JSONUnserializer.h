@@ -7,10 +7,13 @@
 
 #include <cvar/Api.h>
 #include <cvar/ISerializer.h>
+#include <cstdint>
 #include <optional>
 #include <limits>
 #include <queue>
 #include <stack>
+#include <string>
+#include <vector>
 
 namespace cvar {
 
@@ -39,7 +42,10 @@ namespace cvar {
         JSONTokenIndex_JSONNull
     };
 
-    class CVAR_API JSONUnserializer : public IPlainTextUnserializer<std::unordered_map<String, Value>> {
+    // JSONUnserializer parses in two stages. ScanJSONStructure() first indexes the structural characters of the whole
+    // text with SIMD instructions, then the tree is built from the index without looking at the bytes in between.
+    // Text with single quoted strings is parsed token by token from the stream instead.
+    class CVAR_API JSONUnserializer : public IPlainTextUnserializer<ObjectMap> {
         private:
             JSONToken m_token = JSONToken(std::monostate{}, 1);
             const char m_szJsonSyntax[8] = { '{', '}', '[', ']', ',', ':', '\"', '\'' };
@@ -65,7 +71,11 @@ namespace cvar {
             }
 
             List _ParseList();
-            void _ParseObject(std::unordered_map<String, Value>* _pRootObject);
+            void _ParseObject(ObjectMap* _pRootObject);
+            // token by token parsing from the stream, used for text that the structural scanner can't index
+            void _ParseTokens();
+            // build the tree from the structural character offsets found by ScanJSONStructure()
+            void _BuildTree(const std::string& _sText, const std::vector<uint32_t>& _indices);
             void _Parse();
 
         public:
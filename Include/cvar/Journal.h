@@ -0,0 +1,128 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: Journal.h - append-only CVar change journal header
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cvar/Api.h>
+#include <cvar/CVarSystem.h>
+
+namespace cvar {
+
+    enum class JournalSync {
+        Always,     // every record is written and flushed to the disk before the write returns
+        Periodic,   // records are written and flushed to the disk by the journal thread once per sync interval
+        Never       // records are written by the journal thread, the operating system decides when they reach the disk
+    };
+
+    struct JournalOptions {
+        JournalSync sync = JournalSync::Periodic;
+        uint32_t uSyncIntervalMs = 1000;
+        // Update() compacts the journal into a new snapshot once it has grown past this many bytes
+        size_t uCompactionThreshold = 4 << 20;
+    };
+
+    // Journal persists variable changes by appending a binary record of every written value to a log file,
+    // thus the cost of persisting a change doesn't depend on the size of the tree. Open() loads the last JSON
+    // snapshot and replays the log on top of it. Compaction swaps the log for an empty one and writes the tree
+    // as a new snapshot from a background thread. Snapshots are written to a temporary file and renamed over
+    // the previous one, thus a crash at any point leaves a snapshot and logs that reproduce the latest state.
+    // NOTE: Open(), Update() and Compact() must be called from the thread that writes variables. Values modified
+    // through pointers returned by GetValue() are not recorded.
+    class CVAR_API Journal {
+        private:
+            CVarSystem& m_system;
+            std::string m_sSnapshotPath;
+            std::string m_sJournalPath;
+            JournalOptions m_options;
+            SubscriptionId m_uSubscription = 0;
+            bool m_bOpen = false;
+            // encoding buffer of the record that is being appended
+            std::vector<char> m_record;
+
+            // file state is shared with the journal thread and guarded by m_mtx
+            std::mutex m_mtx;
+            std::condition_variable m_cv;
+            std::thread m_thread;
+            int m_iFile = -1;
+            // size of the journal including buffered records
+            size_t m_uSize = 0;
+            // records that haven't been written yet, m_flushing is being written by the journal thread
+            std::vector<char> m_buffer;
+            std::vector<char> m_flushing;
+            bool m_bFlushing = false;
+            bool m_bUnsynced = false;
+            bool m_bError = false;
+            bool m_bStop = false;
+            // snapshot that is waiting to be written by the journal thread
+            Snapshot m_pendingSnapshot;
+            bool m_bCompacting = false;
+
+        private:
+            void _OnChange(const std::string& _sKey, const Value* _pValue);
+            void _Append(const std::string& _sKey, const Value& _val);
+            // replay records of the journal file, returns the length of its valid part
+            size_t _Replay(const std::string& _sPath);
+            // open the journal for appending after its first _uValidSize bytes, the rest is discarded
+            bool _OpenLog(size_t _uValidSize);
+            // write buffered records from the calling thread
+            void _Flush(std::unique_lock<std::mutex>& _lock, bool _bSync);
+            void _CloseLog(std::unique_lock<std::mutex>& _lock);
+            // move records of the current journal to the rotated journal and start an empty one
+            bool _Rotate(std::unique_lock<std::mutex>& _lock);
+            bool _WriteSnapshot(const Snapshot& _snapshot) const;
+            void _FinishCompaction(bool _bWritten);
+            void _Run();
+
+        public:
+            Journal(CVarSystem& _system, const std::string& _sSnapshotPath, const std::string& _sJournalPath,
+                    const JournalOptions& _options = JournalOptions());
+            ~Journal();
+
+            Journal(const Journal&) = delete;
+            Journal& operator=(const Journal&) = delete;
+
+            // load the snapshot, replay the journal and start recording changes. If no snapshot exists, the journal
+            // is replayed over the current tree. Returns false if the journal file can't be opened for writing.
+            bool Open();
+            void Close();
+
+            // start compaction if the journal has grown past the threshold
+            void Update();
+
+            // swap the journal for an empty one and write the current tree as the new snapshot. If _bWait is
+            // false, the snapshot is written by the journal thread. A previous compaction that is still in
+            // progress is waited for. Returns false if the files can't be written.
+            bool Compact(bool _bWait = false);
+
+            // write all appended records and flush them to the disk
+            void Sync();
+
+            // size of the current journal in bytes
+            inline size_t GetSize() {
+                std::lock_guard<std::mutex> lock(m_mtx);
+                return m_uSize;
+            }
+
+            // true if some record couldn't be written, records are no longer appended afterwards
+            inline bool HasError() {
+                std::lock_guard<std::mutex> lock(m_mtx);
+                return m_bError;
+            }
+
+            inline bool IsOpen() const {
+                return m_bOpen;
+            }
+
+            inline std::string GetRotatedPath() const {
+                return m_sJournalPath + ".old";
+            }
+    };
+}
@@ -0,0 +1,134 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: MappedConfig.h - read-only access to memory mapped binary CVar images header
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cvar/Api.h>
+#include <cvar/BinaryFormat.h>
+#include <cvar/CVarTypes.h>
+
+namespace cvar {
+
+    // validated image that values are read from
+    struct BinaryImage {
+        const char* pData = nullptr;
+        size_t uSize = 0;
+        // false if the image was written with another hash function, keys are then compared by text only
+        bool bNativeHashes = false;
+
+        // check the header and return a pointer to the root object, nullptr if the image is not valid
+        const BinaryObject* Validate();
+    };
+
+    // MappedValue is a view to a single value of a binary image. Scalars and strings are read in place and
+    // packed lists can be accessed as spans, thus nothing is allocated until the value is materialized.
+    // NOTE: views are valid for as long as the image they point to
+    class CVAR_API MappedValue {
+        private:
+            const BinaryImage* m_pImage = nullptr;
+            BinarySlot m_slot = {};
+
+        private:
+            // block at given offset, nullptr if it or _uTrailing bytes after it are outside of the image
+            template <typename T>
+            const T* _Block(uint32_t _uOffset, size_t _uTrailing = 0) const;
+            const BinaryString* _String(uint32_t _uOffset) const;
+            const BinaryObject* _Object() const;
+            const BinaryList* _List() const;
+
+            // copy of a scalar, string or packed list, other lists and objects are created empty
+            Value _MaterializeShallow() const;
+            // true for objects and mixed lists, whose elements are copied one by one
+            bool _HasChildren() const;
+            // fill the list or object contents that this value was materialized into
+            void _MaterializeChildren(List* _pList, ObjectMap* _pContents) const;
+
+        public:
+            MappedValue() = default;
+            MappedValue(const BinaryImage* _pImage, const BinarySlot& _slot) :
+                m_pImage(_pImage),
+                m_slot(_slot) {}
+
+            inline Type GetType() const {
+                return m_pImage ? static_cast<Type>(m_slot.uType) : Type_None;
+            }
+
+            inline explicit operator bool() const {
+                return GetType() != Type_None;
+            }
+
+            // scalar getters return _default if the value has another type
+            Int GetInt(Int _default = 0) const;
+            Float GetFloat(Float _default = 0.f) const;
+            Bool GetBool(Bool _default = false) const;
+            // empty view if the value is not a string
+            std::string_view GetString() const;
+
+            // number of list elements or object entries, 0 for other types
+            size_t Size() const;
+            // list element or object value in insertion order
+            MappedValue At(size_t _uIndex) const;
+            // object key in insertion order
+            std::string_view KeyAt(size_t _uIndex) const;
+
+            // look up a dotted path below this object
+            MappedValue Find(std::string_view _sPath) const;
+
+            // contiguous elements of a list packed with type T, empty span otherwise
+            template <typename T>
+            Span<T> GetSpan() const;
+
+            // copy the value and everything below it into regular CVar values, e.g. before it gets modified
+            Value Materialize() const;
+            // append the entries of an object to _contents
+            void MaterializeInto(ObjectMap& _contents) const;
+    };
+
+    template <typename T>
+    inline Span<T> MappedValue::GetSpan() const {
+        static_assert(PackedTraits<T>::bSupported, "Only Int, Float and Bool lists can be packed");
+        const BinaryList* pList = _List();
+        if (!pList || pList->uPackedType != PackedTraits<T>::type)
+            return Span<T>();
+        return Span<T>(reinterpret_cast<const T*>(pList + 1), pList->uCount);
+    }
+
+    // MappedConfig maps a binary image written by BinarySerializer into memory and reads it in place. Opening an
+    // image only validates its header, thus startup cost doesn't depend on the size of the configuration. Pages
+    // of the file are loaded by the operating system as they are accessed.
+    class CVAR_API MappedConfig {
+        private:
+            BinaryImage m_image;
+            const BinaryObject* m_pRoot = nullptr;
+            size_t m_uMappedSize = 0;
+#ifdef _WIN32
+            void* m_hFile = nullptr;
+            void* m_hMapping = nullptr;
+#endif
+
+        public:
+            MappedConfig() = default;
+            ~MappedConfig();
+
+            MappedConfig(const MappedConfig&) = delete;
+            MappedConfig& operator=(const MappedConfig&) = delete;
+
+            // returns false if the file can't be mapped or isn't a valid binary image
+            bool Open(const std::string& _sFileName);
+            void Close();
+
+            inline bool IsOpen() const {
+                return m_pRoot != nullptr;
+            }
+
+            MappedValue GetRoot() const;
+
+            inline MappedValue Find(std::string_view _sPath) const {
+                return GetRoot().Find(_sPath);
+            }
+    };
+}
@@ -0,0 +1,34 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: MessagePackSerializer.h - MessagePack serializer class header
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cvar/Api.h>
+#include <cvar/ISerializer.h>
+
+namespace cvar {
+
+    // MessagePackSerializer encodes the tree as a MessagePack map. Integers use the smallest fitting format, floats
+    // are written as float 32 and lists as arrays. Output is streamed in blocks, thus memory use doesn't depend on
+    // the size of the tree.
+    class CVAR_API MessagePackSerializer : public ISerializer<ObjectMap> {
+        private:
+            std::string m_buffer;
+
+        private:
+            void _Flush();
+            void _WriteHeader(uint8_t _uFixed, uint32_t _uFixedMax, uint8_t _u8, uint8_t _u16, uint8_t _u32, uint32_t _uCount);
+            void _WriteInt(Int _iValue);
+            void _WriteFloat(Float _fValue);
+            void _WriteString(std::string_view _sText);
+
+        public:
+            MessagePackSerializer(std::ostream& _stream, ObjectMap& _root);
+            // MessagePack has only one representation, thus _bBeautified is ignored
+            virtual void Serialize(bool _bBeautified = true) override;
+    };
+}
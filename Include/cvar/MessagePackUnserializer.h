@@ -0,0 +1,32 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: MessagePackUnserializer.h - MessagePack unserializer class header
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <string>
+#include <cvar/Api.h>
+#include <cvar/ISerializer.h>
+
+namespace cvar {
+
+    // MessagePackUnserializer decodes a MessagePack map in a single pass, containers are built directly with an
+    // explicit stack. Integers outside of the Int range are stored as Float, float 64 values are narrowed to Float,
+    // binary data is stored as String and nil values are not stored. Extension types are not supported.
+    class CVAR_API MessagePackUnserializer : public IUnserializer<ObjectMap> {
+        private:
+            std::string m_sScratch;
+
+        private:
+            uint8_t _ReadByte();
+            void _Read(void* _pData, size_t _uLen);
+            uint32_t _ReadBE(size_t _uLen);
+            std::string_view _ReadText(uint32_t _uLen);
+            Value _ReadScalar(uint8_t _uMarker);
+            void _Parse();
+
+        public:
+            MessagePackUnserializer(std::istream& _stream);
+    };
+}
@@ -0,0 +1,456 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: OrderedMap.h - insertion ordered open addressing hash map header
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory_resource>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+#endif
+
+// maps with at most this many entries are searched by scanning their hashes linearly
+#ifndef CVAR_ORDERED_MAP_LINEAR_LIMIT
+    #define CVAR_ORDERED_MAP_LINEAR_LIMIT 8
+#endif
+
+namespace cvar {
+
+    // OrderedMap is a hash map that preserves insertion order. Entries are stored in chunks whose sizes double,
+    // thus inserting new keys never moves existing entries and pointers to them stay valid until an entry
+    // before them is erased. Key hashes are kept in a separate dense array next to the entries. Small maps
+    // are searched by scanning that array, larger maps use an open addressing table of entry indices.
+    template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+    class OrderedMap {
+        public:
+            typedef K key_type;
+            typedef V mapped_type;
+            typedef std::pair<K, V> value_type;
+            typedef size_t size_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef std::pmr::polymorphic_allocator<value_type> allocator_type;
+
+            template <typename M, typename T>
+            class Iterator {
+                friend class OrderedMap;
+                template <typename, typename>
+                friend class Iterator;
+
+                private:
+                    M* m_pMap = nullptr;
+                    size_t m_uIndex = 0;
+
+                public:
+                    typedef std::bidirectional_iterator_tag iterator_category;
+                    typedef std::remove_const_t<T> value_type;
+                    typedef std::ptrdiff_t difference_type;
+                    typedef T* pointer;
+                    typedef T& reference;
+
+                    Iterator() = default;
+                    Iterator(M* _pMap, size_t _uIndex) :
+                        m_pMap(_pMap),
+                        m_uIndex(_uIndex) {}
+
+                    // iterator to const_iterator conversion
+                    template <typename M2, typename T2, typename = std::enable_if_t<std::is_convertible_v<M2*, M*>>>
+                    Iterator(const Iterator<M2, T2>& _it) :
+                        m_pMap(_it.m_pMap),
+                        m_uIndex(_it.m_uIndex) {}
+
+                    inline reference operator*() const { return m_pMap->_EntryAt(m_uIndex); }
+                    inline pointer operator->() const { return &m_pMap->_EntryAt(m_uIndex); }
+
+                    inline Iterator& operator++() {
+                        m_uIndex++;
+                        return *this;
+                    }
+
+                    inline Iterator operator++(int) {
+                        Iterator it = *this;
+                        m_uIndex++;
+                        return it;
+                    }
+
+                    inline Iterator& operator--() {
+                        m_uIndex--;
+                        return *this;
+                    }
+
+                    inline Iterator operator--(int) {
+                        Iterator it = *this;
+                        m_uIndex--;
+                        return it;
+                    }
+
+                    template <typename M2, typename T2>
+                    inline bool operator==(const Iterator<M2, T2>& _it) const {
+                        return m_uIndex == _it.m_uIndex;
+                    }
+
+                    template <typename M2, typename T2>
+                    inline bool operator!=(const Iterator<M2, T2>& _it) const {
+                        return m_uIndex != _it.m_uIndex;
+                    }
+            };
+
+            typedef Iterator<OrderedMap, value_type> iterator;
+            typedef Iterator<const OrderedMap, const value_type> const_iterator;
+
+        private:
+            static constexpr size_t s_uFirstChunkSize = 4;
+
+            allocator_type m_alloc;
+            // chunk i holds s_uFirstChunkSize << i entries
+            std::pmr::vector<value_type*> m_chunks;
+            // hashes of all entries in insertion order
+            std::pmr::vector<size_t> m_hashes;
+            // open addressing table, 0 marks an empty slot and other values are entry indices + 1,
+            // the table stays empty as long as the map is small enough to be scanned linearly
+            std::pmr::vector<uint32_t> m_slots;
+            size_t m_uSize = 0;
+            Hash m_hash;
+            KeyEqual m_equal;
+
+        private:
+            static inline size_t _Log2(size_t _uValue) {
+#if defined(__GNUC__) || defined(__clang__)
+                return sizeof(unsigned long long) * 8 - 1 - static_cast<size_t>(__builtin_clzll(_uValue));
+#elif defined(_MSC_VER) && defined(_WIN64)
+                unsigned long uIndex;
+                _BitScanReverse64(&uIndex, _uValue);
+                return uIndex;
+#else
+                size_t uLog = 0;
+                while (_uValue >>= 1)
+                    uLog++;
+                return uLog;
+#endif
+            }
+
+            static inline size_t _ChunkOf(size_t _uIndex) {
+                return _Log2(_uIndex / s_uFirstChunkSize + 1);
+            }
+
+            static inline size_t _ChunkBegin(size_t _uChunk) {
+                return s_uFirstChunkSize * ((static_cast<size_t>(1) << _uChunk) - 1);
+            }
+
+            static inline size_t _ChunkSize(size_t _uChunk) {
+                return s_uFirstChunkSize << _uChunk;
+            }
+
+            static inline size_t _SlotOf(size_t _uHash, size_t _uMask) {
+                return (_uHash ^ (_uHash >> (sizeof(size_t) * 4))) & _uMask;
+            }
+
+            inline value_type& _EntryAt(size_t _uIndex) {
+                const size_t uChunk = _ChunkOf(_uIndex);
+                return m_chunks[uChunk][_uIndex - _ChunkBegin(uChunk)];
+            }
+
+            inline const value_type& _EntryAt(size_t _uIndex) const {
+                const size_t uChunk = _ChunkOf(_uIndex);
+                return m_chunks[uChunk][_uIndex - _ChunkBegin(uChunk)];
+            }
+
+            // returns m_uSize if the key is not present
+            template <typename Q>
+            size_t _Find(const Q& _key, size_t _uHash) const {
+                if (m_slots.empty()) {
+                    const size_t* pHashes = m_hashes.data();
+                    for (size_t i = 0; i < m_uSize; i++) {
+                        if (pHashes[i] == _uHash && m_equal(_EntryAt(i).first, _key))
+                            return i;
+                    }
+
+                    return m_uSize;
+                }
+
+                const size_t uMask = m_slots.size() - 1;
+                for (size_t uSlot = _SlotOf(_uHash, uMask); m_slots[uSlot]; uSlot = (uSlot + 1) & uMask) {
+                    const size_t uIndex = m_slots[uSlot] - 1;
+                    if (m_hashes[uIndex] == _uHash && m_equal(_EntryAt(uIndex).first, _key))
+                        return uIndex;
+                }
+
+                return m_uSize;
+            }
+
+            inline void _PlaceSlot(size_t _uIndex) {
+                const size_t uMask = m_slots.size() - 1;
+                size_t uSlot = _SlotOf(m_hashes[_uIndex], uMask);
+                while (m_slots[uSlot])
+                    uSlot = (uSlot + 1) & uMask;
+                m_slots[uSlot] = static_cast<uint32_t>(_uIndex + 1);
+            }
+
+            void _Rehash(size_t _uCount) {
+                if (_uCount <= CVAR_ORDERED_MAP_LINEAR_LIMIT) {
+                    m_slots.clear();
+                    return;
+                }
+
+                // keep the load factor at or below 0.5
+                size_t uCapacity = 2 * CVAR_ORDERED_MAP_LINEAR_LIMIT;
+                while (uCapacity < 2 * _uCount)
+                    uCapacity <<= 1;
+
+                m_slots.assign(uCapacity, 0);
+                for (size_t i = 0; i < m_uSize; i++)
+                    _PlaceSlot(i);
+            }
+
+            inline value_type* _AllocateSlot() {
+                const size_t uChunk = _ChunkOf(m_uSize);
+                if (uChunk == m_chunks.size())
+                    m_chunks.push_back(m_alloc.allocate(_ChunkSize(uChunk)));
+                return &m_chunks[uChunk][m_uSize - _ChunkBegin(uChunk)];
+            }
+
+            // construct a new entry whose key is known to be absent
+            template <typename... Args>
+            size_t _Append(size_t _uHash, Args&&... _args) {
+                value_type* pEntry = _AllocateSlot();
+                m_hashes.push_back(_uHash);
+                try {
+                    new (pEntry) value_type(std::forward<Args>(_args)...);
+                }
+                catch (...) {
+                    m_hashes.pop_back();
+                    throw;
+                }
+
+                m_uSize++;
+                if (m_uSize > CVAR_ORDERED_MAP_LINEAR_LIMIT || !m_slots.empty()) {
+                    if (2 * m_uSize > m_slots.size())
+                        _Rehash(m_uSize);
+                    else _PlaceSlot(m_uSize - 1);
+                }
+
+                return m_uSize - 1;
+            }
+
+            void _Release() {
+                clear();
+                for (size_t i = 0; i < m_chunks.size(); i++)
+                    m_alloc.deallocate(m_chunks[i], _ChunkSize(i));
+                m_chunks.clear();
+            }
+
+            void _Steal(OrderedMap& _map) noexcept {
+                m_chunks.swap(_map.m_chunks);
+                m_hashes.swap(_map.m_hashes);
+                m_slots.swap(_map.m_slots);
+                m_uSize = _map.m_uSize;
+                _map.m_uSize = 0;
+            }
+
+            template <typename M>
+            void _AppendAll(M&& _map) {
+                reserve(m_uSize + _map.m_uSize);
+                for (size_t i = 0; i < _map.m_uSize; i++) {
+                    if constexpr (std::is_rvalue_reference_v<M&&>)
+                        _Append(_map.m_hashes[i], std::move(_map._EntryAt(i)));
+                    else _Append(_map.m_hashes[i], _map._EntryAt(i));
+                }
+            }
+
+        public:
+            OrderedMap() :
+                OrderedMap(allocator_type()) {}
+            explicit OrderedMap(const allocator_type& _alloc) :
+                m_alloc(_alloc),
+                m_chunks(_alloc.resource()),
+                m_hashes(_alloc.resource()),
+                m_slots(_alloc.resource()) {}
+
+            OrderedMap(const OrderedMap& _map) :
+                OrderedMap(_map, allocator_type()) {}
+            OrderedMap(const OrderedMap& _map, const allocator_type& _alloc) :
+                OrderedMap(_alloc)
+            {
+                _AppendAll(_map);
+            }
+
+            OrderedMap(OrderedMap&& _map) noexcept :
+                m_alloc(_map.m_alloc),
+                m_chunks(std::move(_map.m_chunks)),
+                m_hashes(std::move(_map.m_hashes)),
+                m_slots(std::move(_map.m_slots)),
+                m_uSize(_map.m_uSize)
+            {
+                _map.m_uSize = 0;
+            }
+
+            // memory is taken over only if both maps use the same resource, otherwise entries are moved one by one
+            OrderedMap(OrderedMap&& _map, const allocator_type& _alloc) :
+                OrderedMap(_alloc)
+            {
+                if (m_alloc == _map.m_alloc)
+                    _Steal(_map);
+                else _AppendAll(std::move(_map));
+            }
+
+            ~OrderedMap() {
+                _Release();
+            }
+
+            OrderedMap& operator=(const OrderedMap& _map) {
+                if (this != &_map) {
+                    clear();
+                    _AppendAll(_map);
+                }
+
+                return *this;
+            }
+
+            OrderedMap& operator=(OrderedMap&& _map) {
+                if (this == &_map)
+                    return *this;
+
+                if (m_alloc == _map.m_alloc) {
+                    _Release();
+                    _Steal(_map);
+                }
+                else {
+                    clear();
+                    _AppendAll(std::move(_map));
+                }
+
+                return *this;
+            }
+
+            inline allocator_type get_allocator() const { return m_alloc; }
+
+            inline iterator begin() { return iterator(this, 0); }
+            inline iterator end() { return iterator(this, m_uSize); }
+            inline const_iterator begin() const { return const_iterator(this, 0); }
+            inline const_iterator end() const { return const_iterator(this, m_uSize); }
+            inline const_iterator cbegin() const { return begin(); }
+            inline const_iterator cend() const { return end(); }
+
+            inline size_t size() const { return m_uSize; }
+            inline bool empty() const { return m_uSize == 0; }
+
+            // memory held by entry chunks, hashes and the slot table, excluding memory owned by keys and values
+            inline size_t allocated_bytes() const {
+                size_t uEntries = 0;
+                for (size_t i = 0; i < m_chunks.size(); i++)
+                    uEntries += _ChunkSize(i);
+                return uEntries * sizeof(value_type) + m_chunks.capacity() * sizeof(value_type*) +
+                    m_hashes.capacity() * sizeof(size_t) + m_slots.capacity() * sizeof(uint32_t);
+            }
+
+            inline iterator find(const K& _key) {
+                return iterator(this, _Find(_key, m_hash(_key)));
+            }
+
+            inline const_iterator find(const K& _key) const {
+                return const_iterator(this, _Find(_key, m_hash(_key)));
+            }
+
+            // lookup by a different key type with a precomputed hash, KeyEqual must be able to compare K to Q
+            template <typename Q>
+            inline iterator find(const Q& _key, size_t _uHash) {
+                return iterator(this, _Find(_key, _uHash));
+            }
+
+            template <typename Q>
+            inline const_iterator find(const Q& _key, size_t _uHash) const {
+                return const_iterator(this, _Find(_key, _uHash));
+            }
+
+            inline size_t count(const K& _key) const {
+                return _Find(_key, m_hash(_key)) != m_uSize ? 1 : 0;
+            }
+
+            template <typename KArg, typename... Args>
+            std::pair<iterator, bool> try_emplace(KArg&& _key, Args&&... _args) {
+                const size_t uHash = m_hash(_key);
+                const size_t uIndex = _Find(_key, uHash);
+                if (uIndex != m_uSize)
+                    return std::make_pair(iterator(this, uIndex), false);
+
+                const size_t uNew = _Append(uHash, std::piecewise_construct, std::forward_as_tuple(std::forward<KArg>(_key)),
+                                            std::forward_as_tuple(std::forward<Args>(_args)...));
+                return std::make_pair(iterator(this, uNew), true);
+            }
+
+            template <typename... Args>
+            std::pair<iterator, bool> emplace(Args&&... _args) {
+                value_type entry(std::forward<Args>(_args)...);
+                return try_emplace(std::move(entry.first), std::move(entry.second));
+            }
+
+            inline std::pair<iterator, bool> insert(const value_type& _entry) {
+                return try_emplace(_entry.first, _entry.second);
+            }
+
+            inline std::pair<iterator, bool> insert(value_type&& _entry) {
+                return try_emplace(std::move(_entry.first), std::move(_entry.second));
+            }
+
+            template <typename P, typename = std::enable_if_t<std::is_constructible_v<value_type, P&&>>>
+            inline std::pair<iterator, bool> insert(P&& _entry) {
+                return emplace(std::forward<P>(_entry));
+            }
+
+            inline V& operator[](const K& _key) {
+                return try_emplace(_key).first->second;
+            }
+
+            // erasing preserves the order of remaining entries, entries after the erased one are moved back
+            iterator erase(const_iterator _pos) {
+                const size_t uIndex = _pos.m_uIndex;
+                for (size_t i = uIndex + 1; i < m_uSize; i++)
+                    _EntryAt(i - 1) = std::move(_EntryAt(i));
+
+                _EntryAt(m_uSize - 1).~value_type();
+                m_hashes.erase(m_hashes.begin() + static_cast<difference_type>(uIndex));
+                m_uSize--;
+                if (!m_slots.empty())
+                    _Rehash(m_uSize);
+
+                return iterator(this, uIndex);
+            }
+
+            inline size_t erase(const K& _key) {
+                const size_t uIndex = _Find(_key, m_hash(_key));
+                if (uIndex == m_uSize)
+                    return 0;
+
+                erase(const_iterator(this, uIndex));
+                return 1;
+            }
+
+            // allocated chunks are kept for reuse
+            void clear() {
+                for (size_t i = 0; i < m_uSize; i++)
+                    _EntryAt(i).~value_type();
+                m_hashes.clear();
+                m_slots.clear();
+                m_uSize = 0;
+            }
+
+            void reserve(size_t _uCount) {
+                while (_ChunkBegin(m_chunks.size()) < _uCount)
+                    m_chunks.push_back(m_alloc.allocate(_ChunkSize(m_chunks.size())));
+
+                m_hashes.reserve(_uCount);
+                if (_uCount > CVAR_ORDERED_MAP_LINEAR_LIMIT && 2 * _uCount > m_slots.size())
+                    _Rehash(_uCount);
+            }
+    };
+}
@@ -0,0 +1,60 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: PathIndex.h - sorted index of full CVar paths header
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cvar/Api.h>
+#include <cvar/CVarTypes.h>
+
+namespace cvar {
+
+    // PathIndex keeps the full dotted paths of all nodes in lexicographical order. Since every path is preceded by
+    // its parents and followed by its descendants, prefix, glob and completion queries visit only the matching
+    // range and skip whole subtrees that can't match, thus they run in time proportional to the number of results
+    // rather than the size of the tree.
+    class CVAR_API PathIndex {
+        private:
+            std::set<std::string, std::less<>> m_paths;
+
+        private:
+            // position after all descendants of _sPath
+            std::set<std::string, std::less<>>::const_iterator _SkipDescendants(std::string_view _sPath, std::string& _sBound) const;
+
+        public:
+            void Clear();
+            // index every node of the tree
+            void Build(const ObjectMap& _root);
+            void Insert(std::string_view _sPath);
+            // erase paths of all nodes below _sPath, _sPath itself is kept
+            void EraseDescendants(std::string_view _sPath);
+            // index every node of _contents, which is the object at _sPath
+            void InsertDescendants(std::string_view _sPath, const ObjectMap& _contents);
+
+            inline size_t Size() const {
+                return m_paths.size();
+            }
+
+            inline bool Contains(std::string_view _sPath) const {
+                return m_paths.find(_sPath) != m_paths.end();
+            }
+
+            // paths starting with _sPrefix, which doesn't have to end at a segment boundary
+            std::vector<std::string> FindPrefix(std::string_view _sPrefix, size_t _uMax = SIZE_MAX) const;
+
+            // paths matching _sPattern, where '*' matches any characters and '?' a single character within one
+            // segment. A trailing "**" segment matches one or more segments, e.g. "render.*.enabled" or "net.**".
+            // NOTE: "**" is only supported as the last segment, anywhere else it matches a single segment like '*'
+            std::vector<std::string> FindGlob(std::string_view _sPattern, size_t _uMax = SIZE_MAX) const;
+
+            // candidates for the last, partially typed segment of _sPartial, e.g. "render.sha" yields
+            // "render.shader" and "render.shadow" but none of their children
+            std::vector<std::string> Complete(std::string_view _sPartial, size_t _uMax = SIZE_MAX) const;
+    };
+}
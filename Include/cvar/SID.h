@@ -118,14 +118,9 @@ namespace cvar {
     uint32_t RuntimeCrc32(const std::string& _str);
     uint32_t RuntimeCrc32(const char* _szData);
     uint32_t RuntimeCrc32(const char* _szData, size_t _uLen);
+    // continue hashing from previously calculated hash value as if _szData was appended to the original string
+    uint32_t RuntimeCrc32(uint32_t _uHash, const char* _szData, size_t _uLen);
 
-#if defined(ENV32)
-    #define CONSTEXPR_SID(x) (cvar::crc32<sizeof(x) - 2>(x) ^ 0xffffffff)
-    #define RUNTIME_CRC(x) cvar::RuntimeCrc32(x)
-#elif defined(ENV64)
-    #define CONSTEXPR_SID(x) (cvar::crc64<sizeof(x) - 2>(x) ^ 0xffffffffffffffff)
-    #define RUNTIME_CRC(x) cvar::RuntimeCrc64(x)
-#endif
 
     static constexpr uint64_t crc64_table[256] = {
         0x0000000000000000, 0xb32e4cbe03a75f6f, 0xf4843657a840a05b, 0x47aa7ae9abe7ff34,
@@ -208,6 +203,93 @@ namespace cvar {
     uint64_t RuntimeCrc64(const std::string& _str);
     uint64_t RuntimeCrc64(const char* _szData);
     uint64_t RuntimeCrc64(const char* _szData, size_t _uLen);
+    uint64_t RuntimeCrc64(uint64_t _uHash, const char* _szData, size_t _uLen);
+
+    // constexpr counterparts of RuntimeCrc32() and RuntimeCrc64() which operate on arbitrary character ranges
+    constexpr uint32_t ConstexprCrc32(const char* _szData, size_t _uLen) {
+        uint32_t uHash = 0;
+        for (size_t i = 0; i < _uLen; i++)
+            uHash = (uHash >> 8) ^ crc32_table[(uHash ^ _szData[i]) & 0xff];
+        return uHash ^ 0xffffffff;
+    }
+
+    constexpr uint64_t ConstexprCrc64(const char* _szData, size_t _uLen) {
+        uint64_t uHash = 0;
+        for (size_t i = 0; i < _uLen; i++)
+            uHash = (uHash >> 8) ^ crc64_table[(uHash ^ _szData[i]) & 0xff];
+        return uHash ^ 0xffffffffffffffff;
+    }
+
+    // CRC-32C (Castagnoli polynomial) can be computed with a single instruction per 8 bytes on x86 with SSE4.2
+    // and on ARMv8 with the CRC extension, the table driven implementation is used everywhere else. Unlike the
+    // CRC-32 and CRC-64 functions above, it uses the standard initial value, thus "123456789" hashes to 0xe3069283.
+    // NOTE: with 32 bit hashes distinct keys of large trees do collide, hash keyed lookups compare the key
+    // text as well, but they are slower for every colliding path.
+    struct Crc32cTable {
+        uint32_t arrEntries[256] = {};
+    };
+
+    constexpr Crc32cTable MakeCrc32cTable() {
+        Crc32cTable table;
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t uEntry = i;
+            for (int j = 0; j < 8; j++)
+                uEntry = (uEntry & 1) ? (uEntry >> 1) ^ 0x82f63b78 : (uEntry >> 1);
+            table.arrEntries[i] = uEntry;
+        }
+        return table;
+    }
+
+    static constexpr Crc32cTable crc32c_table = MakeCrc32cTable();
+
+    uint32_t RuntimeCrc32c(const std::string& _str);
+    uint32_t RuntimeCrc32c(const char* _szData);
+    uint32_t RuntimeCrc32c(const char* _szData, size_t _uLen);
+    uint32_t RuntimeCrc32c(uint32_t _uHash, const char* _szData, size_t _uLen);
+    // table driven CRC-32C regardless of what the CPU supports, results are identical to RuntimeCrc32c()
+    uint32_t RuntimeCrc32cSoftware(const char* _szData, size_t _uLen);
+    bool HasHardwareCrc32c();
+
+    constexpr uint32_t ConstexprCrc32c(const char* _szData, size_t _uLen) {
+        uint32_t uHash = 0xffffffff;
+        for (size_t i = 0; i < _uLen; i++)
+            uHash = (uHash >> 8) ^ crc32c_table.arrEntries[(uHash ^ _szData[i]) & 0xff];
+        return uHash ^ 0xffffffff;
+    }
+
+    // Hash backend used for CVar keys and paths. Runtime and constexpr hashes are always computed with
+    // the same algorithm, thus paths hashed at compile time remain valid lookup keys.
+    #define CVAR_HASH_CRC 0
+    #define CVAR_HASH_CRC32C 1
+
+#ifndef CVAR_HASH_BACKEND
+    #define CVAR_HASH_BACKEND CVAR_HASH_CRC
+#endif
+
+#if CVAR_HASH_BACKEND == CVAR_HASH_CRC32C
+    #define RUNTIME_CRC(x) cvar::RuntimeCrc32c(x)
+    #define CONSTEXPR_CRC(x, len) cvar::ConstexprCrc32c(x, len)
+    #define RUNTIME_CRC_RANGE(x, len) cvar::RuntimeCrc32c(x, len)
+    #define RUNTIME_CRC_EXTEND(hash, x, len) cvar::RuntimeCrc32c(static_cast<uint32_t>(hash), x, len)
+#elif defined(ENV32)
+    #define RUNTIME_CRC(x) cvar::RuntimeCrc32(x)
+    #define CONSTEXPR_CRC(x, len) cvar::ConstexprCrc32(x, len)
+    #define RUNTIME_CRC_RANGE(x, len) cvar::RuntimeCrc32(x, len)
+    #define RUNTIME_CRC_EXTEND(hash, x, len) cvar::RuntimeCrc32(static_cast<uint32_t>(hash), x, len)
+#elif defined(ENV64)
+    #define RUNTIME_CRC(x) cvar::RuntimeCrc64(x)
+    #define CONSTEXPR_CRC(x, len) cvar::ConstexprCrc64(x, len)
+    #define RUNTIME_CRC_RANGE(x, len) cvar::RuntimeCrc64(x, len)
+    #define RUNTIME_CRC_EXTEND(hash, x, len) cvar::RuntimeCrc64(static_cast<uint64_t>(hash), x, len)
+#endif
+
+    // string literal hash, uses its own seed and is independent of the selected hash backend, thus its values
+    // are NOT equal to RUNTIME_CRC() of the same string. Use CONSTEXPR_CRC() or CVAR_PATH for lookup keys.
+#if defined(ENV32)
+    #define CONSTEXPR_SID(x) (cvar::crc32<sizeof(x) - 2>(x) ^ 0xffffffff)
+#elif defined(ENV64)
+    #define CONSTEXPR_SID(x) (cvar::crc64<sizeof(x) - 2>(x) ^ 0xffffffffffffffff)
+#endif
     
     #define SID(x) COMPILE_TIME(CONSTEXPR_SID(x))
     typedef std::size_t hash_t;
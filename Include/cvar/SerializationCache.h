@@ -0,0 +1,70 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: SerializationCache.h - cached serialized text of CVar objects header
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <cvar/Api.h>
+
+namespace cvar {
+
+    // SerializationCache keeps the serialized text of every object in the tree. Text of an object is split into
+    // fragments at its nested objects, which are referenced by their path instead of being copied, thus the cache
+    // holds each byte of the output only once. Objects that haven't been marked dirty since the previous save are
+    // written from the cache without serializing their contents again. Entries are keyed by the full path rather
+    // than by its hash, since text cached for one path must never be written in place of a colliding one.
+    class CVAR_API SerializationCache {
+        public:
+            struct Fragment {
+                std::string sText;
+                // path of the nested object whose text follows sText
+                std::string sChild;
+                bool bChild = false;
+            };
+
+        private:
+            struct _Entry {
+                std::vector<Fragment> fragments;
+                uint64_t uSave = 0;
+            };
+
+            // the root object has an empty path
+            std::unordered_map<std::string, _Entry> m_entries;
+            std::unordered_set<std::string> m_dirty;
+            std::string m_sFormat;
+            uint64_t m_uSave = 0;
+
+        public:
+            // cached text is dropped if it was produced with another format
+            void SetFormat(std::string_view _sFormat);
+            void Clear();
+
+            // mark the object or value at _sKey and all objects containing it as modified
+            void MarkDirty(std::string_view _sKey);
+
+            inline bool IsCached(const std::string& _sPath) const {
+                return m_dirty.find(_sPath) == m_dirty.end() && m_entries.find(_sPath) != m_entries.end();
+            }
+
+            inline void Store(const std::string& _sPath, std::vector<Fragment>&& _fragments) {
+                m_entries[_sPath].fragments = std::move(_fragments);
+                m_dirty.erase(_sPath);
+            }
+
+            // write the cached text of the root object, entries of objects that are no longer part of the tree
+            // are released afterwards
+            void Write(std::ostream& _stream);
+
+            inline size_t GetEntryCount() const {
+                return m_entries.size();
+            }
+    };
+}
@@ -0,0 +1,84 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: Snapshot.h - immutable CVar tree snapshot class header
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cvar/Api.h>
+#include <cvar/CVarTypes.h>
+#include <cvar/CVarPath.h>
+#include <cvar/Stats.h>
+#include <cvar/TreeVisitor.h>
+
+namespace cvar {
+
+    // Snapshot is a read-only view to the CVar tree as it was at the time the snapshot was published.
+    // Nodes of a published tree are never modified in place, writers copy the path they modify instead,
+    // thus a snapshot can be read from any thread without locking. Memory of an outdated tree is
+    // reclaimed when the last snapshot referring to it is destroyed.
+    class CVAR_API Snapshot {
+        private:
+            std::shared_ptr<const Object> m_pRoot;
+
+        public:
+            Snapshot() = default;
+            Snapshot(const std::shared_ptr<const Object>& _pRoot) :
+                m_pRoot(_pRoot) {}
+
+            inline const Value* GetValue(const std::string& _key) const {
+                if (!m_pRoot)
+                    return nullptr;
+                return FindTreeNode(m_pRoot->GetContents(), _key);
+            }
+
+            template <size_t N>
+            inline const Value* GetValue(const CVarPath<N>& _path) const {
+                if (!m_pRoot)
+                    return nullptr;
+                return FindTreeNode(m_pRoot->GetContents(), _path.arrHashes, _path.arrSegments, N);
+            }
+
+            template <typename T>
+            inline const T* Get(const std::string& _key) const {
+                const Value* pDesc = GetValue(_key);
+                if (pDesc)
+                    return std::get_if<T>(pDesc);
+                return nullptr;
+            }
+
+            template <typename T, size_t N>
+            inline const T* Get(const CVarPath<N>& _path) const {
+                const Value* pDesc = GetValue(_path);
+                if (pDesc)
+                    return std::get_if<T>(pDesc);
+                return nullptr;
+            }
+
+            // visit every node under _sPrefix, see cvar::ForEach()
+            template <typename Visitor>
+            inline void ForEach(const std::string& _sPrefix, Visitor&& _visitor) const {
+                if (m_pRoot)
+                    cvar::ForEach(m_pRoot->GetContents(), _sPrefix, std::forward<Visitor>(_visitor));
+            }
+
+            // memory statistics of the subtree at _sPrefix, safe to call from any thread
+            inline TreeStats Stats(const std::string& _sPrefix = "", const StatsOptions& _options = StatsOptions()) const {
+                if (!m_pRoot)
+                    return TreeStats();
+                return CollectStats(m_pRoot->GetContents(), _sPrefix, _options);
+            }
+
+            inline const ObjectMap& GetRoot() const {
+                return m_pRoot->GetContents();
+            }
+
+            inline const std::shared_ptr<const Object>& GetRootObject() const {
+                return m_pRoot;
+            }
+
+            inline explicit operator bool() const {
+                return m_pRoot != nullptr;
+            }
+    };
+}
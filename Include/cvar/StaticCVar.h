@@ -0,0 +1,228 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: StaticCVar.h - statically declared typed CVar storage header
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <cvar/Api.h>
+#include <cvar/CVarTypes.h>
+
+// define a variable that is registered with CVarSystem during static initialization, optionally followed by
+// the minimum and maximum value for Int and Float variables, e.g.
+// CVAR_DEFINE(g_gamma, Float, "render.gamma", 2.2f, 1.0f, 3.0f);
+#define CVAR_DEFINE(name, type, key, ...) cvar::StaticCVar<cvar::type> name(key, __VA_ARGS__)
+#define CVAR_DECLARE(name, type) extern cvar::StaticCVar<cvar::type> name
+
+namespace cvar {
+
+    template <typename T>
+    struct StaticTraits {
+        static constexpr bool bSupported = false;
+    };
+
+    template <>
+    struct StaticTraits<Int> {
+        static constexpr bool bSupported = true;
+        static constexpr bool bRanged = true;
+    };
+
+    template <>
+    struct StaticTraits<Float> {
+        static constexpr bool bSupported = true;
+        static constexpr bool bRanged = true;
+    };
+
+    template <>
+    struct StaticTraits<Bool> {
+        static constexpr bool bSupported = true;
+        static constexpr bool bRanged = false;
+    };
+
+    template <>
+    struct StaticTraits<String> {
+        static constexpr bool bSupported = true;
+        static constexpr bool bRanged = false;
+    };
+
+    // StaticCVarBase is the type erased part of a statically declared variable, which CVarSystem uses to
+    // write tree values through to the typed storage
+    class CVAR_API StaticCVarBase {
+        friend class CVarSystem;
+
+        protected:
+            std::string m_sKey;
+            hash_t m_hshKey;
+            bool m_bRegistered = false;
+
+        protected:
+            StaticCVarBase(const char* _szKey) :
+                m_sKey(_szKey),
+                m_hshKey(RUNTIME_CRC(m_sKey)) {}
+            ~StaticCVarBase();
+
+            StaticCVarBase(const StaticCVarBase&) = delete;
+            StaticCVarBase& operator=(const StaticCVarBase&) = delete;
+
+            // registration must happen after the derived storage has been initialized. Only one variable can be
+            // defined for each key, later definitions of the same key are left unregistered.
+            void _Register();
+
+            // write the value to the variable tree of CVarSystem instance
+            bool _WriteThrough(Value&& _val);
+
+            // convert and clamp _val and copy it into the storage, if _val can't be represented it is replaced
+            // with the current value. Returns true if _val was modified.
+            virtual bool _Store(Value& _val) = 0;
+
+        public:
+            inline const std::string& GetKey() const {
+                return m_sKey;
+            }
+
+            // false if another variable with the same key was already defined, unregistered variables only
+            // keep their own value and don't follow the variable tree
+            inline bool IsRegistered() const {
+                return m_bRegistered;
+            }
+    };
+
+    // StaticCVar keeps the value of a variable in a plain typed member, which can be read without any lookups
+    // or variant dispatch. Writes made through the tree, unserialization or the console are written through
+    // to the storage and clamped to the declared range.
+    // NOTE: the storage is written by the thread that modifies CVarSystem and isn't synchronized.
+    template <typename T>
+    class StaticCVar : public StaticCVarBase {
+        static_assert(StaticTraits<T>::bSupported, "Only Int, Float, Bool and String variables can be defined statically");
+
+        private:
+            T m_value;
+            T m_default;
+            T m_min = T();
+            T m_max = T();
+            bool m_bRanged = false;
+
+        private:
+            inline bool _Clamp(T& _val) const {
+                if constexpr (StaticTraits<T>::bRanged) {
+                    if (!m_bRanged)
+                        return false;
+
+                    // NaN is not within any range
+                    if (_val != _val) {
+                        _val = m_value;
+                        return true;
+                    }
+
+                    const T clamped = std::clamp(_val, m_min, m_max);
+                    if (clamped != _val) {
+                        _val = clamped;
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+        protected:
+            bool _Store(Value& _val) override {
+                // numbers entered from the console or files might not carry the declared type
+                bool bConverted = false;
+                if constexpr (std::is_same_v<T, Float>) {
+                    if (const Int* pInt = std::get_if<Int>(&_val)) {
+                        _val.emplace<Float>(static_cast<Float>(*pInt));
+                        bConverted = true;
+                    }
+                }
+                else if constexpr (std::is_same_v<T, Int>) {
+                    if (const Float* pFloat = std::get_if<Float>(&_val)) {
+                        // casting NaN or a value outside of the Int range is undefined, NaN is rejected and other
+                        // values are saturated. -min is a power of two, thus it is exactly representable as Float.
+                        const Float fLimit = -static_cast<Float>(std::numeric_limits<Int>::min());
+                        if (*pFloat != *pFloat)
+                            _val.emplace<Int>(m_value);
+                        else if (*pFloat >= fLimit)
+                            _val.emplace<Int>(std::numeric_limits<Int>::max());
+                        else if (*pFloat < -fLimit)
+                            _val.emplace<Int>(std::numeric_limits<Int>::min());
+                        else _val.emplace<Int>(static_cast<Int>(*pFloat));
+                        bConverted = true;
+                    }
+                }
+
+                T* pVal = std::get_if<T>(&_val);
+                if (!pVal) {
+                    _val.template emplace<T>(m_value);
+                    return true;
+                }
+
+                const bool bClamped = _Clamp(*pVal);
+                m_value = *pVal;
+                return bClamped || bConverted;
+            }
+
+        public:
+            StaticCVar(const char* _szKey, const T& _default) :
+                StaticCVarBase(_szKey),
+                m_value(_default),
+                m_default(_default)
+            {
+                _Register();
+            }
+
+            template <typename U = T, typename = std::enable_if_t<StaticTraits<U>::bRanged>>
+            StaticCVar(const char* _szKey, const T& _default, const T& _min, const T& _max) :
+                StaticCVarBase(_szKey),
+                m_value(std::clamp(_default, _min, _max)),
+                m_default(m_value),
+                m_min(_min),
+                m_max(_max),
+                m_bRanged(true)
+            {
+                _Register();
+            }
+
+            inline const T& Get() const {
+                return m_value;
+            }
+
+            inline operator const T&() const {
+                return m_value;
+            }
+
+            inline const T& GetDefault() const {
+                return m_default;
+            }
+
+            inline const T& GetMin() const {
+                return m_min;
+            }
+
+            inline const T& GetMax() const {
+                return m_max;
+            }
+
+            inline bool IsRanged() const {
+                return m_bRanged;
+            }
+
+            // clamp the value, store it and write it to the variable tree
+            inline bool Set(const T& _val) {
+                T val = _val;
+                _Clamp(val);
+                m_value = val;
+                return _WriteThrough(Value(std::in_place_type<T>, std::move(val)));
+            }
+
+            inline StaticCVar& operator=(const T& _val) {
+                Set(_val);
+                return *this;
+            }
+
+            inline bool Reset() {
+                return Set(m_default);
+            }
+    };
+}
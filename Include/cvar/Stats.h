@@ -0,0 +1,68 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: Stats.h - CVar tree memory accounting and statistics header
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cvar/CVarTypes.h>
+
+namespace cvar {
+
+    struct StatsOptions {
+        // inspect every Nth entry of each object and extrapolate the rest, 1 walks the whole tree
+        size_t uSampleInterval = 1;
+        // selects which entries are sampled, periodic callers should change it between calls so that
+        // different entries get inspected over time
+        size_t uSampleSeed = 0;
+        // number of largest object subtrees to report
+        size_t uLargestCount = 8;
+    };
+
+    struct SubtreeStats {
+        std::string sPath;
+        size_t uNodes = 0;
+        size_t uBytes = 0;
+    };
+
+    // TreeStats describes the memory used by a subtree. Sizes are measured from container capacities and
+    // include allocator independent overhead only, thus they are a lower bound of the actual heap usage.
+    struct TreeStats {
+        // node counts indexed by Type
+        size_t arrNodeCounts[Type_Object + 1] = {};
+        // length of distinct key texts, keys are interned and each text is counted once. Sampled statistics
+        // include only the keys of sampled entries.
+        size_t uKeyBytes = 0;
+        // out of line string text blocks, short strings are stored within the value itself
+        size_t uStringBytes = 0;
+        // list blocks, element storage and packed arrays
+        size_t uListBytes = 0;
+        // object maps including the inline storage of their values
+        size_t uMapBytes = 0;
+        // depth of the deepest node below the prefix, children of the prefix have depth 1
+        size_t uMaxDepth = 0;
+        // largest object subtrees, sorted by size in descending order
+        std::vector<SubtreeStats> largestSubtrees;
+        // true if the values are extrapolated from sampled entries
+        bool bSampled = false;
+
+        inline size_t GetNodeCount() const {
+            size_t uCount = 0;
+            for (size_t uNodes : arrNodeCounts)
+                uCount += uNodes;
+            return uCount;
+        }
+
+        inline size_t GetTotalBytes() const {
+            return uKeyBytes + uStringBytes + uListBytes + uMapBytes;
+        }
+    };
+
+    // collect statistics of the subtree at _sPrefix, empty prefix selects the whole tree. The tree is walked
+    // iteratively, thus arbitrarily deep trees are supported. Call it on a Snapshot to collect statistics
+    // from another thread.
+    TreeStats CollectStats(const ObjectMap& _root, const std::string& _sPrefix = "",
+                           const StatsOptions& _options = StatsOptions());
+}
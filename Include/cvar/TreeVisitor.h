@@ -0,0 +1,82 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: TreeVisitor.h - prefix scoped CVar tree iteration header
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <cvar/CVarTypes.h>
+
+namespace cvar {
+
+    enum class VisitResult {
+        Continue,   // descend into the node if it is an object
+        Skip,       // don't descend into the object
+        Stop        // end the iteration
+    };
+
+    // ForEach calls _visitor(std::string_view _sPath, const Value& _val) for every node under _sPrefix in insertion
+    // order, objects are visited before their contents. The visitor may return a VisitResult to prune subtrees or to
+    // stop the iteration, visitors returning void visit the whole subtree. Paths are built in a single buffer that is
+    // reused between nodes, thus the view is valid only until the visitor returns. If _sPrefix refers to a leaf, only
+    // the leaf itself is visited.
+    // NOTE: the tree must not be modified while it is being visited
+    template <typename Visitor>
+    void ForEach(const ObjectMap& _root, const std::string& _sPrefix, Visitor&& _visitor) {
+        constexpr bool bPrunable = !std::is_void_v<std::invoke_result_t<Visitor&, std::string_view, const Value&>>;
+
+        std::string sPath = _sPrefix;
+        const ObjectMap* pRoot = &_root;
+        if (!_sPrefix.empty()) {
+            const Value* pNode = FindTreeNode(_root, _sPrefix);
+            if (!pNode)
+                return;
+
+            auto pObject = std::get_if<std::shared_ptr<Object>>(pNode);
+            if (!pObject) {
+                _visitor(std::string_view(sPath), *pNode);
+                return;
+            }
+            pRoot = &pObject->get()->GetContents();
+        }
+
+        // frames remember the length of their own path, which entry keys are appended to
+        struct Frame {
+            const ObjectMap* pMap;
+            size_t uIndex;
+            size_t uPathLength;
+        };
+
+        std::vector<Frame> stckFrames;
+        stckFrames.push_back({ pRoot, 0, sPath.size() });
+        while (!stckFrames.empty()) {
+            Frame& top = stckFrames.back();
+            if (top.uIndex == top.pMap->size()) {
+                stckFrames.pop_back();
+                continue;
+            }
+
+            const ObjectMap::value_type& entry = *ObjectMap::const_iterator(top.pMap, top.uIndex++);
+            sPath.resize(top.uPathLength);
+            if (!sPath.empty())
+                sPath += '.';
+            sPath += entry.first.GetSTDString();
+
+            VisitResult result = VisitResult::Continue;
+            if constexpr (bPrunable)
+                result = _visitor(std::string_view(sPath), entry.second);
+            else _visitor(std::string_view(sPath), entry.second);
+
+            if (result == VisitResult::Stop)
+                return;
+
+            auto pObject = std::get_if<std::shared_ptr<Object>>(&entry.second);
+            if (pObject && result == VisitResult::Continue)
+                stckFrames.push_back({ &pObject->get()->GetContents(), 0, sPath.size() });
+        }
+    }
+}
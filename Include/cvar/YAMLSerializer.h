@@ -0,0 +1,34 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: YAMLSerializer.h - YAML serializer class header
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cvar/Api.h>
+#include <cvar/ISerializer.h>
+
+namespace cvar {
+
+    // YAMLSerializer writes the tree as block mappings indented by two spaces, lists of scalars are written in flow
+    // style on a single line. Compact output writes the whole tree as a single flow mapping. Strings that could
+    // be read back as another type are quoted, floats always keep a fractional part.
+    class CVAR_API YAMLSerializer : public ISerializer<ObjectMap> {
+        private:
+            std::string m_buffer;
+
+        private:
+            void _Flush();
+            void _WriteString(std::string_view _sText);
+            // write a scalar or a list of scalars, returns false for other values
+            bool _WriteInline(const Value& _val);
+            void _SerializeBlock();
+            void _SerializeFlow();
+
+        public:
+            YAMLSerializer(std::ostream& _stream, ObjectMap& _root);
+            virtual void Serialize(bool _bBeautified = true) override;
+    };
+}
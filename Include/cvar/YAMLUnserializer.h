@@ -0,0 +1,55 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: YAMLUnserializer.h - YAML unserializer class header
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <cvar/Api.h>
+#include <cvar/ISerializer.h>
+
+namespace cvar {
+
+    // YAMLUnserializer reads the first document of a YAML stream line by line in a single pass. Block mappings and
+    // sequences are built directly with an explicit stack of open containers, flow collections, quoted scalars and
+    // literal or folded block scalars are supported. Plain scalars are resolved as in the YAML 1.2 core schema,
+    // integers outside of the Int range are stored as Float and null values as empty values.
+    // NOTE: anchors, aliases, tags, complex keys and multi-line plain scalars are not supported
+    class CVAR_API YAMLUnserializer : public IPlainTextUnserializer<ObjectMap> {
+        private:
+            std::string m_sLine;
+            size_t m_uPos = 0;
+            uint32_t m_uLineCounter = 0;
+            // the current line is returned again by the next _ReadLine() call
+            bool m_bUnread = false;
+            bool m_bContent = false;
+            bool m_bDocumentEnd = false;
+
+        private:
+            [[noreturn]] void _Error(const std::string& _sWhat) const;
+
+            bool _ReadLine();
+            // read lines until one with content is found, the position is set to its first character
+            bool _NextContentLine();
+            void _SkipSpaces();
+            // true if only whitespace or a comment is left on the current line
+            bool _AtLineEnd();
+            bool _IsSequenceItem() const;
+            bool _IsMappingEntry() const;
+
+            std::string _ParseQuoted();
+            std::string _ParsePlain(bool _bFlow);
+            Symbol _ParseKey(bool _bFlow);
+            std::string _ParseBlockScalar(int32_t _iParentIndent);
+            // parse a flow collection whose opening bracket has been consumed into given container
+            void _ParseFlow(ObjectMap* _pMap, List* _pList);
+            // parse the value that follows a key or a sequence item on the current line
+            Value _ParseValue(int32_t _iParentIndent);
+            void _Parse();
+
+        public:
+            YAMLUnserializer(std::istream& _stream);
+    };
+}
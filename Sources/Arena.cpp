@@ -0,0 +1,32 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: Arena.cpp - arena memory resource for CVar tree nodes implementation
+// author: Karl-Mihkel Ott
+
+#include <cvar/Arena.h>
+
+namespace cvar {
+
+	static thread_local Arena* s_pCurrentArena = nullptr;
+
+	Arena* Arena::GetCurrent() {
+		return s_pCurrentArena;
+	}
+
+
+	std::pmr::memory_resource* Arena::GetCurrentResource() {
+		return s_pCurrentArena ? s_pCurrentArena->GetResource() : std::pmr::new_delete_resource();
+	}
+
+
+	ArenaScope::ArenaScope(const std::shared_ptr<Arena>& _pArena) :
+		m_pPrevious(s_pCurrentArena)
+	{
+		s_pCurrentArena = _pArena.get();
+	}
+
+
+	ArenaScope::~ArenaScope() {
+		s_pCurrentArena = m_pPrevious;
+	}
+}
@@ -0,0 +1,181 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: BinarySerializer.cpp - binary CVar image serializer class implementation
+// author: Karl-Mihkel Ott
+
+#include <cvar/BinarySerializer.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace cvar {
+
+    BinarySerializer::BinarySerializer(std::ostream& _stream, ObjectMap& _root) :
+        ISerializer(_stream, _root) {}
+
+
+    uint32_t BinarySerializer::_Allocate(size_t _uSize) {
+        const size_t uOffset = m_image.size();
+        const size_t uAligned = (_uSize + s_uBinaryAlignment - 1) & ~(s_uBinaryAlignment - 1);
+        if (uOffset + uAligned > UINT32_MAX)
+            throw std::length_error("Binary CVar image would exceed 4 GiB");
+
+        m_image.resize(uOffset + uAligned);
+        return static_cast<uint32_t>(uOffset);
+    }
+
+
+    uint32_t BinarySerializer::_WriteString(std::string_view _sText, hash_t _hshText) {
+        const uint32_t uOffset = _Allocate(sizeof(BinaryString) + _sText.size() + 1);
+        const BinaryString string = { static_cast<uint64_t>(_hshText), static_cast<uint32_t>(_sText.size()), 0 };
+        std::memcpy(m_image.data() + uOffset, &string, sizeof(BinaryString));
+        if (!_sText.empty())
+            std::memcpy(m_image.data() + uOffset + sizeof(BinaryString), _sText.data(), _sText.size());
+        return uOffset;
+    }
+
+
+    BinarySlot BinarySerializer::_MakeSlot(const Value& _val, size_t _uSlotOffset) {
+        BinarySlot slot = { static_cast<uint8_t>(_val.index()), {}, 0 };
+
+        switch (_val.index()) {
+            case Type_Int:
+                std::memcpy(&slot.uData, &std::get<Type_Int>(_val), sizeof(Int));
+                break;
+
+            case Type_Float:
+                std::memcpy(&slot.uData, &std::get<Type_Float>(_val), sizeof(Float));
+                break;
+
+            case Type_Bool:
+                slot.uData = std::get<Type_Bool>(_val) ? 1 : 0;
+                break;
+
+            case Type_String:
+            {
+                const String& str = std::get<Type_String>(_val);
+                slot.uData = _WriteString(str.GetView(), str.GetHash());
+                break;
+            }
+
+            // blocks of nested values are written once the current block is complete
+            case Type_List:
+            case Type_Object:
+                m_pending.push_back(std::make_pair(_uSlotOffset, &_val));
+                break;
+
+            default:
+                break;
+        }
+
+        return slot;
+    }
+
+
+    uint32_t BinarySerializer::_WriteObject(const ObjectMap& _contents) {
+        const uint32_t uCount = static_cast<uint32_t>(_contents.size());
+        const uint32_t uOffset = _Allocate(sizeof(BinaryObject) + uCount * (sizeof(BinaryEntry) + sizeof(uint32_t)));
+        const BinaryObject object = { uCount, 0 };
+        std::memcpy(m_image.data() + uOffset, &object, sizeof(BinaryObject));
+
+        std::vector<uint32_t> sorted;
+        sorted.reserve(uCount);
+        uint32_t uIndex = 0;
+        for (auto it = _contents.begin(); it != _contents.end(); it++, uIndex++) {
+            // symbols are interned, thus each distinct key is written only once
+            const std::string& sKey = it->first.GetSTDString();
+            auto itKey = m_keys.find(&sKey);
+            if (itKey == m_keys.end())
+                itKey = m_keys.emplace(&sKey, _WriteString(sKey, it->first.GetHash())).first;
+
+            const size_t uEntryOffset = uOffset + sizeof(BinaryObject) + uIndex * sizeof(BinaryEntry);
+            BinaryEntry entry = { static_cast<uint64_t>(it->first.GetHash()), itKey->second, 0, {} };
+            entry.slot = _MakeSlot(it->second, uEntryOffset + offsetof(BinaryEntry, slot));
+            std::memcpy(m_image.data() + uEntryOffset, &entry, sizeof(BinaryEntry));
+            sorted.push_back(uIndex);
+        }
+
+        // index of entries sorted by key hash is used for binary search lookups
+        const char* pEntries = m_image.data() + uOffset + sizeof(BinaryObject);
+        auto hashOf = [pEntries](uint32_t _uEntry) {
+            uint64_t uHash;
+            std::memcpy(&uHash, pEntries + _uEntry * sizeof(BinaryEntry), sizeof(uint64_t));
+            return uHash;
+        };
+        std::sort(sorted.begin(), sorted.end(), [&](uint32_t _uFirst, uint32_t _uSecond) {
+            return hashOf(_uFirst) < hashOf(_uSecond);
+        });
+
+        if (uCount)
+            std::memcpy(m_image.data() + uOffset + sizeof(BinaryObject) + uCount * sizeof(BinaryEntry), sorted.data(), uCount * sizeof(uint32_t));
+        return uOffset;
+    }
+
+
+    uint32_t BinarySerializer::_WriteList(const List& _list) {
+        const Type packedType = _list.GetPackedType();
+        const uint32_t uCount = static_cast<uint32_t>(_list.Size());
+
+        if (packedType != Type_None) {
+            const size_t uItemSize = packedType == Type_Bool ? sizeof(Bool) : sizeof(Int);
+            const uint32_t uOffset = _Allocate(sizeof(BinaryList) + uCount * uItemSize);
+            const BinaryList list = { uCount, static_cast<uint32_t>(packedType) };
+            std::memcpy(m_image.data() + uOffset, &list, sizeof(BinaryList));
+
+            const void* pData = nullptr;
+            if (packedType == Type_Int)
+                pData = _list.GetSpan<Int>().data();
+            else if (packedType == Type_Float)
+                pData = _list.GetSpan<Float>().data();
+            else pData = _list.GetSpan<Bool>().data();
+
+            if (uCount)
+                std::memcpy(m_image.data() + uOffset + sizeof(BinaryList), pData, uCount * uItemSize);
+            return uOffset;
+        }
+
+        const uint32_t uOffset = _Allocate(sizeof(BinaryList) + uCount * sizeof(BinarySlot));
+        const BinaryList list = { uCount, Type_None };
+        std::memcpy(m_image.data() + uOffset, &list, sizeof(BinaryList));
+
+        size_t uSlotOffset = uOffset + sizeof(BinaryList);
+        for (auto it = _list.Begin(); it != _list.End(); it++, uSlotOffset += sizeof(BinarySlot)) {
+            const BinarySlot slot = _MakeSlot(*it, uSlotOffset);
+            std::memcpy(m_image.data() + uSlotOffset, &slot, sizeof(BinarySlot));
+        }
+
+        return uOffset;
+    }
+
+
+    void BinarySerializer::Serialize(bool) {
+        m_image.clear();
+        m_keys.clear();
+        m_pending.clear();
+
+        _Allocate(sizeof(BinaryHeader));
+        const uint32_t uRootOffset = _WriteObject(m_root);
+
+        // every block is placed after the block that refers to it
+        while (!m_pending.empty()) {
+            const auto pending = m_pending.back();
+            m_pending.pop_back();
+
+            uint32_t uBlockOffset = 0;
+            if (const List* pList = std::get_if<List>(pending.second))
+                uBlockOffset = _WriteList(*pList);
+            else uBlockOffset = _WriteObject(std::get<std::shared_ptr<Object>>(*pending.second)->GetContents());
+
+            std::memcpy(m_image.data() + pending.first + offsetof(BinarySlot, uData), &uBlockOffset, sizeof(uint32_t));
+        }
+
+        BinaryHeader header = {};
+        std::memcpy(header.szMagic, s_szBinaryMagic, sizeof(s_szBinaryMagic));
+        header.uHashId = s_uBinaryHashId;
+        header.uRootOffset = uRootOffset;
+        header.uSize = static_cast<uint32_t>(m_image.size());
+        std::memcpy(m_image.data(), &header, sizeof(BinaryHeader));
+
+        m_stream.write(m_image.data(), static_cast<std::streamsize>(m_image.size()));
+    }
+}
@@ -0,0 +1,47 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: BinaryUnserializer.cpp - binary CVar image unserializer class implementation
+// author: Karl-Mihkel Ott
+
+#include <cvar/BinaryUnserializer.h>
+#include <cvar/MappedConfig.h>
+#include <cvar/SerializerExceptions.h>
+#include <memory>
+
+namespace cvar {
+
+    BinaryUnserializer::BinaryUnserializer(std::istream& _stream) :
+        IUnserializer<ObjectMap>(_stream)
+    {
+        _Load();
+    }
+
+
+    void BinaryUnserializer::_Load() {
+        // buffered stream has already consumed the beginning of the file, the image is read again as a whole
+        std::istream& stream = m_stream.raw();
+        stream.clear();
+        stream.seekg(0, std::ios_base::end);
+        const std::streamoff uLength = stream.tellg();
+        stream.seekg(0, std::ios_base::beg);
+
+        // assume empty file is used
+        if (uLength <= 0)
+            return;
+
+        // image blocks must be 8 byte aligned
+        std::unique_ptr<uint64_t[]> data = std::make_unique<uint64_t[]>((static_cast<size_t>(uLength) + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+        if (!stream.read(reinterpret_cast<char*>(data.get()), uLength))
+            throw UnexpectedEOFException("Binary CVar image is incomplete");
+
+        BinaryImage image;
+        image.pData = reinterpret_cast<const char*>(data.get());
+        image.uSize = static_cast<size_t>(uLength);
+        const BinaryObject* pRoot = image.Validate();
+        if (!pRoot)
+            throw SyntaxErrorException("Invalid binary CVar image");
+
+        const BinarySlot root = { Type_Object, {}, static_cast<uint32_t>(reinterpret_cast<const char*>(pRoot) - image.pData) };
+        MappedValue(&image, root).MaterializeInto(m_root);
+    }
+}
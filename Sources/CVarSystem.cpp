@@ -4,61 +4,710 @@
 // author: Karl-Mihkel Ott
 
 #include <cvar/CVarSystem.h>
-#include <queue>
+#include <algorithm>
+#include <numeric>
+#include <stack>
+#include <unordered_set>
 
 namespace cvar {
 
-    std::vector<String> CVarSystem::_HashKeyWords(const std::string& _key) {
-		std::queue<std::string> qKeyWords;
+	Value* CVarSystem::_FindNode(const std::string& _key) {
+		const hash_t hshPath = RUNTIME_CRC(_key);
+		auto itIndex = m_flatIndex.find(hshPath);
+		if (itIndex != m_flatIndex.end() && itIndex->second.sPath == _key)
+			return itIndex->second.pNode;
+
+		// index miss: walk the tree and remember the result, unless another path with the same hash is indexed
+		Value* pNode = const_cast<Value*>(FindTreeNode(m_pRoot->GetContents(), _key));
+		if (pNode && itIndex == m_flatIndex.end())
+			m_flatIndex.emplace(hshPath, _IndexEntry{ pNode, _key });
+		return pNode;
+	}
+
+
+	Value* CVarSystem::_FindNode(const hash_t* _pHashes, const std::string_view* _pSegments, size_t _uCount, hash_t _hshPath, std::string_view _sPath) {
+		auto itIndex = m_flatIndex.find(_hshPath);
+		if (itIndex != m_flatIndex.end() && itIndex->second.sPath == _sPath)
+			return itIndex->second.pNode;
+
+		Value* pNode = const_cast<Value*>(FindTreeNode(m_pRoot->GetContents(), _pHashes, _pSegments, _uCount));
+		if (pNode && itIndex == m_flatIndex.end())
+			m_flatIndex.emplace(_hshPath, _IndexEntry{ pNode, std::string(_sPath) });
+		return pNode;
+	}
+
+
+	Value* CVarSystem::_FindWritableNode(const std::string& _key) {
+		Value* pNode = nullptr;
+		ObjectMap* pNodeTable = &_Detach(m_pRoot)->GetContents();
 
-		size_t uPos = 0;
 		size_t uBeginPos = 0;
+		while (uBeginPos < _key.size()) {
+			size_t uPos = _key.find('.', uBeginPos);
+			if (uPos == std::string::npos)
+				uPos = _key.size();
+
+			if (pNode) {
+				auto pObject = std::get_if<std::shared_ptr<Object>>(pNode);
+				if (!pObject)
+					return nullptr;
+				pNodeTable = &_Detach(*pObject)->GetContents();
+			}
+
+			const std::string_view sSegment(_key.c_str() + uBeginPos, uPos - uBeginPos);
+			auto itNode = pNodeTable->find(sSegment, RUNTIME_CRC_RANGE(sSegment.data(), sSegment.size()));
+			if (itNode == pNodeTable->end())
+				return nullptr;
 
-		const char cDelim = '.';
-		while ((uPos = _key.find(cDelim, uBeginPos)) != std::string::npos) {
-			qKeyWords.push(_key.substr(uBeginPos, uPos - uBeginPos));
+			pNode = &itNode->second;
 			uBeginPos = uPos + 1;
 		}
 
-		if (uBeginPos != _key.size())
-			qKeyWords.push(_key.substr(uBeginPos));
+		return pNode;
+	}
+
 
-		std::vector<String> hashes;
-		hashes.reserve(qKeyWords.size());
+	Value* CVarSystem::_FindOrCreateNode(std::string_view _sKey) {
+		Value* pNode = nullptr;
+		ObjectMap* pNodeTable = &_Detach(m_pRoot)->GetContents();
+
+		size_t uBeginPos = 0;
+		while (uBeginPos < _sKey.size()) {
+			size_t uPos = _sKey.find('.', uBeginPos);
+			if (uPos == std::string_view::npos)
+				uPos = _sKey.size();
+
+			if (pNode) {
+				// newly created parent nodes become objects
+				if (std::holds_alternative<std::monostate>(*pNode))
+					pNode->emplace<std::shared_ptr<Object>>(std::make_shared<Object>());
 
-		while (!qKeyWords.empty()) {
-			hashes.emplace_back(qKeyWords.front());
-			qKeyWords.pop();
+				auto pObject = std::get_if<std::shared_ptr<Object>>(pNode);
+				if (!pObject)
+					return nullptr;
+				pNodeTable = &_Detach(*pObject)->GetContents();
+			}
+
+			// a single probe for existing nodes, key is only interned for new ones
+			const hash_t hshSegment = RUNTIME_CRC_RANGE(_sKey.data() + uBeginPos, uPos - uBeginPos);
+			const std::string_view sSegment = _sKey.substr(uBeginPos, uPos - uBeginPos);
+			auto itNode = pNodeTable->find(sSegment, hshSegment);
+			if (itNode == pNodeTable->end()) {
+				itNode = pNodeTable->try_emplace(Symbol(sSegment, hshSegment)).first;
+				m_uRevision++;
+				if (m_bPathIndexing)
+					m_pathIndex.Insert(_sKey.substr(0, uPos));
+			}
+
+			pNode = &itNode->second;
+			uBeginPos = uPos + 1;
 		}
 
-		return hashes;
+		return pNode;
 	}
 
 
-	Value* CVarSystem::_FindNode(const std::string& _key) {
-		auto hashes = _HashKeyWords(_key);
+	Value* CVarSystem::_FindOrCreateNode(const hash_t* _pHashes, const std::string_view* _pSegments, size_t _uCount) {
 		Value* pNode = nullptr;
-		std::unordered_map<String, Value>* pNodeTable = &m_root;
+		ObjectMap* pNodeTable = &_Detach(m_pRoot)->GetContents();
+
+		for (size_t i = 0; i < _uCount; i++) {
+			if (pNode) {
+				if (std::holds_alternative<std::monostate>(*pNode))
+					pNode->emplace<std::shared_ptr<Object>>(std::make_shared<Object>());
 
-		for (size_t i = 0; i < hashes.size(); i++) {
-			auto itNode = pNodeTable->find(hashes[i]);
-			if (itNode != pNodeTable->end()) {
-				pNode = &itNode->second;
 				auto pObject = std::get_if<std::shared_ptr<Object>>(pNode);
-				
-				if (i != hashes.size() - 1 && !pObject)
+				if (!pObject)
 					return nullptr;
-				else if (i != hashes.size() - 1) 
-					pNodeTable = &pObject->get()->GetContents();
+				pNodeTable = &_Detach(*pObject)->GetContents();
 			}
-			else 
-				return nullptr;
+
+			auto itNode = pNodeTable->find(_pSegments[i], _pHashes[i]);
+			if (itNode == pNodeTable->end()) {
+				itNode = pNodeTable->try_emplace(Symbol(_pSegments[i], _pHashes[i])).first;
+				m_uRevision++;
+				if (m_bPathIndexing)
+					_IndexPath(_pSegments, i + 1);
+			}
+
+			pNode = &itNode->second;
 		}
 
 		return pNode;
 	}
 
 
+	// count dotted parent segments that are equal in both keys
+	static size_t _CountSharedParents(const std::string& _sFirst, const std::string& _sSecond) {
+		size_t uShared = 0;
+		const size_t uLen = std::min(_sFirst.size(), _sSecond.size());
+		for (size_t i = 0; i < uLen && _sFirst[i] == _sSecond[i]; i++) {
+			if (_sFirst[i] == '.')
+				uShared++;
+		}
+
+		return uShared;
+	}
+
+
+	bool CVarSystem::_WalkBatch(const std::string* _pKeys, const std::vector<size_t>& _order, bool _bCreate, Value** _ppNodes, hash_t* _pHashes) {
+		// tables[i] is the object reached through i parent segments of the previous key and
+		// pathHashes[i] is the hash of its full path
+		std::vector<ObjectMap*> tables;
+		std::vector<hash_t> pathHashes;
+		tables.push_back(_bCreate ? &_Detach(m_pRoot)->GetContents() : &m_pRoot->GetContents());
+		pathHashes.push_back(0);
+
+		bool bValid = true;
+		const std::string* pPrevKey = nullptr;
+
+		for (auto itOrder = _order.begin(); itOrder != _order.end(); itOrder++) {
+			const std::string& sKey = _pKeys[*itOrder];
+			_ppNodes[*itOrder] = nullptr;
+
+			// only the part of the path that differs from the previous key is walked
+			const size_t uDepth = pPrevKey ? std::min(_CountSharedParents(*pPrevKey, sKey), tables.size() - 1) : 0;
+			tables.resize(uDepth + 1);
+			pathHashes.resize(uDepth + 1);
+			pPrevKey = &sKey;
+
+			size_t uBeginPos = 0;
+			for (size_t i = 0; i < uDepth; i++)
+				uBeginPos = sKey.find('.', uBeginPos) + 1;
+
+			while (true) {
+				size_t uPos = sKey.find('.', uBeginPos);
+				const bool bLeaf = uPos == std::string::npos;
+				if (bLeaf)
+					uPos = sKey.size();
+
+				const hash_t hshSegment = RUNTIME_CRC_RANGE(sKey.c_str() + uBeginPos, uPos - uBeginPos);
+				const hash_t hshPath = tables.size() == 1 ? hshSegment :
+					RUNTIME_CRC_EXTEND(pathHashes.back(), sKey.c_str() + uBeginPos - 1, uPos - uBeginPos + 1);
+
+				ObjectMap* pTable = tables.back();
+				const std::string_view sSegment = std::string_view(sKey).substr(uBeginPos, uPos - uBeginPos);
+				auto itNode = pTable->find(sSegment, hshSegment);
+				if (itNode == pTable->end()) {
+					if (!_bCreate)
+						break;
+					itNode = pTable->try_emplace(Symbol(sSegment, hshSegment)).first;
+					m_uRevision++;
+					if (m_bPathIndexing)
+						m_pathIndex.Insert(std::string_view(sKey).substr(0, uPos));
+				}
+
+				if (bLeaf) {
+					_ppNodes[*itOrder] = &itNode->second;
+					if (_pHashes)
+						_pHashes[*itOrder] = hshPath;
+					break;
+				}
+
+				Value& node = itNode->second;
+				if (_bCreate && std::holds_alternative<std::monostate>(node))
+					node.emplace<std::shared_ptr<Object>>(std::make_shared<Object>());
+
+				auto pObject = std::get_if<std::shared_ptr<Object>>(&node);
+				if (!pObject) {
+					// parent node exists, but it is not an object
+					if (!std::holds_alternative<std::monostate>(node))
+						bValid = false;
+					break;
+				}
+
+				tables.push_back(_bCreate ? &_Detach(*pObject)->GetContents() : &pObject->get()->GetContents());
+				pathHashes.push_back(hshPath);
+				uBeginPos = uPos + 1;
+			}
+		}
+
+		return bValid;
+	}
+
+
+	void CVarSystem::GetBatch(const std::string* _pKeys, size_t _uCount, Value** _ppValues) {
+		std::vector<size_t> order(_uCount);
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [_pKeys](size_t _uFirst, size_t _uSecond) {
+			return _pKeys[_uFirst] < _pKeys[_uSecond];
+		});
+
+		_WalkBatch(_pKeys, order, false, _ppValues, nullptr);
+	}
+
+
+	bool CVarSystem::Apply(CVarBatch&& _batch) {
+		auto lock = _LockWriter();
+		const std::vector<std::string>& keys = _batch.m_keys;
+
+		// a key that is a dotted prefix of another key would have to be both a value and an object
+		std::unordered_set<std::string_view> keySet(keys.begin(), keys.end());
+		for (auto it = keys.begin(); it != keys.end(); it++) {
+			if (it->empty())
+				return false;
+
+			for (size_t uPos = it->find('.'); uPos != std::string::npos; uPos = it->find('.', uPos + 1)) {
+				if (keySet.find(std::string_view(it->c_str(), uPos)) != keySet.end())
+					return false;
+			}
+		}
+
+		std::vector<size_t> order(keys.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&keys](size_t _uFirst, size_t _uSecond) {
+			return keys[_uFirst] < keys[_uSecond];
+		});
+
+		// validate the batch against the current tree before anything gets modified
+		std::vector<Value*> nodes(keys.size());
+		std::vector<hash_t> hashes(keys.size());
+		if (!_WalkBatch(keys.data(), order, false, nodes.data(), nullptr))
+			return false;
+		_WalkBatch(keys.data(), order, true, nodes.data(), hashes.data());
+
+		// values are assigned in insertion order, thus the last write to a duplicate key wins
+		for (size_t i = 0; i < keys.size(); i++) {
+			if (std::holds_alternative<std::shared_ptr<Object>>(*nodes[i]))
+				_OnReplaceObject(keys[i]);
+			*nodes[i] = std::move(_batch.m_values[i]);
+		}
+
+		for (size_t i = 0; i < keys.size(); i++) {
+			_IndexNode(hashes[i], keys[i], nodes[i]);
+			_OnWrite(hashes[i], keys[i], *nodes[i]);
+		}
+
+		_Publish();
+		_batch.Clear();
+		return true;
+	}
+
+
+	void CVarSystem::_RebuildIndex() {
+		m_flatIndex.clear();
+		if (m_pSaveCache)
+			m_pSaveCache->Clear();
+		if (m_bPathIndexing)
+			m_pathIndex.Build(m_pRoot->GetContents());
+
+		// objects that are waiting to be indexed, the path and its hash are ignored for root
+		struct Frame {
+			ObjectMap* pMap;
+			hash_t hshPath;
+			std::string sPath;
+		};
+
+		ObjectMap* pRoot = &m_pRoot->GetContents();
+		std::stack<Frame> stckObjects;
+		stckObjects.push(Frame{ pRoot, 0, std::string() });
+
+		while (!stckObjects.empty()) {
+			const Frame top = std::move(stckObjects.top());
+			stckObjects.pop();
+			const bool bIsRoot = top.pMap == pRoot;
+
+			for (auto it = top.pMap->begin(); it != top.pMap->end(); it++) {
+				// full path hashes are calculated incrementally from the parent path hash
+				const std::string& sKey = it->first.GetSTDString();
+				hash_t hshPath = it->first.GetHash();
+				std::string sPath = sKey;
+				if (!bIsRoot) {
+					hshPath = RUNTIME_CRC_EXTEND(RUNTIME_CRC_EXTEND(top.hshPath, ".", 1), sKey.c_str(), sKey.size());
+					sPath = top.sPath + '.' + sKey;
+				}
+
+				// the first of colliding paths is indexed, the others are looked up by walking the tree
+				if (auto pObject = std::get_if<std::shared_ptr<Object>>(&it->second))
+					stckObjects.push(Frame{ &pObject->get()->GetContents(), hshPath, sPath });
+				m_flatIndex.emplace(hshPath, _IndexEntry{ &it->second, std::move(sPath) });
+			}
+		}
+	}
+
+
+	void CVarSystem::_IndexPath(const std::string_view* _pSegments, size_t _uCount) {
+		std::string sPath;
+		for (size_t i = 0; i < _uCount; i++) {
+			if (i)
+				sPath += '.';
+			sPath += _pSegments[i];
+		}
+		m_pathIndex.Insert(sPath);
+	}
+
+
+	void CVarSystem::SetPathIndexing(bool _bEnable) {
+		auto lock = _LockWriter();
+		m_bPathIndexing = _bEnable;
+		if (m_bPathIndexing)
+			m_pathIndex.Build(m_pRoot->GetContents());
+		else m_pathIndex.Clear();
+	}
+
+
+	void CVarSystem::_Publish() {
+		if (!m_bPublishSnapshots)
+			return;
+
+		// from now on the published tree is shared and writers will copy the nodes they modify
+		std::atomic_store(&m_pPublished, std::shared_ptr<const Object>(m_pRoot));
+		m_uShareEpoch++;
+		m_uPublishedVersion.fetch_add(1, std::memory_order_release);
+	}
+
+
+	AtomicSlot* CVarSystem::_FindAtomicSlot(hash_t _hshPath, std::string_view _sKey) {
+		auto range = m_atomicIndex.equal_range(_hshPath);
+		for (auto it = range.first; it != range.second; it++) {
+			if (it->second->sKey == _sKey)
+				return it->second;
+		}
+
+		return nullptr;
+	}
+
+
+	void CVarSystem::_StoreAtomic(hash_t _hshPath, std::string_view _sKey, const Value& _val) {
+		AtomicSlot* pSlot = _FindAtomicSlot(_hshPath, _sKey);
+		if (pSlot && _val.index() == pSlot->type)
+			pSlot->uBits.store(ToAtomicBits(_val, pSlot->type), std::memory_order_release);
+	}
+
+
+	void CVarSystem::_ReloadAtomics() {
+		if (m_atomicSlots.empty())
+			return;
+
+		// values from the new tree take precedence, atomic variables that are missing from the tree get reinserted
+		ObjectMap& root = m_pRoot->GetContents();
+		for (auto it = m_atomicSlots.begin(); it != m_atomicSlots.end(); it++) {
+			const Value* pValue = FindTreeNode(root, it->sKey);
+			if (pValue && pValue->index() == it->type) {
+				_StoreAtomic(RUNTIME_CRC(it->sKey), it->sKey, *pValue);
+				continue;
+			}
+			else if (pValue)
+				continue;
+
+			const uint32_t uBits = it->uBits.load(std::memory_order_acquire);
+			switch (it->type) {
+				case Type_Int:
+					Set<Int>(it->sKey, FromAtomicBits<Int>(uBits));
+					break;
+
+				case Type_Float:
+					Set<Float>(it->sKey, FromAtomicBits<Float>(uBits));
+					break;
+
+				case Type_Bool:
+					Set<Bool>(it->sKey, FromAtomicBits<Bool>(uBits));
+					break;
+
+				default:
+					break;
+			}
+		}
+	}
+
+
+	StaticCVarBase* CVarSystem::_FindStatic(hash_t _hshPath, std::string_view _sKey) {
+		auto range = m_staticIndex.equal_range(_hshPath);
+		for (auto it = range.first; it != range.second; it++) {
+			if (it->second->m_sKey == _sKey)
+				return it->second;
+		}
+
+		return nullptr;
+	}
+
+
+	bool CVarSystem::_RegisterStatic(StaticCVarBase* _pStatic) {
+		auto lock = _LockWriter();
+		if (_FindStatic(_pStatic->m_hshKey, _pStatic->m_sKey))
+			return false;
+		m_staticIndex.emplace(_pStatic->m_hshKey, _pStatic);
+
+		// adopt the value if the variable already exists, otherwise insert the default
+		_ReloadStatic(_pStatic);
+		return true;
+	}
+
+
+	void CVarSystem::_UnregisterStatic(StaticCVarBase* _pStatic) {
+		auto lock = _LockWriter();
+		auto range = m_staticIndex.equal_range(_pStatic->m_hshKey);
+		for (auto it = range.first; it != range.second; it++) {
+			if (it->second == _pStatic) {
+				m_staticIndex.erase(it);
+				return;
+			}
+		}
+	}
+
+
+	bool CVarSystem::_WriteStatic(StaticCVarBase* _pStatic, Value&& _val) {
+		auto lock = _LockWriter();
+		Value* pNode = _FindOrCreateNode(_pStatic->m_sKey);
+		if (!pNode)
+			return false;
+
+		if (std::holds_alternative<std::shared_ptr<Object>>(*pNode))
+			_OnReplaceObject(_pStatic->m_sKey);
+
+		*pNode = std::move(_val);
+		_CommitWrite(_pStatic->m_hshKey, _pStatic->m_sKey, pNode);
+		return true;
+	}
+
+
+	void CVarSystem::_StoreStatic(hash_t _hshPath, std::string_view _sKey, Value& _val) {
+		StaticCVarBase* pStatic = _FindStatic(_hshPath, _sKey);
+		if (!pStatic)
+			return;
+
+		// an object written over a static variable gets replaced with a scalar
+		if (std::holds_alternative<std::shared_ptr<Object>>(_val))
+			_InvalidateResolved();
+		pStatic->_Store(_val);
+	}
+
+
+	void CVarSystem::_ReloadStatic(StaticCVarBase* _pStatic) {
+		auto lock = _LockWriter();
+		const Value* pCurrent = _FindNode(_pStatic->m_sKey);
+		Value val = pCurrent ? *pCurrent : Value();
+
+		// only values that had to be converted, clamped or inserted are written back into the tree
+		if (_pStatic->_Store(val) || !pCurrent)
+			_WriteStatic(_pStatic, std::move(val));
+	}
+
+
+	void CVarSystem::_ReloadStatics() {
+		if (m_staticIndex.empty())
+			return;
+
+		std::vector<StaticCVarBase*> statics;
+		statics.reserve(m_staticIndex.size());
+		for (auto it = m_staticIndex.begin(); it != m_staticIndex.end(); it++)
+			statics.push_back(it->second);
+
+		for (auto it = statics.begin(); it != statics.end(); it++)
+			_ReloadStatic(*it);
+	}
+
+
+	bool CVarSystem::_SyncAtomic(const AtomicSlot& _slot) {
+		const uint32_t uBits = _slot.uBits.load(std::memory_order_acquire);
+		const Value* pCurrent = _FindNode(_slot.sKey);
+
+		// only detach nodes whose values have actually changed
+		if (!pCurrent || pCurrent->index() != _slot.type || ToAtomicBits(*pCurrent, _slot.type) == uBits)
+			return false;
+
+		Value* pValue = _FindWritableNode(_slot.sKey);
+		if (!pValue)
+			return false;
+
+		switch (_slot.type) {
+			case Type_Int:
+				pValue->emplace<Int>(FromAtomicBits<Int>(uBits));
+				break;
+
+			case Type_Float:
+				pValue->emplace<Float>(FromAtomicBits<Float>(uBits));
+				break;
+
+			case Type_Bool:
+				pValue->emplace<Bool>(FromAtomicBits<Bool>(uBits));
+				break;
+
+			default:
+				break;
+		}
+
+		const hash_t hshPath = RUNTIME_CRC(_slot.sKey);
+		if (m_pSaveCache)
+			m_dirtyKeys.emplace(_slot.sKey);
+		if (!m_staticIndex.empty())
+			_StoreStatic(hshPath, _slot.sKey, *pValue);
+		if (!m_subscriptions.empty())
+			_NotifySubscribers(_slot.sKey, pValue, NotifyMode::Immediate);
+		return true;
+	}
+
+
+	void CVarSystem::_SyncAtomic(hash_t _hshPath, std::string_view _sKey) {
+		auto lock = _LockWriter();
+		AtomicSlot* pSlot = _FindAtomicSlot(_hshPath, _sKey);
+		if (pSlot && _SyncAtomic(*pSlot))
+			_Publish();
+	}
+
+
+	void CVarSystem::SyncAtomics() {
+		if (m_atomicSlots.empty())
+			return;
+
+		auto lock = _LockWriter();
+		bool bModified = false;
+		for (auto it = m_atomicSlots.begin(); it != m_atomicSlots.end(); it++) {
+			if (_SyncAtomic(*it))
+				bModified = true;
+		}
+
+		if (bModified)
+			_Publish();
+	}
+
+
+	void CVarSystem::_NotifySubscribers(std::string_view _sKey, const Value* _pValue, NotifyMode _mode) {
+		// collect subscriptions of the empty prefix, every dotted prefix and the full key
+		std::vector<std::shared_ptr<Subscription>> matches;
+		hash_t hshPrefix = RUNTIME_CRC_RANGE(_sKey.data(), 0);
+		size_t uPrefixLen = 0;
+		size_t uBeginPos = 0;
+		bool bDeferred = false;
+
+		while (true) {
+			auto itSubscriptions = m_subscriptions.find(hshPrefix);
+			if (itSubscriptions != m_subscriptions.end()) {
+				const std::string_view sPrefix = _sKey.substr(0, uPrefixLen);
+				for (auto it = itSubscriptions->second.begin(); it != itSubscriptions->second.end(); it++) {
+					if ((*it)->sPrefix != sPrefix)
+						continue;
+
+					if ((*it)->mode == _mode)
+						matches.push_back(*it);
+					else if ((*it)->mode == NotifyMode::Deferred)
+						bDeferred = true;
+				}
+			}
+
+			if (uBeginPos > _sKey.size() || _sKey.empty())
+				break;
+
+			size_t uPos = _sKey.find('.', uBeginPos);
+			if (uPos == std::string_view::npos)
+				uPos = _sKey.size();
+
+			// prefix hash is extended with the delimiter and the next segment
+			if (uBeginPos == 0)
+				hshPrefix = RUNTIME_CRC_RANGE(_sKey.data(), uPos);
+			else hshPrefix = RUNTIME_CRC_EXTEND(hshPrefix, _sKey.data() + uBeginPos - 1, uPos - uBeginPos + 1);
+			uPrefixLen = uPos;
+			uBeginPos = uPos + 1;
+		}
+
+		if (bDeferred)
+			m_pendingChanges.emplace(_sKey);
+		if (matches.empty())
+			return;
+
+		// subscriptions removed by an earlier callback of the same change are skipped
+		const std::string sKey(_sKey);
+		for (auto it = matches.begin(); it != matches.end(); it++) {
+			if ((*it)->bActive)
+				(*it)->callback(sKey, _pValue);
+		}
+	}
+
+
+	void CVarSystem::_NotifyReload() {
+		if (m_subscriptions.empty())
+			return;
+
+		std::vector<std::shared_ptr<Subscription>> subscriptions;
+		for (auto it = m_subscriptions.begin(); it != m_subscriptions.end(); it++)
+			subscriptions.insert(subscriptions.end(), it->second.begin(), it->second.end());
+
+		// the whole tree has been replaced, thus every subscription is notified about its own path
+		for (auto it = subscriptions.begin(); it != subscriptions.end(); it++) {
+			if (!(*it)->bActive)
+				continue;
+			if ((*it)->mode == NotifyMode::Deferred)
+				m_pendingChanges.emplace((*it)->sPrefix);
+			else (*it)->callback((*it)->sPrefix, _FindNode((*it)->sPrefix));
+		}
+	}
+
+
+	SubscriptionId CVarSystem::Subscribe(const std::string& _sPrefix, const ChangeCallback& _callback, NotifyMode _mode) {
+		auto lock = _LockWriter();
+		const SubscriptionId uId = m_uNextSubscriptionId++;
+		m_subscriptions[RUNTIME_CRC(_sPrefix)].push_back(std::make_shared<Subscription>(Subscription{ uId, _mode, _sPrefix, _callback }));
+		return uId;
+	}
+
+
+	void CVarSystem::Unsubscribe(SubscriptionId _uId) {
+		auto lock = _LockWriter();
+		for (auto it = m_subscriptions.begin(); it != m_subscriptions.end(); it++) {
+			auto& subscriptions = it->second;
+			for (auto itSub = subscriptions.begin(); itSub != subscriptions.end(); itSub++) {
+				if ((*itSub)->uId != _uId)
+					continue;
+
+				(*itSub)->bActive = false;
+				subscriptions.erase(itSub);
+				if (subscriptions.empty())
+					m_subscriptions.erase(it);
+				return;
+			}
+		}
+	}
+
+
+	void CVarSystem::DispatchNotifications() {
+		auto lock = _LockWriter();
+
+		// callbacks may produce new changes, those are delivered by the next dispatch
+		std::unordered_set<std::string> pendingChanges;
+		pendingChanges.swap(m_pendingChanges);
+
+		for (auto it = pendingChanges.begin(); it != pendingChanges.end(); it++)
+			_NotifySubscribers(*it, _FindNode(*it), NotifyMode::Deferred);
+	}
+
+
+	void CVarSystem::Restore(const Snapshot& _snapshot) {
+		if (!_snapshot)
+			return;
+
+		{
+			auto lock = _LockWriter();
+			// snapshot nodes are never modified in place, since the root is now shared it gets detached on the next write
+			m_pRoot = std::const_pointer_cast<Object>(_snapshot.GetRootObject());
+			m_uShareEpoch++;
+			m_uRevision++;
+			_InvalidateResolved();
+			if (m_bPathIndexing)
+				m_pathIndex.Build(m_pRoot->GetContents());
+			if (m_pSaveCache)
+				m_pSaveCache->Clear();
+			_Publish();
+		}
+
+		_ReloadStatics();
+		_ReloadAtomics();
+		_NotifyReload();
+	}
+
+
+	void CVarSystem::SetSnapshotPublishing(bool _bEnable) {
+		std::lock_guard<std::recursive_mutex> lock(m_mtxWriter);
+		m_bPublishSnapshots = _bEnable;
+
+		if (m_bPublishSnapshots)
+			_Publish();
+		else {
+			std::atomic_store(&m_pPublished, std::shared_ptr<const Object>());
+			m_uPublishedVersion.fetch_add(1, std::memory_order_release);
+		}
+	}
+
+
 	CVarSystem& CVarSystem::GetInstance() {
 		static CVarSystem system;
 		return system;
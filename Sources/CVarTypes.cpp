@@ -3,66 +3,356 @@
 // file: CVarTypes.cpp - CVar types definition source file
 // author: Karl-Mihkel Ott
 
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <deque>
+#include <mutex>
 #include <stack>
 #include <ostream>
+#include <unordered_map>
 #include <cvar/CVarTypes.h>
 
 namespace cvar {
-    std::ostream& operator<<(std::ostream& _stream, List& _list) {
-        std::stack<List*> stckList;
-		stckList.push(&_list);
-
-		while (!stckList.empty()) {
-			_stream << '[';
-			auto pList = stckList.top();
-
-			for (auto it = pList->Begin(); it != pList->End(); it++) {
-				switch (it->index()) {
-                    case Type_Bool:
-						_stream << (std::get<Type_Bool>(*it) ? "true" : "false");
-						break;
 
-					case Type_Float:
-						_stream << std::get<Type_Float>(*it);
-						break;
+    void String::_Assign(std::string_view _sText, hash_t _hshText) {
+        std::memset(m_arrData, 0, sizeof(m_arrData));
+        if (_sText.empty())
+            return;
 
-					case Type_Int:
-						_stream << std::get<Type_Int>(*it);
-						break;
+        if (_sText.size() <= s_uInlineCapacity) {
+            m_arrData[0] = static_cast<unsigned char>((_sText.size() << 1) | 1);
+            std::memcpy(m_arrData + 1, _sText.data(), _sText.size());
+            return;
+        }
 
-					case Type_List:
-						_stream << '[';
-						stckList.push(std::get<Type_List>(*it).get());
-						break;
+        _Block* pBlock = new (::operator new(sizeof(_Block) + _sText.size() + 1)) _Block(_sText.size(), _hshText);
+        char* szText = reinterpret_cast<char*>(pBlock + 1);
+        std::memcpy(szText, _sText.data(), _sText.size());
+        szText[_sText.size()] = '\0';
+        std::memcpy(m_arrData, &pBlock, sizeof(pBlock));
+    }
 
-					case Type_Object:
-						_stream << *std::get<Type_Object>(*it).get();
-						break;
 
-					case Type_String:
-						_stream << '\"' << std::get<Type_String>(*it) << '\"';
-						break;
+    void String::_Release() {
+        if (_IsInline())
+            return;
 
-					default:
-						break;
-				}
+        _Block* pBlock = _GetBlock();
+        if (pBlock && pBlock->uRefCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            pBlock->~_Block();
+            ::operator delete(pBlock);
+        }
+        std::memset(m_arrData, 0, sizeof(m_arrData));
+    }
 
-				if (it != (_list.End() - 1))
-					_stream << ", ";
-				else 
-                    _stream << ']';
-			}
 
-			stckList.pop();
-			if (!stckList.empty())
-				_stream << ", ";
-		}
+    List::List(const List& _list) {
+        const size_t uSize = _list.Size();
+        if (!uSize)
+            return;
 
-		return _stream;
+        const Type packedType = _list.GetPackedType();
+        if (packedType != Type_None)
+            std::memcpy(_ReservePacked(packedType, uSize), _list.m_pBlock->pPacked, uSize * _PackedElementSize(packedType));
+        else _GetOrCreateBlock()->items = _list.m_pBlock->items;
+    }
+
+
+    List::List(std::initializer_list<ListItem> _initList) {
+        for (auto it = _initList.begin(); it != _initList.end(); it++)
+            _Push(ListItem(*it));
+    }
+
+
+    List& List::operator=(const List& _list) {
+        if (this != &_list)
+            *this = List(_list);
+        return *this;
+    }
+
+
+    void* List::_ReservePacked(Type _type, size_t _uCount) {
+        // list must be either empty or packed with the same type
+        _Block* pBlock = _GetOrCreateBlock();
+        pBlock->packedType = _type;
+
+        const size_t uElementSize = _PackedElementSize(_type);
+        const size_t uSize = pBlock->uPackedSize + _uCount;
+        if (uSize > pBlock->uPackedCapacity) {
+            const size_t uCapacity = std::max<size_t>(uSize, pBlock->uPackedCapacity * 2);
+            std::pmr::memory_resource* pResource = pBlock->GetResource();
+            void* pPacked = pResource->allocate(uCapacity * uElementSize, alignof(Int));
+            if (pBlock->pPacked) {
+                std::memcpy(pPacked, pBlock->pPacked, pBlock->uPackedSize * uElementSize);
+                pResource->deallocate(pBlock->pPacked, pBlock->uPackedCapacity * uElementSize, alignof(Int));
+            }
+
+            pBlock->pPacked = pPacked;
+            pBlock->uPackedCapacity = uCapacity;
+        }
+
+        void* pElements = static_cast<unsigned char*>(pBlock->pPacked) + pBlock->uPackedSize * uElementSize;
+        pBlock->uPackedSize = uSize;
+        return pElements;
+    }
+
+
+    void List::_Push(ListItem&& _item) {
+        const Type type = static_cast<Type>(_item.index());
+        const bool bScalar = type == Type_Int || type == Type_Float || type == Type_Bool;
+
+        if (bScalar && (!Size() || GetPackedType() == type)) {
+            void* pElement = _ReservePacked(type, 1);
+            switch (type) {
+                case Type_Int:
+                    new (pElement) Int(std::get<Int>(_item));
+                    break;
+
+                case Type_Float:
+                    new (pElement) Float(std::get<Float>(_item));
+                    break;
+
+                default:
+                    new (pElement) Bool(std::get<Bool>(_item));
+                    break;
+            }
+            return;
+        }
+
+        _Unpack();
+        _GetOrCreateBlock()->items.push_back(std::move(_item));
+    }
+
+
+    void List::_Unpack() {
+        if (!m_pBlock || m_pBlock->packedType == Type_None)
+            return;
+
+        auto& items = m_pBlock->items;
+        items.reserve(m_pBlock->uPackedSize);
+        for (auto it = Begin(); it != End(); it++)
+            items.push_back(*it);
+
+        m_pBlock->GetResource()->deallocate(m_pBlock->pPacked, m_pBlock->uPackedCapacity * _PackedElementSize(m_pBlock->packedType),
+                                            alignof(Int));
+        m_pBlock->packedType = Type_None;
+        m_pBlock->pPacked = nullptr;
+        m_pBlock->uPackedSize = 0;
+        m_pBlock->uPackedCapacity = 0;
+    }
+
+
+    ListItem List::At(size_t _uIndex) const {
+        return *ListIterator(m_pBlock, _uIndex, false);
+    }
+
+
+    ListItem& List::Back() {
+        _Unpack();
+        return m_pBlock->items.back();
+    }
+
+
+    bool List::Pack(bool _bPromote) {
+        if (IsPacked())
+            return true;
+        if (!Size())
+            return false;
+
+        auto& items = m_pBlock->items;
+        Type type = static_cast<Type>(items.front().index());
+        for (auto it = items.begin(); it != items.end(); it++) {
+            const Type itemType = static_cast<Type>(it->index());
+            if (itemType == type)
+                continue;
+
+            const bool bNumeric = (itemType == Type_Int || itemType == Type_Float) && (type == Type_Int || type == Type_Float);
+            if (!_bPromote || !bNumeric)
+                return false;
+            type = Type_Float;
+        }
+
+        if (type != Type_Int && type != Type_Float && type != Type_Bool)
+            return false;
+
+        void* pPacked = _ReservePacked(type, items.size());
+        for (size_t i = 0; i < items.size(); i++) {
+            switch (type) {
+                case Type_Int:
+                    new (static_cast<Int*>(pPacked) + i) Int(std::get<Int>(items[i]));
+                    break;
+
+                case Type_Float:
+                {
+                    const Int* pInt = std::get_if<Int>(&items[i]);
+                    new (static_cast<Float*>(pPacked) + i) Float(pInt ? static_cast<Float>(*pInt) : std::get<Float>(items[i]));
+                    break;
+                }
+
+                default:
+                    new (static_cast<Bool*>(pPacked) + i) Bool(std::get<Bool>(items[i]));
+                    break;
+            }
+        }
+
+        items.clear();
+        items.shrink_to_fit();
+        return true;
+    }
+
+
+    struct _SymbolTable {
+        std::mutex mtx;
+        // deque is used since entry addresses must remain stable
+        std::deque<SymbolEntry> entries;
+        std::unordered_multimap<hash_t, const SymbolEntry*, NoHash> index;
+    };
+
+    // the table is never destroyed, thus symbols remain valid during static destruction
+    static _SymbolTable& _GetSymbolTable() {
+        static _SymbolTable* pTable = new _SymbolTable;
+        return *pTable;
+    }
+
+
+    Symbol::Symbol() :
+        m_pEntry(_Intern(std::string_view(), RUNTIME_CRC_RANGE("", 0))) {}
+
+
+    const SymbolEntry* Symbol::_Intern(std::string_view _sText, hash_t _hshText) {
+        _SymbolTable& table = _GetSymbolTable();
+        std::lock_guard<std::mutex> lock(table.mtx);
+
+        auto range = table.index.equal_range(_hshText);
+        for (auto it = range.first; it != range.second; it++) {
+            if (std::string_view(it->second->sText) == _sText)
+                return it->second;
+        }
+
+        const SymbolEntry* pEntry = &table.entries.emplace_back(SymbolEntry{ std::string(_sText), _hshText });
+        table.index.emplace(_hshText, pEntry);
+        return pEntry;
+    }
+
+
+    size_t Symbol::GetInternedCount() {
+        _SymbolTable& table = _GetSymbolTable();
+        std::lock_guard<std::mutex> lock(table.mtx);
+        return table.entries.size();
+    }
+
+    const Value* FindTreeNode(const ObjectMap& _root, const std::string& _key) {
+        const Value* pNode = nullptr;
+        const ObjectMap* pNodeTable = &_root;
+
+        size_t uBeginPos = 0;
+        while (uBeginPos < _key.size()) {
+            size_t uPos = _key.find('.', uBeginPos);
+            if (uPos == std::string::npos)
+                uPos = _key.size();
+
+            if (pNode) {
+                auto pObject = std::get_if<std::shared_ptr<Object>>(pNode);
+                if (!pObject)
+                    return nullptr;
+                pNodeTable = &pObject->get()->GetContents();
+            }
+
+            // segments are hashed in place without creating temporary strings
+            const std::string_view sSegment(_key.c_str() + uBeginPos, uPos - uBeginPos);
+            auto itNode = pNodeTable->find(sSegment, RUNTIME_CRC_RANGE(sSegment.data(), sSegment.size()));
+            if (itNode == pNodeTable->end())
+                return nullptr;
+
+            pNode = &itNode->second;
+            uBeginPos = uPos + 1;
+        }
+
+        return pNode;
+    }
+
+    const Value* FindTreeNode(const ObjectMap& _root, const hash_t* _pHashes, const std::string_view* _pSegments, size_t _uCount) {
+        const Value* pNode = nullptr;
+        const ObjectMap* pNodeTable = &_root;
+
+        for (size_t i = 0; i < _uCount; i++) {
+            auto itNode = pNodeTable->find(_pSegments[i], _pHashes[i]);
+            if (itNode == pNodeTable->end())
+                return nullptr;
+
+            pNode = &itNode->second;
+            if (i != _uCount - 1) {
+                auto pObject = std::get_if<std::shared_ptr<Object>>(pNode);
+                if (!pObject)
+                    return nullptr;
+                pNodeTable = &pObject->get()->GetContents();
+            }
+        }
+
+        return pNode;
+    }
+
+    std::ostream& operator<<(std::ostream& _stream, const List& _list) {
+        // pair specification:
+        // first - pointer to list
+        // second - iterator to the next element of that list
+        std::stack<std::pair<const List*, ListIterator>> stckLists;
+        stckLists.push(std::make_pair(&_list, _list.Begin()));
+        _stream << '[';
+
+        while (!stckLists.empty()) {
+            auto& top = stckLists.top();
+            if (top.second == top.first->End()) {
+                _stream << ']';
+                stckLists.pop();
+                continue;
+            }
+
+            if (top.second != top.first->Begin())
+                _stream << ", ";
+
+            // packed elements are materialized into the iterator, which isn't modified by incrementing it
+            const ListItem& item = *top.second;
+            ++top.second;
+
+            switch (item.index()) {
+                case Type_Bool:
+                    _stream << (std::get<Type_Bool>(item) ? "true" : "false");
+                    break;
+
+                case Type_Float:
+                    WriteJSONFloat(_stream, std::get<Type_Float>(item));
+                    break;
+
+                case Type_Int:
+                    _stream << std::get<Type_Int>(item);
+                    break;
+
+                case Type_List:
+                    _stream << '[';
+                    stckLists.push(std::make_pair(&std::get<Type_List>(item), std::get<Type_List>(item).Begin()));
+                    break;
+
+                case Type_Object:
+                    _stream << *std::get<Type_Object>(item);
+                    break;
+
+                case Type_String:
+                    _stream << '\"' << std::get<Type_String>(item) << '\"';
+                    break;
+
+                default:
+                    _stream << "null";
+                    break;
+            }
+        }
+
+        return _stream;
     }
 
     std::ostream& operator<<(std::ostream& _stream, Object& _obj) {
-        std::stack<std::pair<Object*, std::unordered_map<String, Value>::iterator>> stckObjects;
+        std::stack<std::pair<Object*, ObjectMap::iterator>> stckObjects;
 		stckObjects.push(std::make_pair(&_obj, _obj.GetContents().begin()));
 
 		_stream << '{';
@@ -78,7 +368,7 @@ namespace cvar {
 						break;
 
 					case Type_Float:
-						_stream << std::get<Type_Float>(it->second);
+						WriteJSONFloat(_stream, std::get<Type_Float>(it->second));
 						break;
 
 					case Type_Int:
@@ -104,6 +394,7 @@ namespace cvar {
 						break;
 
 					default:
+						_stream << "null";
 						break;
 				}
 
@@ -122,4 +413,18 @@ namespace cvar {
 
 		return _stream;
     }
+
+
+    std::ostream& WriteJSONFloat(std::ostream& _stream, Float _fValue) {
+        if (!std::isfinite(_fValue))
+            return _stream << "null";
+
+        char szNumber[32];
+        const auto result = std::to_chars(szNumber, szNumber + sizeof(szNumber), _fValue);
+        const std::string_view sNumber(szNumber, result.ptr - szNumber);
+        _stream << sNumber;
+        if (sNumber.find_first_of(".e") == std::string_view::npos)
+            _stream << ".0";
+        return _stream;
+    }
 }
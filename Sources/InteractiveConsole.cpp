@@ -3,10 +3,16 @@
 // file: InteractiveConsole.cpp - Interactive CVar console program implementation
 // author: Karl-Mihkel Ott
 
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <cvar/CVarSystem.h>
 #include <cvar/JSONSerializer.h>
+#include <cvar/JSONUnserializer.h>
+#include <cvar/MessagePackSerializer.h>
+#include <cvar/MessagePackUnserializer.h>
+#include <cvar/YAMLSerializer.h>
+#include <cvar/YAMLUnserializer.h>
 
 using namespace std;
 
@@ -14,8 +20,10 @@ static string sHelpText = "Standard mode commands are:\n"\
                           "<variable> - outputs variable value if available\n"\
                           "<variable>=<value> - sets variable value\n\n"\
                           "Command options are denoted with ':cmd'\n"\
-                          ":cmd save <json|yaml|xml> filename.<ext> [min] - serialize variables to file\n"\
-                          ":cmd load <json|yaml|xml> filename.<ext> - unserialize variables from file\n";
+                          ":cmd save <json|msgpack|yaml|xml> filename.<ext> [min] - serialize variables to file\n"\
+                          ":cmd load <json|msgpack|yaml|xml> filename.<ext> - unserialize variables from file\n"\
+                          ":cmd complete <partial variable> - list variables that complete the last segment\n"\
+                          ":cmd find <pattern> - output all variables matching a pattern, e.g. render.*.enabled or net.**\n";
 
 
 void TrimString(string& _str) {
@@ -141,13 +149,23 @@ void Cmd(const string& _sLine) {
     while (ss >> word)
         words.push_back(word);
 
-    if (words.size() < 4) {
+    cvar::CVarSystem& cvarSyst = cvar::CVarSystem::GetInstance();
+    if (words.size() == 3 && words[1] == "complete") {
+        for (const string& sPath : cvarSyst.CompletePath(words[2]))
+            cout << sPath << '\n';
+        return;
+    } else if (words.size() == 3 && words[1] == "find") {
+        for (const string& sPath : cvarSyst.FindPaths(words[2])) {
+            const cvar::Value* pValue = cvarSyst.GetValue(sPath);
+            if (pValue && pValue->index() != cvar::Type_Object)
+                cout << sPath << " = " << Get(sPath) << '\n';
+        }
+        return;
+    } else if (words.size() < 4) {
         cout << sHelpText;
         return;
     } else if (words[1] == "save") {
         if (words[2] == "json") {
-            cvar::CVarSystem& cvarSyst = cvar::CVarSystem::GetInstance();
-
             // check if minified json should be used
             if (words.size() == 5 && words.back() == "min") {
                 cvarSyst.Serialize<cvar::JSONSerializer>(words[3], false);
@@ -155,17 +173,38 @@ void Cmd(const string& _sLine) {
                 cvarSyst.Serialize<cvar::JSONSerializer>(words[3], true);
             }
             cout << "Serialized to '" << words[2] << "'\n";
+        } else if (words[2] == "msgpack") {
+            cvarSyst.Serialize<cvar::MessagePackSerializer>(words[3]);
+            cout << "Serialized to '" << words[3] << "'\n";
         } else if (words[2] == "yaml") {
-            cout << "Yaml serializer is not yet implemented :(\n";
-            return;
+            cvarSyst.Serialize<cvar::YAMLSerializer>(words[3], !(words.size() == 5 && words.back() == "min"));
+            cout << "Serialized to '" << words[3] << "'\n";
         } else if (words[2] == "xml") {
             cout << "XML serializer is not yet implemented :(\n";
             return;
         }
     } 
     else if (words[1] == "load") {
-        cout << std::uppercase << words[2] << "unserializer is not yet implemented :(\n";
-        return;
+        if (!ifstream(words[3])) {
+            cout << "Failed to open file '" << words[3] << "'\n";
+            return;
+        }
+
+        try {
+            if (words[2] == "json") {
+                cvarSyst.Unserialize<cvar::JSONUnserializer>(words[3]);
+            } else if (words[2] == "msgpack") {
+                cvarSyst.Unserialize<cvar::MessagePackUnserializer>(words[3]);
+            } else if (words[2] == "yaml") {
+                cvarSyst.Unserialize<cvar::YAMLUnserializer>(words[3]);
+            } else {
+                cout << std::uppercase << words[2] << " unserializer is not yet implemented :(\n";
+                return;
+            }
+            cout << "Unserialized from '" << words[3] << "'\n";
+        } catch (const std::exception& e) {
+            cout << e.what() << '\n';
+        }
     }
 }
 
@@ -192,6 +231,7 @@ int main(void) {
             "Type help for more options\n";
 
     string sPrompt = "InteractiveConsole > ";
+    cvar::CVarSystem::GetInstance().SetPathIndexing(true);
 
     while (true) {
         cout << sPrompt;
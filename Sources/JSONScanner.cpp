@@ -0,0 +1,368 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: JSONScanner.cpp - vectorized JSON structural character scanner implementation
+// author: Karl-Mihkel Ott
+
+#include <cvar/JSONScanner.h>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define CVAR_JSON_SCAN_X86
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        #define CVAR_TARGET_SSE2
+        #define CVAR_TARGET_AVX2
+    #else
+        #define CVAR_TARGET_SSE2 __attribute__((target("sse2")))
+        #define CVAR_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+namespace cvar {
+
+    static constexpr size_t s_uBlockSize = 64;
+
+    // bit i of each mask describes byte i of the block
+    struct _BlockMasks {
+        uint64_t uWhitespace;
+        uint64_t uOperators;
+        uint64_t uQuotes;
+        uint64_t uBackslashes;
+        uint64_t uSingleQuotes;
+    };
+
+
+    static inline uint32_t _PopCount(uint64_t _uBits) {
+    #if defined(_MSC_VER)
+        // __popcnt64 requires POPCNT support, which isn't checked for
+        _uBits = _uBits - ((_uBits >> 1) & 0x5555555555555555ull);
+        _uBits = (_uBits & 0x3333333333333333ull) + ((_uBits >> 2) & 0x3333333333333333ull);
+        _uBits = (_uBits + (_uBits >> 4)) & 0x0f0f0f0f0f0f0f0full;
+        return static_cast<uint32_t>((_uBits * 0x0101010101010101ull) >> 56);
+    #else
+        return static_cast<uint32_t>(__builtin_popcountll(_uBits));
+    #endif
+    }
+
+
+    static inline uint32_t _CountTrailingZeros(uint64_t _uBits) {
+    #if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+        unsigned long uIndex;
+        _BitScanForward64(&uIndex, _uBits);
+        return static_cast<uint32_t>(uIndex);
+    #elif defined(_MSC_VER)
+        unsigned long uIndex;
+        if (_BitScanForward(&uIndex, static_cast<uint32_t>(_uBits)))
+            return static_cast<uint32_t>(uIndex);
+        _BitScanForward(&uIndex, static_cast<uint32_t>(_uBits >> 32));
+        return static_cast<uint32_t>(uIndex) + 32;
+    #else
+        return static_cast<uint32_t>(__builtin_ctzll(_uBits));
+    #endif
+    }
+
+
+    // Writes the offsets of set bits to _pIndices. Up to 16 offsets are written without checking the bit count, which
+    // avoids a mispredicted loop exit in most blocks, thus _pIndices must have room for a whole block.
+    static inline void _ExtractIndices(uint64_t _uBits, uint32_t _uOffset, uint32_t* _pIndices) {
+        // the top bit keeps the argument of _CountTrailingZeros() nonzero, offsets written past the last bit are ignored
+        constexpr uint64_t uGuard = static_cast<uint64_t>(1) << 63;
+        const uint32_t uCount = _PopCount(_uBits);
+        for (uint32_t i = 0; i < 8; i++) {
+            _pIndices[i] = _uOffset + _CountTrailingZeros(_uBits | uGuard);
+            _uBits &= _uBits - 1;
+        }
+
+        if (uCount > 8) {
+            for (uint32_t i = 8; i < 16; i++) {
+                _pIndices[i] = _uOffset + _CountTrailingZeros(_uBits | uGuard);
+                _uBits &= _uBits - 1;
+            }
+
+            for (uint32_t i = 16; _uBits; i++) {
+                _pIndices[i] = _uOffset + _CountTrailingZeros(_uBits);
+                _uBits &= _uBits - 1;
+            }
+        }
+    }
+
+
+    // bit i of the result is the parity of bits 0..i, i.e. whether byte i is between an opening and a closing quote
+    static inline uint64_t _PrefixXor(uint64_t _uBits) {
+        _uBits ^= _uBits << 1;
+        _uBits ^= _uBits << 2;
+        _uBits ^= _uBits << 4;
+        _uBits ^= _uBits << 8;
+        _uBits ^= _uBits << 16;
+        _uBits ^= _uBits << 32;
+        return _uBits;
+    }
+
+
+    // bytes that follow an unescaped backslash, _uCarry is set if the block ends with one
+    static inline uint64_t _FindEscaped(uint64_t _uBackslashes, uint64_t& _uCarry) {
+        uint64_t uEscaped = _uCarry;
+        _uCarry = 0;
+
+        // backslashes are rare, thus they are walked one at a time
+        uint64_t uPending = _uBackslashes & ~uEscaped;
+        while (uPending) {
+            const uint32_t uBit = _CountTrailingZeros(uPending);
+            if (uBit == 63) {
+                _uCarry = 1;
+                break;
+            }
+
+            uEscaped |= static_cast<uint64_t>(1) << (uBit + 1);
+            uPending &= ~(static_cast<uint64_t>(3) << uBit);
+        }
+
+        return uEscaped;
+    }
+
+
+    enum _CharClass : uint8_t {
+        _CharClass_Whitespace = 1,
+        _CharClass_Operator = 2,
+        _CharClass_Quote = 4,
+        _CharClass_Backslash = 8,
+        _CharClass_SingleQuote = 16
+    };
+
+    struct _ClassTable {
+        uint8_t arrClasses[256] = {};
+    };
+
+    static constexpr _ClassTable _MakeClassTable() {
+        _ClassTable table;
+        table.arrClasses[static_cast<uint8_t>(' ')] = _CharClass_Whitespace;
+        table.arrClasses[static_cast<uint8_t>('\t')] = _CharClass_Whitespace;
+        table.arrClasses[static_cast<uint8_t>('\n')] = _CharClass_Whitespace;
+        table.arrClasses[static_cast<uint8_t>('\r')] = _CharClass_Whitespace;
+        table.arrClasses[static_cast<uint8_t>('{')] = _CharClass_Operator;
+        table.arrClasses[static_cast<uint8_t>('}')] = _CharClass_Operator;
+        table.arrClasses[static_cast<uint8_t>('[')] = _CharClass_Operator;
+        table.arrClasses[static_cast<uint8_t>(']')] = _CharClass_Operator;
+        table.arrClasses[static_cast<uint8_t>(':')] = _CharClass_Operator;
+        table.arrClasses[static_cast<uint8_t>(',')] = _CharClass_Operator;
+        table.arrClasses[static_cast<uint8_t>('"')] = _CharClass_Quote;
+        table.arrClasses[static_cast<uint8_t>('\\')] = _CharClass_Backslash;
+        table.arrClasses[static_cast<uint8_t>('\'')] = _CharClass_SingleQuote;
+        return table;
+    }
+
+    static constexpr _ClassTable s_classTable = _MakeClassTable();
+
+
+    static _BlockMasks _ClassifyScalar(const char* _pBlock) {
+        _BlockMasks masks = {};
+        for (size_t i = 0; i < s_uBlockSize; i++) {
+            const uint64_t uClass = s_classTable.arrClasses[static_cast<uint8_t>(_pBlock[i])];
+            masks.uWhitespace |= (uClass & 1) << i;
+            masks.uOperators |= ((uClass >> 1) & 1) << i;
+            masks.uQuotes |= ((uClass >> 2) & 1) << i;
+            masks.uBackslashes |= ((uClass >> 3) & 1) << i;
+            masks.uSingleQuotes |= ((uClass >> 4) & 1) << i;
+        }
+        return masks;
+    }
+
+#if defined(CVAR_JSON_SCAN_X86)
+    // brackets and braces differ from each other only by bit 5, thus both are matched by a single comparison
+    // after setting it
+    CVAR_TARGET_SSE2 static _BlockMasks _ClassifySSE2(const char* _pBlock) {
+        _BlockMasks masks = {};
+        for (size_t i = 0; i < s_uBlockSize; i += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_pBlock + i));
+            const __m128i vFolded = _mm_or_si128(v, _mm_set1_epi8(0x20));
+
+            const __m128i vWhitespace = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+            const __m128i vOperators = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(vFolded, _mm_set1_epi8('{')), _mm_cmpeq_epi8(vFolded, _mm_set1_epi8('}'))),
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+
+            masks.uWhitespace |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(vWhitespace))) << i;
+            masks.uOperators |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(vOperators))) << i;
+            masks.uQuotes |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"'))))) << i;
+            masks.uBackslashes |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))))) << i;
+            masks.uSingleQuotes |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\''))))) << i;
+        }
+        return masks;
+    }
+
+
+    // Whitespace and operators are found with two table lookups by the low nibble of each byte instead of a comparison
+    // per character. Table entries at other nibbles can't match the byte that selects them.
+    CVAR_TARGET_AVX2 static _BlockMasks _ClassifyAVX2(const char* _pBlock) {
+        const __m256i vWhitespaceTable = _mm256_setr_epi8(
+            ' ', 100, 100, 100, 17, 100, 113, 2, 100, '\t', '\n', 112, 100, '\r', 100, 100,
+            ' ', 100, 100, 100, 17, 100, 113, 2, 100, '\t', '\n', 112, 100, '\r', 100, 100);
+        // brackets are matched as braces after setting bit 5
+        const __m256i vOperatorTable = _mm256_setr_epi8(
+            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, ':', '{', ',', '}', 0, 0,
+            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, ':', '{', ',', '}', 0, 0);
+
+        _BlockMasks masks = {};
+        for (size_t i = 0; i < s_uBlockSize; i += 32) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_pBlock + i));
+            const __m256i vWhitespace = _mm256_cmpeq_epi8(v, _mm256_shuffle_epi8(vWhitespaceTable, v));
+            // control characters 0x0c and 0x1a would otherwise be taken for ',' and ':'
+            const __m256i vOperators = _mm256_and_si256(
+                _mm256_cmpeq_epi8(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), _mm256_shuffle_epi8(vOperatorTable, v)),
+                _mm256_cmpgt_epi8(v, _mm256_set1_epi8(0x1f)));
+
+            masks.uWhitespace |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(vWhitespace))) << i;
+            masks.uOperators |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(vOperators))) << i;
+            masks.uQuotes |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))))) << i;
+            masks.uBackslashes |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))))) << i;
+            masks.uSingleQuotes |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\''))))) << i;
+        }
+        return masks;
+    }
+
+
+    static JSONScanBackend _DetectBackend() {
+    #if defined(_MSC_VER)
+        int arrInfo[4] = {};
+        __cpuid(arrInfo, 1);
+        const bool bSSE2 = (arrInfo[3] & (1 << 26)) != 0;
+        // AVX registers must also be saved by the operating system
+        const bool bAVX = (arrInfo[2] & (1 << 27)) != 0 && (arrInfo[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+        __cpuidex(arrInfo, 7, 0);
+        const bool bAVX2 = bAVX && (arrInfo[1] & (1 << 5)) != 0;
+    #else
+        __builtin_cpu_init();
+        const bool bSSE2 = __builtin_cpu_supports("sse2");
+        const bool bAVX2 = __builtin_cpu_supports("avx2");
+    #endif
+
+        if (bAVX2)
+            return JSONScanBackend::AVX2;
+        else if (bSSE2)
+            return JSONScanBackend::SSE2;
+        return JSONScanBackend::Scalar;
+    }
+#else
+    static JSONScanBackend _DetectBackend() {
+        return JSONScanBackend::Scalar;
+    }
+#endif
+
+
+    JSONScanBackend GetJSONScanBackend() {
+        static const JSONScanBackend backend = _DetectBackend();
+        return backend;
+    }
+
+
+    const char* GetJSONScanBackendName(JSONScanBackend _backend) {
+        switch (_backend) {
+            case JSONScanBackend::SSE2:
+                return "SSE2";
+
+            case JSONScanBackend::AVX2:
+                return "AVX2";
+
+            default:
+                return "scalar";
+        }
+    }
+
+
+    bool ScanJSONStructure(const char* _pData, size_t _uLen, std::vector<uint32_t>& _indices) {
+        return ScanJSONStructure(_pData, _uLen, _indices, GetJSONScanBackend());
+    }
+
+
+    // the block loop is instantiated for each classifier, so that it gets inlined into code compiled for the same
+    // instruction set
+    template <_BlockMasks(*Classify)(const char*)>
+    static inline bool _ScanBlocks(const char* _pData, size_t _uLen, std::vector<uint32_t>& _indices) {
+        // state carried over from the previous block
+        uint64_t uEscapeCarry = 0;
+        uint64_t uInStringCarry = 0;
+        // the beginning of the text is treated as whitespace, thus a value starting at offset 0 is found
+        uint64_t uBoundaryCarry = 1;
+
+        // the index is grown in large steps and trimmed at the end, thus blocks are written without bounds checks
+        size_t uCount = _indices.size();
+        _indices.resize(uCount + _uLen / 4 + s_uBlockSize);
+
+        // last partial block is padded with whitespace
+        char arrTail[s_uBlockSize];
+        for (size_t uOffset = 0; uOffset < _uLen; uOffset += s_uBlockSize) {
+            const char* pBlock = _pData + uOffset;
+            if (_uLen - uOffset < s_uBlockSize) {
+                std::memset(arrTail, ' ', s_uBlockSize);
+                std::memcpy(arrTail, pBlock, _uLen - uOffset);
+                pBlock = arrTail;
+            }
+
+            const _BlockMasks masks = Classify(pBlock);
+            const uint64_t uEscaped = (masks.uBackslashes | uEscapeCarry) ? _FindEscaped(masks.uBackslashes, uEscapeCarry) : 0;
+            const uint64_t uQuotes = masks.uQuotes & ~uEscaped;
+
+            // bits are set from the opening quote up to, but not including, the closing quote
+            const uint64_t uInString = _PrefixXor(uQuotes) ^ uInStringCarry;
+            uInStringCarry = 0 - (uInString >> 63);
+
+            if (masks.uSingleQuotes & ~uInString) {
+                _indices.resize(uCount);
+                return false;
+            }
+
+            // first characters of numbers and literals follow whitespace, operators or quotes
+            const uint64_t uBoundaries = masks.uWhitespace | masks.uOperators | uQuotes;
+            const uint64_t uValues = ~uBoundaries & ~uInString & ((uBoundaries << 1) | uBoundaryCarry);
+            uBoundaryCarry = uBoundaries >> 63;
+
+            if (_indices.size() - uCount < s_uBlockSize)
+                _indices.resize(_indices.size() * 2);
+
+            const uint64_t uStructural = (masks.uOperators & ~uInString) | uQuotes | uValues;
+            _ExtractIndices(uStructural, static_cast<uint32_t>(uOffset), _indices.data() + uCount);
+            uCount += _PopCount(uStructural);
+        }
+
+        _indices.resize(uCount);
+        return true;
+    }
+
+
+    static bool _ScanScalar(const char* _pData, size_t _uLen, std::vector<uint32_t>& _indices) {
+        return _ScanBlocks<_ClassifyScalar>(_pData, _uLen, _indices);
+    }
+
+#if defined(CVAR_JSON_SCAN_X86)
+    CVAR_TARGET_SSE2 static bool _ScanSSE2(const char* _pData, size_t _uLen, std::vector<uint32_t>& _indices) {
+        return _ScanBlocks<_ClassifySSE2>(_pData, _uLen, _indices);
+    }
+
+
+    CVAR_TARGET_AVX2 static bool _ScanAVX2(const char* _pData, size_t _uLen, std::vector<uint32_t>& _indices) {
+        return _ScanBlocks<_ClassifyAVX2>(_pData, _uLen, _indices);
+    }
+#endif
+
+
+    bool ScanJSONStructure(const char* _pData, size_t _uLen, std::vector<uint32_t>& _indices, JSONScanBackend _backend) {
+        if (_uLen > std::numeric_limits<uint32_t>::max())
+            return false;
+
+    #if defined(CVAR_JSON_SCAN_X86)
+        if (_backend > GetJSONScanBackend())
+            _backend = GetJSONScanBackend();
+        if (_backend == JSONScanBackend::AVX2)
+            return _ScanAVX2(_pData, _uLen, _indices);
+        else if (_backend == JSONScanBackend::SSE2)
+            return _ScanSSE2(_pData, _uLen, _indices);
+    #else
+        static_cast<void>(_backend);
+    #endif
+        return _ScanScalar(_pData, _uLen, _indices);
+    }
+}
@@ -7,10 +7,42 @@
 #include <stack>
 #include <algorithm>
 #include <iomanip>
+#include <sstream>
 
 namespace cvar {
 
-    JSONSerializer::JSONSerializer(std::ostream& _stream, std::unordered_map<String, Value>& _root) :
+    // non-object values are written the same way in every output mode
+    static void _WriteValue(std::ostream& _stream, const Value& _val) {
+        switch (_val.index()) {
+            case Type_Int:
+                _stream << std::get<Type_Int>(_val);
+                break;
+
+            case Type_Float:
+                // JSON has no representation for infinity and nan
+                WriteJSONFloat(_stream, std::get<Type_Float>(_val));
+                break;
+
+            case Type_Bool:
+                _stream << (std::get<Type_Bool>(_val) ? "true" : "false");
+                break;
+
+            case Type_String:
+                _stream << '\"' << std::get<Type_String>(_val) << '\"';
+                break;
+
+            case Type_List:
+                _stream << std::get<Type_List>(_val);
+                break;
+
+            default:
+                _stream << "null";
+                break;
+        }
+    }
+
+
+    JSONSerializer::JSONSerializer(std::ostream& _stream, ObjectMap& _root) :
         ISerializer(_stream, _root) {}
 
 
@@ -20,9 +52,86 @@ namespace cvar {
         else _SerializeCompact();
     }
 
+
+    void JSONSerializer::Serialize(bool _bBeautified, SerializationCache& _cache) {
+        _cache.SetFormat(_bBeautified ? "json" : "json-compact");
+
+        // objects that are not cached are serialized into fragments, which end wherever a nested object begins
+        struct Frame {
+            const ObjectMap* pMap;
+            ObjectMap::const_iterator it;
+            std::string sPath;
+            size_t uDepth;
+            std::vector<SerializationCache::Fragment> fragments;
+            std::ostringstream text;
+        };
+
+        std::vector<Frame> stckFrames;
+        auto PushFrame = [&stckFrames, _bBeautified](const ObjectMap& _map, std::string&& _sPath, size_t _uDepth) {
+            stckFrames.emplace_back();
+            Frame& frame = stckFrames.back();
+            frame.pMap = &_map;
+            frame.it = _map.begin();
+            frame.sPath = std::move(_sPath);
+            frame.uDepth = _uDepth;
+            frame.text << (_bBeautified ? "{\n" : "{");
+        };
+
+        if (!_cache.IsCached(std::string()))
+            PushFrame(m_root, std::string(), 0);
+
+        while (!stckFrames.empty()) {
+            Frame& top = stckFrames.back();
+            if (top.it == top.pMap->end()) {
+                if (_bBeautified)
+                    top.text << std::string(top.uDepth, '\t');
+                top.text << '}';
+                top.fragments.push_back(SerializationCache::Fragment{ top.text.str() });
+                _cache.Store(top.sPath, std::move(top.fragments));
+                stckFrames.pop_back();
+                continue;
+            }
+
+            const ObjectMap::value_type& entry = *top.it++;
+            const bool bLast = top.it == top.pMap->end();
+            if (_bBeautified)
+                top.text << std::string(top.uDepth + 1, '\t') << '\"' << entry.first << "\": ";
+            else top.text << '\"' << entry.first << "\":";
+
+            auto pObject = std::get_if<std::shared_ptr<Object>>(&entry.second);
+            if (!pObject) {
+                _WriteValue(top.text, entry.second);
+                if (_bBeautified)
+                    top.text << (bLast ? "\n" : ",\n");
+                else if (!bLast)
+                    top.text << ',';
+                continue;
+            }
+
+            std::string sChild = entry.first.GetSTDString();
+            if (top.uDepth)
+                sChild = top.sPath + '.' + sChild;
+
+            top.fragments.push_back(SerializationCache::Fragment{ top.text.str(), sChild, true });
+            top.text.str("");
+            if (_bBeautified)
+                top.text << (bLast ? "\n" : ",\n");
+            else if (!bLast)
+                top.text << ',';
+
+            if (!_cache.IsCached(sChild))
+                PushFrame(pObject->get()->GetContents(), std::move(sChild), top.uDepth + 1);
+        }
+
+        _cache.Write(m_stream);
+        if (_bBeautified)
+            m_stream << '\n';
+    }
+
+
     void JSONSerializer::_SerializeCompact() {
         m_stream << '{';
-        std::stack<std::pair<std::unordered_map<String, Value>*, std::unordered_map<String, Value>::iterator>> stckObjects;
+        std::stack<std::pair<ObjectMap*, ObjectMap::iterator>> stckObjects;
         stckObjects.push(std::make_pair(&m_root, m_root.begin()));
 
         while (!stckObjects.empty()) {
@@ -33,26 +142,6 @@ namespace cvar {
                 m_stream << '\"' << it->first << "\":";
                 
                 switch(it->second.index()) {
-                    case Type_Int:
-                        m_stream << std::get<Type_Int>(it->second);
-                        break;
-
-                    case Type_Float:
-                        m_stream << std::get<Type_Float>(it->second);
-                        break;
-
-                    case Type_Bool:
-                        m_stream << (std::get<Type_Bool>(it->second) ? "true" : "false");
-                        break;
-
-                    case Type_String:
-                        m_stream << '\"' << std::get<Type_String>(it->second) << '\"';
-                        break;
-
-                    case Type_List:
-                        m_stream << std::get<Type_List>(it->second);
-                        break;
-
                     case Type_Object:
                         {
                             m_stream << "{";
@@ -65,6 +154,7 @@ namespace cvar {
                         break;
 
                     default:
+                        _WriteValue(m_stream, it->second);
                         break;
                 }
 
@@ -85,7 +175,7 @@ namespace cvar {
         m_stream << "{\n";
         std::size_t uNTabs = 1;
         
-        std::stack<std::pair<std::unordered_map<String, Value>*, std::unordered_map<String, Value>::iterator>> stckObjects;
+        std::stack<std::pair<ObjectMap*, ObjectMap::iterator>> stckObjects;
         stckObjects.push(std::make_pair(&m_root, m_root.begin()));
 
         while (!stckObjects.empty()) {
@@ -96,26 +186,6 @@ namespace cvar {
                 m_stream << std::setw(uNTabs) << std::setfill('\t') << "" << '\"' << it->first << "\": ";
 
                 switch (it->second.index()) {
-                    case Type_Int:
-                        m_stream << std::get<Type_Int>(it->second);
-                        break;
-
-                    case Type_Float:
-                        m_stream << std::get<Type_Float>(it->second);
-                        break;
-
-                    case Type_Bool:
-                        m_stream << (std::get<Type_Bool>(it->second) ? "true" : "false");
-                        break;
-
-                    case Type_String:
-                        m_stream << '\"' << std::get<Type_String>(it->second) << '\"';
-                        break;
-
-                    case Type_List:
-                        m_stream << std::get<Type_List>(it->second);
-                        break;
-
                     case Type_Object:
                         {
                             m_stream << "{\n";
@@ -129,6 +199,7 @@ namespace cvar {
                         break;
 
                     default:
+                        _WriteValue(m_stream, it->second);
                         break;
                 }
 
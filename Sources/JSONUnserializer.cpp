@@ -3,9 +3,13 @@
 // file: JSONUnserializer.cpp - JSON unserializer class implementation
 // author: Karl-Mihkel Ott
 
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
 #include <iostream>
 #include <cstring>
 #include <sstream>
+#include <cvar/JSONScanner.h>
 #include <cvar/JSONUnserializer.h>
 #include <cvar/SerializerExceptions.h>
 
@@ -46,7 +50,7 @@ namespace cvar {
 
     
     JSONUnserializer::JSONUnserializer(std::istream& _stream) :
-        IPlainTextUnserializer<std::unordered_map<String, Value>>(_stream)
+        IPlainTextUnserializer<ObjectMap>(_stream)
     {
         _Parse();
     }
@@ -127,6 +131,8 @@ namespace cvar {
 
             // check for list end statement
             if (m_token.token.index() == JSONTokenIndex_Char && std::get<char>(m_token.token) == ']') {
+                // arrays whose elements share a single type are stored as contiguous Int, Float or Bool arrays
+                pList->Pack();
                 stckLists.pop();
                 continue;
             }
@@ -148,14 +154,14 @@ namespace cvar {
                 case JSONTokenIndex_Char:
                     // recursive list (array)
                     if (std::get<char>(m_token.token) == '[') {
-                        pList->PushBack(std::make_shared<List>());
-                        stckLists.push(std::make_pair(std::get<std::shared_ptr<List>>(*pList->ReverseBegin()).get(), false));
+                        pList->PushBack(List());
+                        stckLists.push(std::make_pair(&std::get<List>(pList->Back()), false));
                         continue;
                     }
                     // object inside a list
                     else if (std::get<char>(m_token.token) == '{') {
                         pList->PushBack(std::make_shared<Object>());
-                        _ParseObject(&std::get<std::shared_ptr<Object>>(*pList->ReverseBegin()).get()->GetContents());
+                        _ParseObject(&std::get<std::shared_ptr<Object>>(pList->Back())->GetContents());
                     }
                     // error otherwise
                     else {
@@ -190,12 +196,12 @@ namespace cvar {
     }
 
 
-    void JSONUnserializer::_ParseObject(std::unordered_map<String, Value>* _pRootObject) {
+    void JSONUnserializer::_ParseObject(ObjectMap* _pRootObject) {
         // optimization: using a stack for recursive objects instead of actual recursion 
         // pair specification:
-        // first - pointer to object (aka unordered_map)
+        // first - pointer to object contents
         // second - boolean flag to indicate if the current value shall be a continuation to some previous value
-        std::stack<std::pair<std::unordered_map<String, Value>*, bool>> stckObjects;
+        std::stack<std::pair<ObjectMap*, bool>> stckObjects;
         stckObjects.push(std::make_pair(_pRootObject, false));
 
         while (!stckObjects.empty() && _NextToken()) {
@@ -286,7 +292,7 @@ namespace cvar {
     }
     
 
-    void JSONUnserializer::_Parse() {
+    void JSONUnserializer::_ParseTokens() {
         // assume empty file is used (no exceptions thrown) 
         if (!_NextToken()) return;
         
@@ -296,4 +302,235 @@ namespace cvar {
 
         _ParseObject(&m_root);
     }
+
+
+    // characters that end a number or a literal
+    static inline bool _IsDelimiter(char _c) {
+        switch (_c) {
+            case ' ': case '\n': case '\r': case '\t':
+            case '{': case '}': case '[': case ']': case ',': case ':': case '"': case '\'':
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+
+    // _sWord must be followed by a delimiter or the end of a null terminated string
+    static bool _ParseFloat(std::string_view _sWord, Float& _fValue) {
+        // strtod() would also accept hexadecimal numbers, infinity and nan
+        if (_sWord.find_first_not_of("0123456789+-.eE") != std::string_view::npos)
+            return false;
+
+        char* pEnd = nullptr;
+        _fValue = static_cast<Float>(std::strtod(_sWord.data(), &pEnd));
+        return pEnd == _sWord.data() + _sWord.size();
+    }
+
+
+    void JSONUnserializer::_BuildTree(const std::string& _sText, const std::vector<uint32_t>& _indices) {
+        // assume empty file is used (no exceptions thrown)
+        if (_indices.empty())
+            return;
+
+        if (_sText[_indices.front()] != '{')
+            throw SyntaxErrorException("Root must always be an object");
+
+        // line numbers are only needed for error messages, thus they are counted on demand
+        auto LineAt = [&_sText](size_t _uPos) {
+            return 1 + std::count(_sText.begin(), _sText.begin() + _uPos, '\n');
+        };
+
+        size_t i = 1;
+        auto Next = [&_indices, &i]() -> size_t {
+            if (i >= _indices.size())
+                throw UnexpectedEOFException("No more tokens to validate JSON syntax");
+            return _indices[i];
+        };
+
+        // containers that are being filled, nested containers are attached to their parent when they are created
+        struct Frame {
+            ObjectMap* pMap;
+            List* pList;
+            // the current value shall be a continuation to some previous value
+            bool bIsContinuation;
+        };
+
+        std::vector<Frame> stckFrames;
+        stckFrames.push_back(Frame{ &m_root, nullptr, false });
+
+        while (!stckFrames.empty()) {
+            size_t uPos = Next();
+            char c = _sText[uPos];
+            ObjectMap* pMap = stckFrames.back().pMap;
+            List* pList = stckFrames.back().pList;
+
+            // check for end statement
+            if (c == (pMap ? '}' : ']')) {
+                // arrays whose elements share a single type are stored as contiguous Int, Float or Bool arrays
+                if (pList)
+                    pList->Pack();
+                stckFrames.pop_back();
+                i++;
+                continue;
+            }
+
+            if (stckFrames.back().bIsContinuation) {
+                if (c != ',') {
+                    std::stringstream ss;
+                    ss << "Expected a comma separator at line " << LineAt(uPos);
+                    throw SyntaxErrorException(ss.str());
+                }
+
+                i++;
+                uPos = Next();
+                c = _sText[uPos];
+            } else {
+                stckFrames.back().bIsContinuation = true;
+            }
+
+            // expect a string key followed by a colon separator
+            std::string_view sKey;
+            if (pMap) {
+                if (c != '"') {
+                    std::stringstream ss;
+                    ss << "Unexpected identifier '" << c << "' at line " << LineAt(uPos) << ". Expected a json key!";
+                    throw SyntaxErrorException(ss.str());
+                }
+
+                // closing quote is always the next index
+                i++;
+                sKey = std::string_view(_sText.data() + uPos + 1, Next() - uPos - 1);
+                i++;
+
+                uPos = Next();
+                if (_sText[uPos] != ':') {
+                    std::stringstream ss;
+                    ss << "Unexpected identifier '" << _sText[uPos] << "' at line " << LineAt(uPos) << ". Expected a separator colon (':')!";
+                    throw SyntaxErrorException(ss.str());
+                }
+
+                i++;
+                uPos = Next();
+                c = _sText[uPos];
+            }
+
+            // duplicate keys overwrite the previous value
+            auto Slot = [pMap, sKey]() -> Value& {
+                return (*pMap)[Symbol(sKey, RUNTIME_CRC_RANGE(sKey.data(), sKey.size()))];
+            };
+
+            Value val;
+            switch (c) {
+                case '{':
+                {
+                    std::shared_ptr<Object> pObject = std::make_shared<Object>();
+                    ObjectMap* pContents = &pObject->GetContents();
+                    if (pMap)
+                        Slot() = std::move(pObject);
+                    else pList->PushBack(std::move(pObject));
+
+                    stckFrames.push_back(Frame{ pContents, nullptr, false });
+                    i++;
+                    continue;
+                }
+
+                case '[':
+                {
+                    List* pChild = nullptr;
+                    if (pMap) {
+                        Value& slot = Slot();
+                        slot = List();
+                        pChild = &std::get<List>(slot);
+                    } else {
+                        pList->PushBack(List());
+                        pChild = &std::get<List>(pList->Back());
+                    }
+
+                    stckFrames.push_back(Frame{ nullptr, pChild, false });
+                    i++;
+                    continue;
+                }
+
+                case '"':
+                {
+                    i++;
+                    const std::string_view sValue(_sText.data() + uPos + 1, Next() - uPos - 1);
+                    val = String(sValue, RUNTIME_CRC_RANGE(sValue.data(), sValue.size()));
+                    i++;
+                    break;
+                }
+
+                case '}':
+                case ']':
+                case ',':
+                case ':':
+                {
+                    std::stringstream ss;
+                    ss << "Unexpected identifier '" << c << "' at line " << LineAt(uPos) << ". Expected a valuetype instead.";
+                    throw SyntaxErrorException(ss.str());
+                }
+
+                default:
+                {
+                    size_t uEnd = uPos;
+                    while (uEnd < _sText.size() && !_IsDelimiter(_sText[uEnd]))
+                        uEnd++;
+
+                    const std::string_view sWord(_sText.data() + uPos, uEnd - uPos);
+                    const bool bSigned = sWord[0] == '-';
+                    const bool bInteger = sWord.size() > static_cast<size_t>(bSigned) &&
+                                          sWord.find_first_not_of("0123456789", bSigned) == std::string_view::npos;
+                    Int iValue = 0;
+                    Float fValue = 0.f;
+
+                    if (sWord == "true" || sWord == "false")
+                        val = sWord == "true";
+                    else if (sWord == "null") {
+                        // null values are not stored
+                        i++;
+                        continue;
+                    }
+                    else if (bInteger && std::from_chars(sWord.data(), sWord.data() + sWord.size(), iValue).ec == std::errc())
+                        val = iValue;
+                    // integers that don't fit are stored as Float
+                    else if (_ParseFloat(sWord, fValue))
+                        val = fValue;
+                    else {
+                        std::stringstream ss;
+                        ss << "Unexpected symbol '" << sWord << "' at line " << LineAt(uPos);
+                        throw SyntaxErrorException(ss.str());
+                    }
+
+                    i++;
+                    break;
+                }
+            }
+
+            if (pMap)
+                Slot() = std::move(val);
+            else pList->PushBack(std::move(val));
+        }
+    }
+
+
+    void JSONUnserializer::_Parse() {
+        // the structural scanner needs the whole text in memory
+        std::string sText;
+        while (!m_stream.eof()) {
+            const size_t uSize = sText.size();
+            sText.resize(uSize + (64 << 10));
+            sText.resize(uSize + m_stream.read(&sText[uSize], 64 << 10));
+        }
+
+        std::vector<uint32_t> indices;
+        if (!ScanJSONStructure(sText.data(), sText.size(), indices)) {
+            m_stream.rewind();
+            _ParseTokens();
+            return;
+        }
+
+        _BuildTree(sText, indices);
+    }
 }
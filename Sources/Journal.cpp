@@ -0,0 +1,730 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: Journal.cpp - append-only CVar change journal implementation
+// author: Karl-Mihkel Ott
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <cvar/Journal.h>
+#include <cvar/JSONSerializer.h>
+#include <cvar/JSONUnserializer.h>
+
+#ifdef _WIN32
+	#include <fcntl.h>
+	#include <io.h>
+	#include <share.h>
+	#include <sys/stat.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace cvar {
+
+	// journal file layout:
+	// header - 4 byte magic
+	// record - [u32 payload length][u32 CRC32 of payload][payload]
+	// payload - [u32 key length][key][value]
+	// value - [u8 type][data], where data is a native byte order Int or Float, a single byte Bool,
+	// [u32 length][bytes] String, [u8 packed type][u32 count][items or packed array] List and
+	// [u32 count][[u32 key length][key][value]...] Object
+	static constexpr char s_szMagic[] = { 'C', 'V', 'J', '1' };
+	static constexpr size_t s_uHeaderSize = sizeof(s_szMagic);
+	static constexpr size_t s_uRecordHeaderSize = 2 * sizeof(uint32_t);
+	// journal thread is woken up early once this many bytes of records are buffered
+	static constexpr size_t s_uFlushSize = 64 << 10;
+
+#ifdef _WIN32
+	static int _OpenFile(const std::string& _sPath) {
+		int iFile = -1;
+		_sopen_s(&iFile, _sPath.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _SH_DENYNO, _S_IREAD | _S_IWRITE);
+		return iFile;
+	}
+
+
+	static bool _WriteFile(int _iFile, const char* _pData, size_t _uLen) {
+		while (_uLen) {
+			const int iWritten = _write(_iFile, _pData, static_cast<unsigned int>(_uLen));
+			if (iWritten <= 0)
+				return false;
+			_pData += iWritten;
+			_uLen -= static_cast<size_t>(iWritten);
+		}
+
+		return true;
+	}
+
+
+	static bool _SyncFile(int _iFile) {
+		return _commit(_iFile) == 0;
+	}
+
+
+	static bool _TruncateFile(int _iFile, size_t _uSize) {
+		return _chsize_s(_iFile, static_cast<__int64>(_uSize)) == 0;
+	}
+
+
+	static void _CloseFile(int _iFile) {
+		_close(_iFile);
+	}
+
+
+	// renames are made durable by NTFS metadata journaling
+	static void _SyncDirectory(const std::string&) {}
+#else
+	static int _OpenFile(const std::string& _sPath) {
+		return open(_sPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	}
+
+
+	static bool _WriteFile(int _iFile, const char* _pData, size_t _uLen) {
+		while (_uLen) {
+			const ssize_t iWritten = write(_iFile, _pData, _uLen);
+			if (iWritten < 0 && errno == EINTR)
+				continue;
+			if (iWritten <= 0)
+				return false;
+			_pData += iWritten;
+			_uLen -= static_cast<size_t>(iWritten);
+		}
+
+		return true;
+	}
+
+
+	static bool _SyncFile(int _iFile) {
+		return fsync(_iFile) == 0;
+	}
+
+
+	static bool _TruncateFile(int _iFile, size_t _uSize) {
+		return ftruncate(_iFile, static_cast<off_t>(_uSize)) == 0;
+	}
+
+
+	static void _CloseFile(int _iFile) {
+		close(_iFile);
+	}
+
+
+	// directory entries of created and renamed files are persisted by syncing the directory itself
+	static void _SyncDirectory(const std::string& _sPath) {
+		std::filesystem::path directory = std::filesystem::path(_sPath).parent_path();
+		if (directory.empty())
+			directory = ".";
+
+		const int iDirectory = open(directory.c_str(), O_RDONLY | O_CLOEXEC);
+		if (iDirectory >= 0) {
+			fsync(iDirectory);
+			close(iDirectory);
+		}
+	}
+#endif
+
+
+	static inline void _PutBytes(std::vector<char>& _buffer, const void* _pData, size_t _uLen) {
+		const char* pData = static_cast<const char*>(_pData);
+		_buffer.insert(_buffer.end(), pData, pData + _uLen);
+	}
+
+
+	static inline void _PutU32(std::vector<char>& _buffer, uint32_t _uValue) {
+		_PutBytes(_buffer, &_uValue, sizeof(uint32_t));
+	}
+
+
+	static inline void _PutString(std::vector<char>& _buffer, std::string_view _sText) {
+		_PutU32(_buffer, static_cast<uint32_t>(_sText.size()));
+		_PutBytes(_buffer, _sText.data(), _sText.size());
+	}
+
+
+	template <typename T>
+	static inline void _PutSpan(std::vector<char>& _buffer, const List& _list) {
+		const Span<T> span = _list.GetSpan<T>();
+		_PutU32(_buffer, static_cast<uint32_t>(span.size()));
+		_PutBytes(_buffer, span.data(), span.size() * sizeof(T));
+	}
+
+
+	static void _EncodeValue(std::vector<char>& _buffer, const Value& _val) {
+		_buffer.push_back(static_cast<char>(_val.index()));
+
+		switch (_val.index()) {
+			case Type_Int:
+				_PutBytes(_buffer, &std::get<Int>(_val), sizeof(Int));
+				break;
+
+			case Type_Float:
+				_PutBytes(_buffer, &std::get<Float>(_val), sizeof(Float));
+				break;
+
+			case Type_Bool:
+				_buffer.push_back(std::get<Bool>(_val) ? 1 : 0);
+				break;
+
+			case Type_String:
+				_PutString(_buffer, std::get<String>(_val).GetView());
+				break;
+
+			case Type_List:
+			{
+				const List& list = std::get<List>(_val);
+				const Type packedType = list.GetPackedType();
+				_buffer.push_back(static_cast<char>(packedType));
+
+				if (packedType == Type_Int)
+					_PutSpan<Int>(_buffer, list);
+				else if (packedType == Type_Float)
+					_PutSpan<Float>(_buffer, list);
+				else if (packedType == Type_Bool)
+					_PutSpan<Bool>(_buffer, list);
+				else {
+					_PutU32(_buffer, static_cast<uint32_t>(list.Size()));
+					for (auto it = list.Begin(); it != list.End(); it++)
+						_EncodeValue(_buffer, *it);
+				}
+				break;
+			}
+
+			case Type_Object:
+			{
+				const ObjectMap& contents = std::get<std::shared_ptr<Object>>(_val)->GetContents();
+				_PutU32(_buffer, static_cast<uint32_t>(contents.size()));
+				for (auto it = contents.begin(); it != contents.end(); it++) {
+					_PutString(_buffer, it->first.GetSTDString());
+					_EncodeValue(_buffer, it->second);
+				}
+				break;
+			}
+
+			default:
+				break;
+		}
+	}
+
+
+	// bounds checked reader of a record payload
+	struct _RecordReader {
+		const char* pData;
+		const char* pEnd;
+
+		inline bool Read(void* _pOut, size_t _uLen) {
+			if (static_cast<size_t>(pEnd - pData) < _uLen)
+				return false;
+			std::memcpy(_pOut, pData, _uLen);
+			pData += _uLen;
+			return true;
+		}
+
+		inline bool ReadU32(uint32_t& _uValue) {
+			return Read(&_uValue, sizeof(uint32_t));
+		}
+
+		inline bool ReadString(std::string_view& _sText) {
+			uint32_t uLen = 0;
+			if (!ReadU32(uLen) || static_cast<size_t>(pEnd - pData) < uLen)
+				return false;
+			_sText = std::string_view(pData, uLen);
+			pData += uLen;
+			return true;
+		}
+	};
+
+
+	template <typename T>
+	static bool _DecodeSpan(_RecordReader& _reader, Value& _val) {
+		uint32_t uCount = 0;
+		if (!_reader.ReadU32(uCount) || static_cast<size_t>(_reader.pEnd - _reader.pData) / sizeof(T) < uCount)
+			return false;
+
+		// std::vector<Bool> isn't contiguous, thus a plain array is used
+		std::unique_ptr<T[]> items = std::make_unique<T[]>(uCount);
+		_reader.Read(items.get(), uCount * sizeof(T));
+		_val.emplace<List>(items.get(), static_cast<size_t>(uCount));
+		return true;
+	}
+
+
+	static bool _DecodeValue(_RecordReader& _reader, Value& _val) {
+		uint8_t uType = 0;
+		if (!_reader.Read(&uType, sizeof(uint8_t)))
+			return false;
+
+		switch (uType) {
+			case Type_None:
+				_val.emplace<std::monostate>();
+				return true;
+
+			case Type_Int:
+				return _reader.Read(&_val.emplace<Int>(), sizeof(Int));
+
+			case Type_Float:
+				return _reader.Read(&_val.emplace<Float>(), sizeof(Float));
+
+			case Type_Bool:
+			{
+				uint8_t uBool = 0;
+				if (!_reader.Read(&uBool, sizeof(uint8_t)))
+					return false;
+				_val.emplace<Bool>(uBool != 0);
+				return true;
+			}
+
+			case Type_String:
+			{
+				std::string_view sText;
+				if (!_reader.ReadString(sText))
+					return false;
+				_val.emplace<String>(std::string(sText));
+				return true;
+			}
+
+			case Type_List:
+			{
+				uint8_t uPackedType = 0;
+				if (!_reader.Read(&uPackedType, sizeof(uint8_t)))
+					return false;
+
+				if (uPackedType == Type_Int)
+					return _DecodeSpan<Int>(_reader, _val);
+				else if (uPackedType == Type_Float)
+					return _DecodeSpan<Float>(_reader, _val);
+				else if (uPackedType == Type_Bool)
+					return _DecodeSpan<Bool>(_reader, _val);
+
+				uint32_t uCount = 0;
+				if (!_reader.ReadU32(uCount))
+					return false;
+
+				List list;
+				for (uint32_t i = 0; i < uCount; i++) {
+					Value item;
+					if (!_DecodeValue(_reader, item))
+						return false;
+					list.PushBack(std::move(item));
+				}
+				_val.emplace<List>(std::move(list));
+				return true;
+			}
+
+			case Type_Object:
+			{
+				uint32_t uCount = 0;
+				if (!_reader.ReadU32(uCount))
+					return false;
+
+				std::shared_ptr<Object> pObject = std::make_shared<Object>();
+				for (uint32_t i = 0; i < uCount; i++) {
+					std::string_view sKey;
+					Value item;
+					if (!_reader.ReadString(sKey) || !_DecodeValue(_reader, item))
+						return false;
+					pObject->GetContents().emplace(std::make_pair(Symbol(std::string(sKey)), std::move(item)));
+				}
+				_val.emplace<std::shared_ptr<Object>>(std::move(pObject));
+				return true;
+			}
+
+			default:
+				return false;
+		}
+	}
+
+
+	Journal::Journal(CVarSystem& _system, const std::string& _sSnapshotPath, const std::string& _sJournalPath, const JournalOptions& _options) :
+		m_system(_system),
+		m_sSnapshotPath(_sSnapshotPath),
+		m_sJournalPath(_sJournalPath),
+		m_options(_options)
+	{
+	}
+
+
+	Journal::~Journal() {
+		Close();
+	}
+
+
+	void Journal::_OnChange(const std::string& _sKey, const Value* _pValue) {
+		// empty key is only reported when the whole tree has been loaded or restored, records written so far no
+		// longer apply to it, thus the new tree becomes the snapshot
+		if (_sKey.empty()) {
+			Compact();
+			return;
+		}
+
+		if (_pValue)
+			_Append(_sKey, *_pValue);
+	}
+
+
+	void Journal::_Append(const std::string& _sKey, const Value& _val) {
+		m_record.resize(s_uRecordHeaderSize);
+		_PutString(m_record, _sKey);
+		_EncodeValue(m_record, _val);
+
+		const uint32_t uPayloadSize = static_cast<uint32_t>(m_record.size() - s_uRecordHeaderSize);
+		const uint32_t uChecksum = RuntimeCrc32(m_record.data() + s_uRecordHeaderSize, uPayloadSize);
+		std::memcpy(m_record.data(), &uPayloadSize, sizeof(uint32_t));
+		std::memcpy(m_record.data() + sizeof(uint32_t), &uChecksum, sizeof(uint32_t));
+
+		std::unique_lock<std::mutex> lock(m_mtx);
+		if (m_iFile < 0 || m_bError)
+			return;
+		m_uSize += m_record.size();
+
+		if (m_options.sync == JournalSync::Always) {
+			m_bError = !_WriteFile(m_iFile, m_record.data(), m_record.size()) || !_SyncFile(m_iFile);
+			return;
+		}
+
+		// records are written in batches by the journal thread, thus writes don't wait for system calls
+		const size_t uBuffered = m_buffer.size();
+		m_buffer.insert(m_buffer.end(), m_record.begin(), m_record.end());
+		if (uBuffered < s_uFlushSize && m_buffer.size() >= s_uFlushSize) {
+			lock.unlock();
+			m_cv.notify_all();
+		}
+	}
+
+
+	size_t Journal::_Replay(const std::string& _sPath) {
+		std::ifstream stream(_sPath, std::ios::binary);
+		if (!stream)
+			return 0;
+
+		const std::string sContents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+		if (sContents.size() < s_uHeaderSize || std::memcmp(sContents.data(), s_szMagic, s_uHeaderSize) != 0)
+			return 0;
+
+		// replay stops at the first incomplete or corrupted record, which was being written when the process stopped
+		size_t uOffset = s_uHeaderSize;
+		while (sContents.size() - uOffset >= s_uRecordHeaderSize) {
+			uint32_t uPayloadSize = 0, uChecksum = 0;
+			std::memcpy(&uPayloadSize, sContents.data() + uOffset, sizeof(uint32_t));
+			std::memcpy(&uChecksum, sContents.data() + uOffset + sizeof(uint32_t), sizeof(uint32_t));
+
+			const char* pPayload = sContents.data() + uOffset + s_uRecordHeaderSize;
+			if (sContents.size() - uOffset - s_uRecordHeaderSize < uPayloadSize || RuntimeCrc32(pPayload, uPayloadSize) != uChecksum)
+				break;
+
+			_RecordReader reader = { pPayload, pPayload + uPayloadSize };
+			std::string_view sKey;
+			Value val;
+			if (!reader.ReadString(sKey) || !_DecodeValue(reader, val))
+				break;
+
+			std::visit([&](auto&& _val) {
+				using T = std::decay_t<decltype(_val)>;
+				if constexpr (!std::is_same_v<T, std::monostate>)
+					m_system.Set<T>(String(std::string(sKey)), std::move(_val));
+			}, val);
+
+			uOffset += s_uRecordHeaderSize + uPayloadSize;
+		}
+
+		return uOffset;
+	}
+
+
+	bool Journal::_OpenLog(size_t _uValidSize) {
+		const int iFile = _OpenFile(m_sJournalPath);
+		if (iFile < 0)
+			return false;
+
+		bool bOk = true;
+		if (_uValidSize < s_uHeaderSize) {
+			bOk = _TruncateFile(iFile, 0) && _WriteFile(iFile, s_szMagic, s_uHeaderSize);
+			_uValidSize = s_uHeaderSize;
+		}
+		else bOk = _TruncateFile(iFile, _uValidSize);
+
+		if (!bOk || !_SyncFile(iFile)) {
+			_CloseFile(iFile);
+			return false;
+		}
+		_SyncDirectory(m_sJournalPath);
+
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_iFile = iFile;
+		m_uSize = _uValidSize;
+		m_buffer.clear();
+		m_bUnsynced = false;
+		return true;
+	}
+
+
+	void Journal::_Flush(std::unique_lock<std::mutex>& _lock, bool _bSync) {
+		// records buffered later must not overtake the ones being written by the journal thread
+		m_cv.wait(_lock, [this]() { return !m_bFlushing; });
+		if (m_iFile < 0)
+			return;
+
+		if (!m_buffer.empty()) {
+			if (!_WriteFile(m_iFile, m_buffer.data(), m_buffer.size()))
+				m_bError = true;
+			m_buffer.clear();
+			m_bUnsynced = true;
+		}
+
+		if (_bSync && m_bUnsynced) {
+			if (!_SyncFile(m_iFile))
+				m_bError = true;
+			m_bUnsynced = false;
+		}
+	}
+
+
+	void Journal::_CloseLog(std::unique_lock<std::mutex>& _lock) {
+		_Flush(_lock, m_options.sync != JournalSync::Never);
+		if (m_iFile < 0)
+			return;
+
+		_CloseFile(m_iFile);
+		m_iFile = -1;
+	}
+
+
+	bool Journal::_Rotate(std::unique_lock<std::mutex>& _lock) {
+		_CloseLog(_lock);
+
+		std::error_code err;
+		const std::string sRotated = GetRotatedPath();
+		if (!std::filesystem::exists(sRotated, err)) {
+			std::filesystem::rename(m_sJournalPath, sRotated, err);
+			if (err)
+				return false;
+		}
+		else {
+			// snapshot of the previous compaction wasn't written, thus its rotated journal is still needed and
+			// records of the current journal are appended to it
+			std::ifstream stream(m_sJournalPath, std::ios::binary);
+			const std::string sContents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+			stream.close();
+
+			const int iRotated = _OpenFile(sRotated);
+			if (iRotated < 0)
+				return false;
+			const bool bOk = sContents.size() <= s_uHeaderSize ||
+				(_WriteFile(iRotated, sContents.data() + s_uHeaderSize, sContents.size() - s_uHeaderSize) && _SyncFile(iRotated));
+			_CloseFile(iRotated);
+			if (!bOk)
+				return false;
+		}
+
+		_lock.unlock();
+		const bool bOpened = _OpenLog(0);
+		_lock.lock();
+		return bOpened;
+	}
+
+
+	bool Journal::_WriteSnapshot(const Snapshot& _snapshot) const {
+		const std::string sTemporary = m_sSnapshotPath + ".tmp";
+		{
+			std::ofstream stream(sTemporary, std::ios::binary | std::ios::trunc);
+			if (!stream)
+				return false;
+
+			// serializers take a mutable root, however the snapshot is only read
+			JSONSerializer serializer(stream, const_cast<ObjectMap&>(_snapshot.GetRoot()));
+			serializer.Serialize(false);
+			stream.close();
+			if (stream.fail())
+				return false;
+		}
+
+		// contents must reach the disk before the rename, otherwise a crash could leave an empty snapshot
+		const int iFile = _OpenFile(sTemporary);
+		if (iFile < 0)
+			return false;
+		const bool bSynced = _SyncFile(iFile);
+		_CloseFile(iFile);
+		if (!bSynced)
+			return false;
+
+		std::error_code err;
+		std::filesystem::rename(sTemporary, m_sSnapshotPath, err);
+		if (err)
+			return false;
+
+		_SyncDirectory(m_sSnapshotPath);
+		return true;
+	}
+
+
+	void Journal::_FinishCompaction(bool _bWritten) {
+		// rotated journal is kept if the snapshot couldn't be written, next compaction appends to it
+		if (_bWritten) {
+			std::error_code err;
+			std::filesystem::remove(GetRotatedPath(), err);
+		}
+
+		m_bCompacting = false;
+		m_cv.notify_all();
+	}
+
+
+	void Journal::_Run() {
+		const auto interval = std::chrono::milliseconds(m_options.uSyncIntervalMs);
+		std::unique_lock<std::mutex> lock(m_mtx);
+
+		while (true) {
+			// pending snapshot is written even if the journal is being closed
+			if (m_pendingSnapshot) {
+				Snapshot snapshot = std::move(m_pendingSnapshot);
+				m_pendingSnapshot = Snapshot();
+				lock.unlock();
+
+				const bool bWritten = _WriteSnapshot(snapshot);
+				// nodes shared with the live tree are released before the next write can copy them needlessly
+				snapshot = Snapshot();
+
+				lock.lock();
+				_FinishCompaction(bWritten);
+				continue;
+			}
+
+			// records are written without holding the lock, thus appending more records doesn't wait for the disk
+			if (m_iFile >= 0 && !m_buffer.empty()) {
+				const int iFile = m_iFile;
+				const bool bSync = m_options.sync == JournalSync::Periodic;
+				m_flushing.swap(m_buffer);
+				m_bFlushing = true;
+				lock.unlock();
+
+				const bool bWritten = _WriteFile(iFile, m_flushing.data(), m_flushing.size()) && (!bSync || _SyncFile(iFile));
+
+				lock.lock();
+				m_flushing.clear();
+				m_bFlushing = false;
+				m_bUnsynced = !bSync;
+				if (!bWritten)
+					m_bError = true;
+				m_cv.notify_all();
+
+				if (m_buffer.size() >= s_uFlushSize)
+					continue;
+			}
+
+			if (m_bStop)
+				break;
+
+			m_cv.wait_for(lock, interval);
+		}
+	}
+
+
+	bool Journal::Open() {
+		if (m_bOpen)
+			return true;
+
+		std::error_code err;
+		if (std::filesystem::exists(m_sSnapshotPath, err))
+			m_system.Unserialize<JSONUnserializer>(m_sSnapshotPath);
+
+		// rotated journal is left behind if the process stopped before the snapshot of the last compaction was
+		// written, its records precede the ones in the current journal
+		const std::string sRotated = GetRotatedPath();
+		const bool bRotated = std::filesystem::exists(sRotated, err);
+		if (bRotated)
+			_Replay(sRotated);
+		size_t uValidSize = _Replay(m_sJournalPath);
+
+		if (bRotated) {
+			if (!_WriteSnapshot(m_system.TakeSnapshot()))
+				return false;
+			std::filesystem::remove(sRotated, err);
+			uValidSize = 0;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mtx);
+			m_bError = false;
+			m_bStop = false;
+		}
+
+		if (!_OpenLog(uValidSize))
+			return false;
+
+		m_uSubscription = m_system.Subscribe("", [this](const std::string& _sKey, const Value* _pValue) {
+			_OnChange(_sKey, _pValue);
+		});
+		m_thread = std::thread(&Journal::_Run, this);
+		m_bOpen = true;
+		return true;
+	}
+
+
+	void Journal::Close() {
+		if (!m_bOpen)
+			return;
+
+		m_system.Unsubscribe(m_uSubscription);
+		{
+			std::lock_guard<std::mutex> lock(m_mtx);
+			m_bStop = true;
+		}
+		m_cv.notify_all();
+		m_thread.join();
+
+		std::unique_lock<std::mutex> lock(m_mtx);
+		_CloseLog(lock);
+		m_bOpen = false;
+	}
+
+
+	void Journal::Update() {
+		if (!m_bOpen)
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mtx);
+			if (m_bCompacting || m_uSize < m_options.uCompactionThreshold)
+				return;
+		}
+
+		Compact();
+	}
+
+
+	bool Journal::Compact(bool _bWait) {
+		if (!m_bOpen)
+			return false;
+
+		// synchronizing atomics might append records, thus the snapshot is taken before the lock
+		Snapshot snapshot = m_system.TakeSnapshot();
+
+		std::unique_lock<std::mutex> lock(m_mtx);
+		m_cv.wait(lock, [this]() { return !m_bCompacting; });
+		if (!_Rotate(lock)) {
+			m_bError = true;
+			return false;
+		}
+
+		m_bCompacting = true;
+		if (!_bWait) {
+			m_pendingSnapshot = std::move(snapshot);
+			m_cv.notify_all();
+			return true;
+		}
+
+		lock.unlock();
+		const bool bWritten = _WriteSnapshot(snapshot);
+		lock.lock();
+		_FinishCompaction(bWritten);
+		return bWritten;
+	}
+
+
+	void Journal::Sync() {
+		std::unique_lock<std::mutex> lock(m_mtx);
+		_Flush(lock, true);
+	}
+}
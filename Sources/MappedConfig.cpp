@@ -0,0 +1,474 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: MappedConfig.cpp - read-only access to memory mapped binary CVar images implementation
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <cstring>
+#include <cvar/MappedConfig.h>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace cvar {
+
+	static inline size_t _PackedSize(uint32_t _uPackedType) {
+		return _uPackedType == Type_Bool ? sizeof(Bool) : sizeof(Int);
+	}
+
+
+	const BinaryObject* BinaryImage::Validate() {
+		if (!pData || uSize < sizeof(BinaryHeader) || reinterpret_cast<uintptr_t>(pData) % s_uBinaryAlignment)
+			return nullptr;
+
+		BinaryHeader header;
+		std::memcpy(&header, pData, sizeof(BinaryHeader));
+		if (std::memcmp(header.szMagic, s_szBinaryMagic, sizeof(s_szBinaryMagic)) != 0 || header.uSize > uSize)
+			return nullptr;
+
+		// trailing bytes of the file are not part of the image
+		uSize = header.uSize;
+		bNativeHashes = header.uHashId == s_uBinaryHashId;
+
+		const BinarySlot root = { Type_Object, {}, header.uRootOffset };
+		if (root.uData % s_uBinaryAlignment || static_cast<size_t>(root.uData) + sizeof(BinaryObject) > uSize)
+			return nullptr;
+
+		const BinaryObject* pRoot = reinterpret_cast<const BinaryObject*>(pData + root.uData);
+		if ((uSize - root.uData - sizeof(BinaryObject)) / (sizeof(BinaryEntry) + sizeof(uint32_t)) < pRoot->uCount)
+			return nullptr;
+		return pRoot;
+	}
+
+
+	template <typename T>
+	const T* MappedValue::_Block(uint32_t _uOffset, size_t _uTrailing) const {
+		if (_uOffset % s_uBinaryAlignment || _uOffset > m_pImage->uSize || m_pImage->uSize - _uOffset < sizeof(T) ||
+			m_pImage->uSize - _uOffset - sizeof(T) < _uTrailing)
+			return nullptr;
+		return reinterpret_cast<const T*>(m_pImage->pData + _uOffset);
+	}
+
+
+	const BinaryString* MappedValue::_String(uint32_t _uOffset) const {
+		const BinaryString* pString = _Block<BinaryString>(_uOffset);
+		if (!pString || !_Block<BinaryString>(_uOffset, static_cast<size_t>(pString->uLength) + 1))
+			return nullptr;
+		return pString;
+	}
+
+
+	const BinaryObject* MappedValue::_Object() const {
+		if (GetType() != Type_Object)
+			return nullptr;
+
+		const BinaryObject* pObject = _Block<BinaryObject>(m_slot.uData);
+		if (!pObject || !_Block<BinaryObject>(m_slot.uData, static_cast<size_t>(pObject->uCount) * (sizeof(BinaryEntry) + sizeof(uint32_t))))
+			return nullptr;
+		return pObject;
+	}
+
+
+	const BinaryList* MappedValue::_List() const {
+		if (GetType() != Type_List)
+			return nullptr;
+
+		const BinaryList* pList = _Block<BinaryList>(m_slot.uData);
+		if (!pList)
+			return nullptr;
+
+		size_t uItemSize = sizeof(BinarySlot);
+		if (pList->uPackedType == Type_Int || pList->uPackedType == Type_Float || pList->uPackedType == Type_Bool)
+			uItemSize = _PackedSize(pList->uPackedType);
+		else if (pList->uPackedType != Type_None)
+			return nullptr;
+
+		if (!_Block<BinaryList>(m_slot.uData, static_cast<size_t>(pList->uCount) * uItemSize))
+			return nullptr;
+		return pList;
+	}
+
+
+	Int MappedValue::GetInt(Int _default) const {
+		if (GetType() != Type_Int)
+			return _default;
+
+		Int iValue;
+		std::memcpy(&iValue, &m_slot.uData, sizeof(Int));
+		return iValue;
+	}
+
+
+	Float MappedValue::GetFloat(Float _default) const {
+		if (GetType() != Type_Float)
+			return _default;
+
+		Float fValue;
+		std::memcpy(&fValue, &m_slot.uData, sizeof(Float));
+		return fValue;
+	}
+
+
+	Bool MappedValue::GetBool(Bool _default) const {
+		if (GetType() != Type_Bool)
+			return _default;
+		return m_slot.uData != 0;
+	}
+
+
+	std::string_view MappedValue::GetString() const {
+		if (GetType() != Type_String)
+			return std::string_view();
+
+		const BinaryString* pString = _String(m_slot.uData);
+		if (!pString)
+			return std::string_view();
+		return std::string_view(reinterpret_cast<const char*>(pString + 1), pString->uLength);
+	}
+
+
+	size_t MappedValue::Size() const {
+		if (const BinaryObject* pObject = _Object())
+			return pObject->uCount;
+		if (const BinaryList* pList = _List())
+			return pList->uCount;
+		return 0;
+	}
+
+
+	MappedValue MappedValue::At(size_t _uIndex) const {
+		if (const BinaryObject* pObject = _Object()) {
+			if (_uIndex >= pObject->uCount)
+				return MappedValue();
+			return MappedValue(m_pImage, reinterpret_cast<const BinaryEntry*>(pObject + 1)[_uIndex].slot);
+		}
+
+		const BinaryList* pList = _List();
+		if (!pList || _uIndex >= pList->uCount)
+			return MappedValue();
+
+		if (pList->uPackedType == Type_None)
+			return MappedValue(m_pImage, reinterpret_cast<const BinarySlot*>(pList + 1)[_uIndex]);
+
+		// packed elements are stored inline in the slot of the returned view
+		BinarySlot slot = { static_cast<uint8_t>(pList->uPackedType), {}, 0 };
+		const size_t uItemSize = _PackedSize(pList->uPackedType);
+		std::memcpy(&slot.uData, reinterpret_cast<const char*>(pList + 1) + _uIndex * uItemSize, uItemSize);
+		return MappedValue(m_pImage, slot);
+	}
+
+
+	std::string_view MappedValue::KeyAt(size_t _uIndex) const {
+		const BinaryObject* pObject = _Object();
+		if (!pObject || _uIndex >= pObject->uCount)
+			return std::string_view();
+
+		const BinaryString* pKey = _String(reinterpret_cast<const BinaryEntry*>(pObject + 1)[_uIndex].uKeyOffset);
+		if (!pKey)
+			return std::string_view();
+		return std::string_view(reinterpret_cast<const char*>(pKey + 1), pKey->uLength);
+	}
+
+
+	MappedValue MappedValue::Find(std::string_view _sPath) const {
+		MappedValue current = *this;
+		size_t uBeginPos = 0;
+
+		while (uBeginPos <= _sPath.size()) {
+			size_t uPos = _sPath.find('.', uBeginPos);
+			if (uPos == std::string_view::npos)
+				uPos = _sPath.size();
+			const std::string_view sSegment = _sPath.substr(uBeginPos, uPos - uBeginPos);
+			uBeginPos = uPos + 1;
+
+			const BinaryObject* pObject = current._Object();
+			if (!pObject)
+				return MappedValue();
+
+			const BinaryEntry* pEntries = reinterpret_cast<const BinaryEntry*>(pObject + 1);
+			const uint32_t* pSorted = reinterpret_cast<const uint32_t*>(pEntries + pObject->uCount);
+			const BinaryEntry* pFound = nullptr;
+
+			if (m_pImage->bNativeHashes) {
+				// entries with the same key hash are adjacent in the sorted index
+				const uint64_t uHash = static_cast<uint64_t>(RUNTIME_CRC_RANGE(sSegment.data(), sSegment.size()));
+				const uint32_t* pEnd = pSorted + pObject->uCount;
+				const uint32_t* pIndex = std::lower_bound(pSorted, pEnd, uHash, [&](uint32_t _uEntry, uint64_t _uHash) {
+					return _uEntry < pObject->uCount && pEntries[_uEntry].uKeyHash < _uHash;
+				});
+
+				for (; pIndex != pEnd && *pIndex < pObject->uCount && pEntries[*pIndex].uKeyHash == uHash; pIndex++) {
+					const BinaryString* pKey = current._String(pEntries[*pIndex].uKeyOffset);
+					if (pKey && std::string_view(reinterpret_cast<const char*>(pKey + 1), pKey->uLength) == sSegment) {
+						pFound = pEntries + *pIndex;
+						break;
+					}
+				}
+			}
+			else {
+				for (uint32_t i = 0; i < pObject->uCount && !pFound; i++) {
+					const BinaryString* pKey = current._String(pEntries[i].uKeyOffset);
+					if (pKey && std::string_view(reinterpret_cast<const char*>(pKey + 1), pKey->uLength) == sSegment)
+						pFound = pEntries + i;
+				}
+			}
+
+			if (!pFound)
+				return MappedValue();
+			current = MappedValue(m_pImage, pFound->slot);
+		}
+
+		return current;
+	}
+
+
+	Value MappedValue::_MaterializeShallow() const {
+		switch (GetType()) {
+			case Type_Int:
+				return GetInt();
+
+			case Type_Float:
+				return GetFloat();
+
+			case Type_Bool:
+				return GetBool();
+
+			case Type_String:
+			{
+				const BinaryString* pString = _String(m_slot.uData);
+				if (!pString)
+					return std::monostate();
+
+				const std::string_view sText(reinterpret_cast<const char*>(pString + 1), pString->uLength);
+				if (m_pImage->bNativeHashes)
+					return String(sText, static_cast<hash_t>(pString->uHash));
+				return String(sText, RUNTIME_CRC_RANGE(sText.data(), sText.size()));
+			}
+
+			case Type_List:
+			{
+				const BinaryList* pList = _List();
+				if (!pList)
+					return List();
+
+				// packed arrays are copied as a whole
+				if (pList->uPackedType == Type_Int)
+					return List(reinterpret_cast<const Int*>(pList + 1), pList->uCount);
+				if (pList->uPackedType == Type_Float)
+					return List(reinterpret_cast<const Float*>(pList + 1), pList->uCount);
+				if (pList->uPackedType == Type_Bool)
+					return List(reinterpret_cast<const Bool*>(pList + 1), pList->uCount);
+				return List();
+			}
+
+			case Type_Object:
+				return std::make_shared<Object>();
+
+			default:
+				return std::monostate();
+		}
+	}
+
+
+	bool MappedValue::_HasChildren() const {
+		if (GetType() == Type_Object)
+			return true;
+
+		const BinaryList* pList = GetType() == Type_List ? _List() : nullptr;
+		return pList && pList->uPackedType == Type_None && pList->uCount;
+	}
+
+
+	void MappedValue::_MaterializeChildren(List* _pList, ObjectMap* _pContents) const {
+		// nested lists and objects are filled depth first with an explicit stack, thus the depth of the image
+		// is not limited by the call stack. A container is paused while its children are filled, thus the
+		// pointers to it stay valid until it is popped.
+		struct Frame {
+			MappedValue source;
+			uint32_t uNext;
+			List* pList;
+			ObjectMap* pContents;
+		};
+
+		std::vector<Frame> stckFrames;
+		stckFrames.push_back(Frame{ *this, 0, _pList, _pContents });
+		while (!stckFrames.empty()) {
+			Frame& top = stckFrames.back();
+			const MappedValue& source = top.source;
+			const uint32_t uParent = source.m_slot.uData;
+			const BinaryImage* pImage = source.m_pImage;
+
+			Value* pChild = nullptr;
+			BinarySlot slot = {};
+			if (top.pList) {
+				const BinaryList* pList = source._List();
+				if (!pList || top.uNext >= pList->uCount) {
+					stckFrames.pop_back();
+					continue;
+				}
+
+				slot = reinterpret_cast<const BinarySlot*>(pList + 1)[top.uNext++];
+
+				// blocks are always written after their parent, thus cycles in a corrupted image are skipped
+				if ((slot.uType == Type_List || slot.uType == Type_Object) && slot.uData <= uParent)
+					continue;
+
+				const MappedValue child(pImage, slot);
+				top.pList->PushBack(child._MaterializeShallow());
+				if (!child._HasChildren())
+					continue;
+
+				// containers are never packed, thus the list isn't unpacked by Back()
+				pChild = &top.pList->Back();
+			}
+			else {
+				const BinaryObject* pObject = source._Object();
+				if (!pObject || top.uNext >= pObject->uCount) {
+					stckFrames.pop_back();
+					continue;
+				}
+
+				const BinaryEntry& entry = reinterpret_cast<const BinaryEntry*>(pObject + 1)[top.uNext++];
+				const BinaryString* pKey = source._String(entry.uKeyOffset);
+				slot = entry.slot;
+				if (!pKey || ((slot.uType == Type_List || slot.uType == Type_Object) && slot.uData <= uParent))
+					continue;
+
+				// stored key hashes spare hashing every key again when it is interned
+				const std::string_view sKey(reinterpret_cast<const char*>(pKey + 1), pKey->uLength);
+				const hash_t hshKey = pImage->bNativeHashes ? static_cast<hash_t>(entry.uKeyHash) : RUNTIME_CRC_RANGE(sKey.data(), sKey.size());
+				auto result = top.pContents->try_emplace(Symbol(sKey, hshKey), MappedValue(pImage, slot)._MaterializeShallow());
+				if (!result.second || !MappedValue(pImage, slot)._HasChildren())
+					continue;
+				pChild = &result.first->second;
+			}
+
+			// the parent frame is paused until its child is filled
+			const MappedValue child(pImage, slot);
+			if (auto pObject = std::get_if<std::shared_ptr<Object>>(pChild)) {
+				ObjectMap& contents = pObject->get()->GetContents();
+				if (const BinaryObject* pBinaryObject = child._Object())
+					contents.reserve(pBinaryObject->uCount);
+				stckFrames.push_back(Frame{ child, 0, nullptr, &contents });
+			}
+			else stckFrames.push_back(Frame{ child, 0, &std::get<List>(*pChild), nullptr });
+		}
+	}
+
+
+	Value MappedValue::Materialize() const {
+		Value val = _MaterializeShallow();
+		if (!_HasChildren())
+			return val;
+
+		if (auto pObject = std::get_if<std::shared_ptr<Object>>(&val))
+			MaterializeInto(pObject->get()->GetContents());
+		else _MaterializeChildren(&std::get<List>(val), nullptr);
+		return val;
+	}
+
+
+	void MappedValue::MaterializeInto(ObjectMap& _contents) const {
+		const BinaryObject* pObject = _Object();
+		if (!pObject)
+			return;
+
+		_contents.reserve(_contents.size() + pObject->uCount);
+		_MaterializeChildren(nullptr, &_contents);
+	}
+
+
+	MappedConfig::~MappedConfig() {
+		Close();
+	}
+
+
+	bool MappedConfig::Open(const std::string& _sFileName) {
+		Close();
+
+#ifdef _WIN32
+		HANDLE hFile = CreateFileA(_sFileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (hFile == INVALID_HANDLE_VALUE)
+			return false;
+		m_hFile = hFile;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(hFile, &size) || size.QuadPart < static_cast<LONGLONG>(sizeof(BinaryHeader))) {
+			Close();
+			return false;
+		}
+
+		m_hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		const void* pData = m_hMapping ? MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (!pData) {
+			Close();
+			return false;
+		}
+		m_uMappedSize = static_cast<size_t>(size.QuadPart);
+#else
+		const int iFile = open(_sFileName.c_str(), O_RDONLY | O_CLOEXEC);
+		if (iFile < 0)
+			return false;
+
+		struct stat status;
+		if (fstat(iFile, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(BinaryHeader))) {
+			close(iFile);
+			return false;
+		}
+
+		// mapping stays valid after the descriptor is closed
+		void* pData = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, iFile, 0);
+		close(iFile);
+		if (pData == MAP_FAILED)
+			return false;
+		m_uMappedSize = static_cast<size_t>(status.st_size);
+#endif
+
+		m_image.pData = static_cast<const char*>(pData);
+		m_image.uSize = m_uMappedSize;
+		m_pRoot = m_image.Validate();
+		if (!m_pRoot) {
+			Close();
+			return false;
+		}
+
+		return true;
+	}
+
+
+	void MappedConfig::Close() {
+#ifdef _WIN32
+		if (m_image.pData)
+			UnmapViewOfFile(m_image.pData);
+		if (m_hMapping)
+			CloseHandle(m_hMapping);
+		if (m_hFile)
+			CloseHandle(m_hFile);
+		m_hMapping = nullptr;
+		m_hFile = nullptr;
+#else
+		if (m_image.pData)
+			munmap(const_cast<char*>(m_image.pData), m_uMappedSize);
+#endif
+
+		m_image = BinaryImage();
+		m_pRoot = nullptr;
+		m_uMappedSize = 0;
+	}
+
+
+	MappedValue MappedConfig::GetRoot() const {
+		if (!m_pRoot)
+			return MappedValue();
+
+		const BinarySlot root = { Type_Object, {}, static_cast<uint32_t>(reinterpret_cast<const char*>(m_pRoot) - m_image.pData) };
+		return MappedValue(&m_image, root);
+	}
+}
@@ -0,0 +1,205 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: MessagePackSerializer.cpp - MessagePack serializer class implementation
+// author: Karl-Mihkel Ott
+
+#include <cvar/MessagePackSerializer.h>
+#include <cstring>
+#include <vector>
+
+namespace cvar {
+
+    // encoded output is handed to the stream in blocks of this size
+    static constexpr size_t s_uFlushSize = 64 << 10;
+
+    static inline void _PutBE(std::string& _buffer, uint32_t _uValue, size_t _uLen) {
+        for (size_t i = _uLen; i > 0; i--)
+            _buffer.push_back(static_cast<char>((_uValue >> ((i - 1) * 8)) & 0xff));
+    }
+
+
+    MessagePackSerializer::MessagePackSerializer(std::ostream& _stream, ObjectMap& _root) :
+        ISerializer(_stream, _root) {}
+
+
+    void MessagePackSerializer::_Flush() {
+        m_stream.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+        m_buffer.clear();
+    }
+
+
+    void MessagePackSerializer::_WriteHeader(uint8_t _uFixed, uint32_t _uFixedMax, uint8_t _u8, uint8_t _u16, uint8_t _u32, uint32_t _uCount) {
+        if (_uCount <= _uFixedMax)
+            m_buffer.push_back(static_cast<char>(_uFixed | _uCount));
+        else if (_u8 && _uCount <= UINT8_MAX) {
+            m_buffer.push_back(static_cast<char>(_u8));
+            _PutBE(m_buffer, _uCount, 1);
+        }
+        else if (_uCount <= UINT16_MAX) {
+            m_buffer.push_back(static_cast<char>(_u16));
+            _PutBE(m_buffer, _uCount, 2);
+        }
+        else {
+            m_buffer.push_back(static_cast<char>(_u32));
+            _PutBE(m_buffer, _uCount, 4);
+        }
+    }
+
+
+    void MessagePackSerializer::_WriteInt(Int _iValue) {
+        // positive and negative fixint
+        if (_iValue >= -32 && _iValue <= 127) {
+            m_buffer.push_back(static_cast<char>(_iValue));
+            return;
+        }
+
+        const uint32_t uBits = static_cast<uint32_t>(_iValue);
+        if (_iValue > 0) {
+            if (_iValue <= UINT8_MAX) {
+                m_buffer.push_back(static_cast<char>(0xcc));
+                _PutBE(m_buffer, uBits, 1);
+            }
+            else if (_iValue <= UINT16_MAX) {
+                m_buffer.push_back(static_cast<char>(0xcd));
+                _PutBE(m_buffer, uBits, 2);
+            }
+            else {
+                m_buffer.push_back(static_cast<char>(0xce));
+                _PutBE(m_buffer, uBits, 4);
+            }
+        }
+        else if (_iValue >= INT8_MIN) {
+            m_buffer.push_back(static_cast<char>(0xd0));
+            _PutBE(m_buffer, uBits, 1);
+        }
+        else if (_iValue >= INT16_MIN) {
+            m_buffer.push_back(static_cast<char>(0xd1));
+            _PutBE(m_buffer, uBits, 2);
+        }
+        else {
+            m_buffer.push_back(static_cast<char>(0xd2));
+            _PutBE(m_buffer, uBits, 4);
+        }
+    }
+
+
+    void MessagePackSerializer::_WriteFloat(Float _fValue) {
+        uint32_t uBits;
+        std::memcpy(&uBits, &_fValue, sizeof(uint32_t));
+        m_buffer.push_back(static_cast<char>(0xca));
+        _PutBE(m_buffer, uBits, 4);
+    }
+
+
+    void MessagePackSerializer::_WriteString(std::string_view _sText) {
+        _WriteHeader(0xa0, 31, 0xd9, 0xda, 0xdb, static_cast<uint32_t>(_sText.size()));
+        m_buffer.append(_sText.data(), _sText.size());
+    }
+
+
+    void MessagePackSerializer::Serialize(bool) {
+        // containers whose elements are being written, packed lists are written as a whole and don't need a frame
+        struct Frame {
+            const ObjectMap* pMap = nullptr;
+            ObjectMap::const_iterator itMap;
+            ListIterator itList;
+            ListIterator itListEnd;
+        };
+
+        std::vector<Frame> stckFrames;
+        m_buffer.clear();
+        _WriteHeader(0x80, 15, 0, 0xde, 0xdf, static_cast<uint32_t>(m_root.size()));
+        stckFrames.emplace_back();
+        stckFrames.back().pMap = &m_root;
+        stckFrames.back().itMap = m_root.begin();
+
+        while (!stckFrames.empty()) {
+            Frame& top = stckFrames.back();
+            const Value* pValue = nullptr;
+
+            if (top.pMap) {
+                if (top.itMap == top.pMap->end()) {
+                    stckFrames.pop_back();
+                    continue;
+                }
+
+                _WriteString(top.itMap->first.GetSTDString());
+                pValue = &top.itMap->second;
+                top.itMap++;
+            }
+            else {
+                if (top.itList == top.itListEnd) {
+                    stckFrames.pop_back();
+                    continue;
+                }
+
+                pValue = &*top.itList;
+                top.itList++;
+            }
+
+            switch (pValue->index()) {
+                case Type_Int:
+                    _WriteInt(std::get<Type_Int>(*pValue));
+                    break;
+
+                case Type_Float:
+                    _WriteFloat(std::get<Type_Float>(*pValue));
+                    break;
+
+                case Type_Bool:
+                    m_buffer.push_back(static_cast<char>(std::get<Type_Bool>(*pValue) ? 0xc3 : 0xc2));
+                    break;
+
+                case Type_String:
+                    _WriteString(std::get<Type_String>(*pValue).GetView());
+                    break;
+
+                case Type_List:
+                {
+                    const List& list = std::get<Type_List>(*pValue);
+                    _WriteHeader(0x90, 15, 0, 0xdc, 0xdd, static_cast<uint32_t>(list.Size()));
+
+                    // packed elements are encoded straight from the array
+                    const Type packedType = list.GetPackedType();
+                    if (packedType == Type_Int) {
+                        for (Int iValue : list.GetSpan<Int>())
+                            _WriteInt(iValue);
+                    }
+                    else if (packedType == Type_Float) {
+                        for (Float fValue : list.GetSpan<Float>())
+                            _WriteFloat(fValue);
+                    }
+                    else if (packedType == Type_Bool) {
+                        for (Bool bValue : list.GetSpan<Bool>())
+                            m_buffer.push_back(static_cast<char>(bValue ? 0xc3 : 0xc2));
+                    }
+                    else {
+                        stckFrames.emplace_back();
+                        stckFrames.back().itList = list.Begin();
+                        stckFrames.back().itListEnd = list.End();
+                    }
+                    break;
+                }
+
+                case Type_Object:
+                {
+                    const ObjectMap& contents = std::get<Type_Object>(*pValue)->GetContents();
+                    _WriteHeader(0x80, 15, 0, 0xde, 0xdf, static_cast<uint32_t>(contents.size()));
+                    stckFrames.emplace_back();
+                    stckFrames.back().pMap = &contents;
+                    stckFrames.back().itMap = contents.begin();
+                    break;
+                }
+
+                default:
+                    m_buffer.push_back(static_cast<char>(0xc0));
+                    break;
+            }
+
+            if (m_buffer.size() >= s_uFlushSize)
+                _Flush();
+        }
+
+        _Flush();
+    }
+}
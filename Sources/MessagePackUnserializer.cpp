@@ -0,0 +1,251 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: MessagePackUnserializer.cpp - MessagePack unserializer class implementation
+// author: Karl-Mihkel Ott
+
+#include <cvar/MessagePackUnserializer.h>
+#include <cvar/SerializerExceptions.h>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+namespace cvar {
+
+    MessagePackUnserializer::MessagePackUnserializer(std::istream& _stream) :
+        IUnserializer<ObjectMap>(_stream)
+    {
+        _Parse();
+    }
+
+
+    uint8_t MessagePackUnserializer::_ReadByte() {
+        // get() returns -1 at the end of stream, which is also a valid byte
+        if (m_stream.eof())
+            throw UnexpectedEOFException("MessagePack data ended unexpectedly");
+        return static_cast<uint8_t>(m_stream.get());
+    }
+
+
+    void MessagePackUnserializer::_Read(void* _pData, size_t _uLen) {
+        if (m_stream.read(static_cast<char*>(_pData), _uLen) != _uLen)
+            throw UnexpectedEOFException("MessagePack data ended unexpectedly");
+    }
+
+
+    uint32_t MessagePackUnserializer::_ReadBE(size_t _uLen) {
+        uint8_t arrBytes[4];
+        _Read(arrBytes, _uLen);
+
+        uint32_t uValue = 0;
+        for (size_t i = 0; i < _uLen; i++)
+            uValue = (uValue << 8) | arrBytes[i];
+        return uValue;
+    }
+
+
+    std::string_view MessagePackUnserializer::_ReadText(uint32_t _uLen) {
+        // lengths come from the input, thus the scratch buffer only grows as far as the data actually goes
+        constexpr size_t uChunkSize = 64 * 1024;
+        m_sScratch.clear();
+        for (size_t uRead = 0; uRead < _uLen;) {
+            const size_t uChunk = std::min(static_cast<size_t>(_uLen) - uRead, uChunkSize);
+            m_sScratch.resize(uRead + uChunk);
+            _Read(m_sScratch.data() + uRead, uChunk);
+            uRead += uChunk;
+        }
+        return m_sScratch;
+    }
+
+
+    Value MessagePackUnserializer::_ReadScalar(uint8_t _uMarker) {
+        // positive and negative fixint
+        if (_uMarker <= 0x7f || _uMarker >= 0xe0)
+            return static_cast<Int>(static_cast<int8_t>(_uMarker));
+
+        if ((_uMarker & 0xe0) == 0xa0 || _uMarker == 0xd9 || _uMarker == 0xda || _uMarker == 0xdb ||
+            _uMarker == 0xc4 || _uMarker == 0xc5 || _uMarker == 0xc6) {
+            uint32_t uLen = _uMarker & 0x1f;
+            if (_uMarker == 0xd9 || _uMarker == 0xc4)
+                uLen = _ReadBE(1);
+            else if (_uMarker == 0xda || _uMarker == 0xc5)
+                uLen = _ReadBE(2);
+            else if (_uMarker == 0xdb || _uMarker == 0xc6)
+                uLen = _ReadBE(4);
+
+            const std::string_view sText = _ReadText(uLen);
+            return String(sText, RUNTIME_CRC_RANGE(sText.data(), sText.size()));
+        }
+
+        switch (_uMarker) {
+            case 0xc2:
+                return false;
+
+            case 0xc3:
+                return true;
+
+            case 0xca:
+            {
+                const uint32_t uBits = _ReadBE(4);
+                Float fValue;
+                std::memcpy(&fValue, &uBits, sizeof(Float));
+                return fValue;
+            }
+
+            case 0xcb:
+            {
+                const uint64_t uBits = (static_cast<uint64_t>(_ReadBE(4)) << 32) | _ReadBE(4);
+                double dValue;
+                std::memcpy(&dValue, &uBits, sizeof(double));
+                return static_cast<Float>(dValue);
+            }
+
+            case 0xcc:
+                return static_cast<Int>(_ReadBE(1));
+
+            case 0xcd:
+                return static_cast<Int>(_ReadBE(2));
+
+            case 0xce:
+            {
+                const uint32_t uValue = _ReadBE(4);
+                if (uValue > static_cast<uint32_t>(INT32_MAX))
+                    return static_cast<Float>(uValue);
+                return static_cast<Int>(uValue);
+            }
+
+            case 0xcf:
+            {
+                const uint64_t uValue = (static_cast<uint64_t>(_ReadBE(4)) << 32) | _ReadBE(4);
+                if (uValue > static_cast<uint64_t>(INT32_MAX))
+                    return static_cast<Float>(uValue);
+                return static_cast<Int>(uValue);
+            }
+
+            case 0xd0:
+                return static_cast<Int>(static_cast<int8_t>(_ReadBE(1)));
+
+            case 0xd1:
+                return static_cast<Int>(static_cast<int16_t>(_ReadBE(2)));
+
+            case 0xd2:
+                return static_cast<Int>(_ReadBE(4));
+
+            case 0xd3:
+            {
+                const int64_t iValue = static_cast<int64_t>((static_cast<uint64_t>(_ReadBE(4)) << 32) | _ReadBE(4));
+                if (iValue < INT32_MIN || iValue > INT32_MAX)
+                    return static_cast<Float>(iValue);
+                return static_cast<Int>(iValue);
+            }
+
+            default:
+            {
+                std::stringstream ss;
+                ss << "Unsupported MessagePack type 0x" << std::hex << static_cast<uint32_t>(_uMarker);
+                throw SyntaxErrorException(ss.str());
+            }
+        }
+    }
+
+
+    void MessagePackUnserializer::_Parse() {
+        // assume empty file is used
+        if (m_stream.eof())
+            return;
+
+        // containers that are being filled, nested containers are attached to their parent when they are created
+        struct Frame {
+            ObjectMap* pMap = nullptr;
+            List* pList = nullptr;
+            uint32_t uRemaining = 0;
+        };
+
+        // map and array headers, yields false if the marker is not a container
+        auto readContainer = [this](uint8_t _uMarker, bool& _bMap, uint32_t& _uCount) {
+            if ((_uMarker & 0xf0) == 0x80 || (_uMarker & 0xf0) == 0x90) {
+                _bMap = (_uMarker & 0xf0) == 0x80;
+                _uCount = _uMarker & 0x0f;
+                return true;
+            }
+
+            if (_uMarker < 0xdc || _uMarker > 0xdf)
+                return false;
+
+            _bMap = _uMarker >= 0xde;
+            _uCount = _ReadBE(_uMarker == 0xdc || _uMarker == 0xde ? 2 : 4);
+            return true;
+        };
+
+        bool bMap = false;
+        uint32_t uCount = 0;
+        if (!readContainer(_ReadByte(), bMap, uCount) || !bMap)
+            throw SyntaxErrorException("Root must always be an object");
+
+        std::vector<Frame> stckFrames;
+        stckFrames.push_back(Frame{ &m_root, nullptr, uCount });
+
+        while (!stckFrames.empty()) {
+            Frame& top = stckFrames.back();
+            if (!top.uRemaining) {
+                stckFrames.pop_back();
+                continue;
+            }
+            top.uRemaining--;
+
+            ObjectMap* pMap = top.pMap;
+            List* pList = top.pList;
+            std::string_view sKey;
+
+            if (pMap) {
+                const uint8_t uKeyMarker = _ReadByte();
+                uint32_t uLen = 0;
+                if ((uKeyMarker & 0xe0) == 0xa0)
+                    uLen = uKeyMarker & 0x1f;
+                else if (uKeyMarker >= 0xd9 && uKeyMarker <= 0xdb)
+                    uLen = _ReadBE(uKeyMarker == 0xd9 ? 1 : uKeyMarker == 0xda ? 2 : 4);
+                else throw SyntaxErrorException("MessagePack map keys must be strings");
+
+                sKey = _ReadText(uLen);
+            }
+
+            // nil values are not stored, the same way as null in JSON
+            const uint8_t uMarker = _ReadByte();
+            if (uMarker == 0xc0)
+                continue;
+
+            // duplicate keys overwrite the previous value, the key is used before the scratch buffer is reused
+            Value* pSlot = nullptr;
+            if (pMap)
+                pSlot = &(*pMap)[Symbol(sKey, RUNTIME_CRC_RANGE(sKey.data(), sKey.size()))];
+
+            if (readContainer(uMarker, bMap, uCount)) {
+                Frame child;
+                child.uRemaining = uCount;
+
+                if (bMap) {
+                    std::shared_ptr<Object> pObject = std::make_shared<Object>();
+                    child.pMap = &pObject->GetContents();
+                    if (pSlot)
+                        *pSlot = std::move(pObject);
+                    else pList->PushBack(std::move(pObject));
+                }
+                else if (pSlot) {
+                    *pSlot = List();
+                    child.pList = &std::get<List>(*pSlot);
+                }
+                else {
+                    pList->PushBack(List());
+                    child.pList = &std::get<List>(pList->Back());
+                }
+
+                stckFrames.push_back(child);
+                continue;
+            }
+
+            if (pSlot)
+                *pSlot = _ReadScalar(uMarker);
+            else pList->PushBack(_ReadScalar(uMarker));
+        }
+    }
+}
@@ -0,0 +1,201 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: PathIndex.cpp - sorted index of full CVar paths implementation
+// author: Karl-Mihkel Ott
+
+#include <cvar/PathIndex.h>
+#include <cvar/TreeVisitor.h>
+
+namespace cvar {
+
+	static inline bool _StartsWith(std::string_view _sText, std::string_view _sPrefix) {
+		return _sText.size() >= _sPrefix.size() && _sText.compare(0, _sPrefix.size(), _sPrefix) == 0;
+	}
+
+
+	// match a single path segment against a pattern with '*' and '?' wildcards
+	static bool _MatchSegment(std::string_view _sPattern, std::string_view _sText) {
+		size_t p = 0, t = 0;
+		size_t uStar = std::string_view::npos, uMark = 0;
+
+		while (t < _sText.size()) {
+			if (p < _sPattern.size() && (_sPattern[p] == '?' || _sPattern[p] == _sText[t])) {
+				p++;
+				t++;
+			}
+			else if (p < _sPattern.size() && _sPattern[p] == '*') {
+				uStar = p++;
+				uMark = t;
+			}
+			else if (uStar != std::string_view::npos) {
+				// let the last star consume one more character
+				p = uStar + 1;
+				t = ++uMark;
+			}
+			else return false;
+		}
+
+		while (p < _sPattern.size() && _sPattern[p] == '*')
+			p++;
+		return p == _sPattern.size();
+	}
+
+
+	std::set<std::string, std::less<>>::const_iterator PathIndex::_SkipDescendants(std::string_view _sPath, std::string& _sBound) const {
+		// descendants are exactly the paths in range [path + '.', path + '/')
+		_sBound.assign(_sPath);
+		_sBound += '/';
+		return m_paths.lower_bound(_sBound);
+	}
+
+
+	void PathIndex::Clear() {
+		m_paths.clear();
+	}
+
+
+	void PathIndex::Build(const ObjectMap& _root) {
+		m_paths.clear();
+		ForEach(_root, "", [this](std::string_view _sPath, const Value&) {
+			m_paths.emplace(_sPath);
+		});
+	}
+
+
+	void PathIndex::Insert(std::string_view _sPath) {
+		auto it = m_paths.lower_bound(_sPath);
+		if (it == m_paths.end() || *it != _sPath)
+			m_paths.emplace_hint(it, _sPath);
+	}
+
+
+	void PathIndex::EraseDescendants(std::string_view _sPath) {
+		std::string sBound(_sPath);
+		sBound += '.';
+		auto itBegin = m_paths.lower_bound(sBound);
+		if (itBegin == m_paths.end() || !_StartsWith(*itBegin, sBound))
+			return;
+
+		m_paths.erase(itBegin, _SkipDescendants(_sPath, sBound));
+	}
+
+
+	void PathIndex::InsertDescendants(std::string_view _sPath, const ObjectMap& _contents) {
+		std::string sPath(_sPath);
+		sPath += '.';
+		const size_t uPrefixLength = sPath.size();
+
+		ForEach(_contents, "", [&](std::string_view _sChild, const Value&) {
+			sPath.resize(uPrefixLength);
+			sPath += _sChild;
+			Insert(sPath);
+		});
+	}
+
+
+	std::vector<std::string> PathIndex::FindPrefix(std::string_view _sPrefix, size_t _uMax) const {
+		std::vector<std::string> paths;
+		for (auto it = m_paths.lower_bound(_sPrefix); it != m_paths.end() && paths.size() < _uMax; it++) {
+			if (!_StartsWith(*it, _sPrefix))
+				break;
+			paths.push_back(*it);
+		}
+
+		return paths;
+	}
+
+
+	std::vector<std::string> PathIndex::FindGlob(std::string_view _sPattern, size_t _uMax) const {
+		std::vector<std::string> paths;
+
+		// only paths starting with the text before the first wildcard can match
+		const size_t uWildcard = _sPattern.find_first_of("*?");
+		if (uWildcard == std::string_view::npos) {
+			if (Contains(_sPattern) && _uMax)
+				paths.emplace_back(_sPattern);
+			return paths;
+		}
+		const std::string_view sLiteral = _sPattern.substr(0, uWildcard);
+
+		std::vector<std::string_view> segments;
+		for (size_t uBegin = 0;;) {
+			const size_t uEnd = _sPattern.find('.', uBegin);
+			segments.push_back(_sPattern.substr(uBegin, uEnd == std::string_view::npos ? std::string_view::npos : uEnd - uBegin));
+			if (uEnd == std::string_view::npos)
+				break;
+			uBegin = uEnd + 1;
+		}
+		const bool bAnyDepth = segments.back() == "**";
+
+		std::string sBound;
+		auto it = m_paths.lower_bound(sLiteral);
+		while (it != m_paths.end() && paths.size() < _uMax && _StartsWith(*it, sLiteral)) {
+			const std::string_view sPath = *it;
+
+			// length of the shortest prefix of the path that doesn't match, its descendants are skipped
+			size_t uMismatch = std::string_view::npos;
+			bool bMatch = false;
+			size_t uSegment = 0;
+			for (size_t uBegin = 0;;) {
+				size_t uEnd = sPath.find('.', uBegin);
+				if (uEnd == std::string_view::npos)
+					uEnd = sPath.size();
+
+				// path is deeper than the pattern
+				if (uSegment == segments.size()) {
+					uMismatch = uBegin - 1;
+					break;
+				}
+
+				// trailing ** matches the rest of the path
+				if (bAnyDepth && uSegment == segments.size() - 1) {
+					bMatch = true;
+					break;
+				}
+
+				if (!_MatchSegment(segments[uSegment], sPath.substr(uBegin, uEnd - uBegin))) {
+					uMismatch = uEnd;
+					break;
+				}
+
+				uSegment++;
+				if (uEnd == sPath.size()) {
+					bMatch = uSegment == segments.size();
+					break;
+				}
+				uBegin = uEnd + 1;
+			}
+
+			if (bMatch)
+				paths.push_back(*it);
+
+			if (uMismatch < sPath.size())
+				it = _SkipDescendants(sPath.substr(0, uMismatch), sBound);
+			else it++;
+		}
+
+		return paths;
+	}
+
+
+	std::vector<std::string> PathIndex::Complete(std::string_view _sPartial, size_t _uMax) const {
+		std::vector<std::string> paths;
+		const size_t uLastSegment = _sPartial.rfind('.') + 1;
+
+		std::string sBound;
+		auto it = m_paths.lower_bound(_sPartial);
+		while (it != m_paths.end() && paths.size() < _uMax && _StartsWith(*it, _sPartial)) {
+			// parents precede their descendants, thus the candidate itself has already been collected
+			const size_t uEnd = it->find('.', uLastSegment);
+			if (uEnd != std::string::npos) {
+				it = _SkipDescendants(std::string_view(*it).substr(0, uEnd), sBound);
+				continue;
+			}
+
+			paths.push_back(*it);
+			it++;
+		}
+
+		return paths;
+	}
+}
@@ -6,58 +6,219 @@
 #include <cstring>
 #include <cvar/SID.h>
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define CVAR_CRC32C_SSE42
+	#include <nmmintrin.h>
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+	#endif
+#elif defined(__ARM_FEATURE_CRC32)
+	#define CVAR_CRC32C_ARM
+	#include <arm_acle.h>
+#endif
+
 namespace cvar {
-	uint32_t RuntimeCrc32(const std::string& _str) {
-		uint32_t uHash = 0;
-		for (size_t i = 0; i < _str.size(); i++) {
-			uHash = (uHash >> 8) ^ crc32_table[(uHash ^ _str[i]) & 0xff];
+
+	// Slicing-by-8 tables: entry [k][i] is the CRC of byte i followed by k zero bytes, which allows
+	// folding 8 input bytes into the hash with 8 independent table lookups instead of a serial chain
+	template <typename T>
+	struct SlicingTables {
+		T arrEntries[8][256] = {};
+	};
+
+	template <typename T>
+	static constexpr SlicingTables<T> _MakeSlicingTables(const T* _pBase) {
+		SlicingTables<T> tables;
+		for (size_t i = 0; i < 256; i++)
+			tables.arrEntries[0][i] = _pBase[i];
+
+		for (size_t k = 1; k < 8; k++) {
+			for (size_t i = 0; i < 256; i++) {
+				T prev = tables.arrEntries[k - 1][i];
+				tables.arrEntries[k][i] = (prev >> 8) ^ _pBase[prev & 0xff];
+			}
 		}
+		return tables;
+	}
+
+	static constexpr SlicingTables<uint32_t> s_crc32Tables = _MakeSlicingTables<uint32_t>(crc32_table);
+	static constexpr SlicingTables<uint64_t> s_crc64Tables = _MakeSlicingTables<uint64_t>(crc64_table);
+	static constexpr SlicingTables<uint32_t> s_crc32cTables = _MakeSlicingTables<uint32_t>(crc32c_table.arrEntries);
 
-		return uHash ^ 0xffffffff;
+	// byte order independent little endian loads, compilers reduce these to a single mov on little endian targets
+	static inline uint32_t _LoadLE32(const char* _pData) {
+		const unsigned char* p = reinterpret_cast<const unsigned char*>(_pData);
+		return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+			(static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
 	}
 
-    uint32_t RuntimeCrc32(const char* _szData) {
-        uint32_t uHash = 0;
-        for (size_t i = 0; i < std::strlen(_szData); i++) {
-            uHash = (uHash >> 8) ^ crc32_table[(uHash ^ _szData[i]) & 0xff];
-        }
+	static inline uint64_t _LoadLE64(const char* _pData) {
+		return static_cast<uint64_t>(_LoadLE32(_pData)) | (static_cast<uint64_t>(_LoadLE32(_pData + 4)) << 32);
+	}
 
-        return uHash ^ 0xffffffff;
-    }
+	// reflected 32 bit CRC update without initial and final inversion
+	static uint32_t _Slice32(const SlicingTables<uint32_t>& _tables, uint32_t _uHash, const char* _szData, size_t _uLen) {
+		const auto& t = _tables.arrEntries;
+		while (_uLen >= 8) {
+			uint32_t uLow = _LoadLE32(_szData) ^ _uHash;
+			uint32_t uHigh = _LoadLE32(_szData + 4);
+			_uHash = t[7][uLow & 0xff] ^ t[6][(uLow >> 8) & 0xff] ^ t[5][(uLow >> 16) & 0xff] ^ t[4][uLow >> 24] ^
+				t[3][uHigh & 0xff] ^ t[2][(uHigh >> 8) & 0xff] ^ t[1][(uHigh >> 16) & 0xff] ^ t[0][uHigh >> 24];
+			_szData += 8;
+			_uLen -= 8;
+		}
 
-	uint32_t RuntimeCrc32(const char* _szData, size_t _uLen) {
-		uint32_t uHash = 0;
-		for (size_t i = 0; i < _uLen; i++) {
-			uHash = (uHash >> 8) ^ crc32_table[(uHash ^ _szData[i]) & 0xff];
+		for (size_t i = 0; i < _uLen; i++)
+			_uHash = (_uHash >> 8) ^ t[0][(_uHash ^ _szData[i]) & 0xff];
+		return _uHash;
+	}
+
+	static uint64_t _Slice64(const SlicingTables<uint64_t>& _tables, uint64_t _uHash, const char* _szData, size_t _uLen) {
+		const auto& t = _tables.arrEntries;
+		while (_uLen >= 8) {
+			uint64_t uWord = _LoadLE64(_szData) ^ _uHash;
+			_uHash = t[7][uWord & 0xff] ^ t[6][(uWord >> 8) & 0xff] ^ t[5][(uWord >> 16) & 0xff] ^
+				t[4][(uWord >> 24) & 0xff] ^ t[3][(uWord >> 32) & 0xff] ^ t[2][(uWord >> 40) & 0xff] ^
+				t[1][(uWord >> 48) & 0xff] ^ t[0][uWord >> 56];
+			_szData += 8;
+			_uLen -= 8;
 		}
 
-		return uHash ^ 0xffffffff;
+		for (size_t i = 0; i < _uLen; i++)
+			_uHash = (_uHash >> 8) ^ t[0][(_uHash ^ _szData[i]) & 0xff];
+		return _uHash;
+	}
+
+	uint32_t RuntimeCrc32(const std::string& _str) {
+		return _Slice32(s_crc32Tables, 0, _str.data(), _str.size()) ^ 0xffffffff;
+	}
+
+	uint32_t RuntimeCrc32(const char* _szData) {
+		return _Slice32(s_crc32Tables, 0, _szData, std::strlen(_szData)) ^ 0xffffffff;
+	}
+
+	uint32_t RuntimeCrc32(const char* _szData, size_t _uLen) {
+		return _Slice32(s_crc32Tables, 0, _szData, _uLen) ^ 0xffffffff;
+	}
+
+	uint32_t RuntimeCrc32(uint32_t _uHash, const char* _szData, size_t _uLen) {
+		return _Slice32(s_crc32Tables, _uHash ^ 0xffffffff, _szData, _uLen) ^ 0xffffffff;
 	}
 
 	uint64_t RuntimeCrc64(const std::string& _str) {
-		uint64_t uHash = 0;
-		for (size_t i = 0; i < _str.size(); i++) {
-			uHash = (uHash >> 8) ^ crc64_table[(uHash ^ _str[i]) & 0xff];
-		}
+		return _Slice64(s_crc64Tables, 0, _str.data(), _str.size()) ^ 0xffffffffffffffff;
+	}
 
-		return uHash ^ 0xffffffffffffffff;
+	uint64_t RuntimeCrc64(const char* _szData) {
+		return _Slice64(s_crc64Tables, 0, _szData, std::strlen(_szData)) ^ 0xffffffffffffffff;
 	}
 
-    uint64_t RuntimeCrc64(const char* _szData) {
-        uint64_t uHash = 0;
-        for (size_t i = 0; i < std::strlen(_szData); i++) {
-            uHash = (uHash >> 8) ^ crc64_table[(uHash ^ _szData[i]) & 0xff];
-        }
+	uint64_t RuntimeCrc64(const char* _szData, size_t _uLen) {
+		return _Slice64(s_crc64Tables, 0, _szData, _uLen) ^ 0xffffffffffffffff;
+	}
 
-        return uHash ^ 0xffffffffffffffff;
-    }
+	uint64_t RuntimeCrc64(uint64_t _uHash, const char* _szData, size_t _uLen) {
+		return _Slice64(s_crc64Tables, _uHash ^ 0xffffffffffffffff, _szData, _uLen) ^ 0xffffffffffffffff;
+	}
 
-	uint64_t RuntimeCrc64(const char* _szData, size_t _ulen) {
-		uint64_t uHash = 0;
-		for (size_t i = 0; i < _ulen; i++) {
-			uHash = (uHash >> 8) ^ crc64_table[(uHash ^ _szData[i]) & 0xff];
+#if defined(CVAR_CRC32C_SSE42)
+	#if defined(_MSC_VER)
+		#define CVAR_TARGET_SSE42
+	#else
+		#define CVAR_TARGET_SSE42 __attribute__((target("sse4.2")))
+	#endif
+
+	CVAR_TARGET_SSE42 static uint32_t _Crc32cHardware(uint32_t _uHash, const char* _szData, size_t _uLen) {
+	#if defined(__x86_64__) || defined(_M_X64)
+		uint64_t uHash = _uHash;
+		while (_uLen >= 8) {
+			uint64_t uWord;
+			std::memcpy(&uWord, _szData, sizeof(uWord));
+			uHash = _mm_crc32_u64(uHash, uWord);
+			_szData += 8;
+			_uLen -= 8;
+		}
+		_uHash = static_cast<uint32_t>(uHash);
+	#else
+		while (_uLen >= 4) {
+			uint32_t uWord;
+			std::memcpy(&uWord, _szData, sizeof(uWord));
+			_uHash = _mm_crc32_u32(_uHash, uWord);
+			_szData += 4;
+			_uLen -= 4;
 		}
+	#endif
+		for (size_t i = 0; i < _uLen; i++)
+			_uHash = _mm_crc32_u8(_uHash, static_cast<unsigned char>(_szData[i]));
+		return _uHash;
+	}
+
+	static bool _DetectHardwareCrc32c() {
+	#if defined(_MSC_VER)
+		int arrInfo[4] = {};
+		__cpuid(arrInfo, 1);
+		return (arrInfo[2] & (1 << 20)) != 0;
+	#else
+		return __builtin_cpu_supports("sse4.2");
+	#endif
+	}
+#elif defined(CVAR_CRC32C_ARM)
+	static uint32_t _Crc32cHardware(uint32_t _uHash, const char* _szData, size_t _uLen) {
+		while (_uLen >= 8) {
+			uint64_t uWord;
+			std::memcpy(&uWord, _szData, sizeof(uWord));
+			_uHash = __crc32cd(_uHash, uWord);
+			_szData += 8;
+			_uLen -= 8;
+		}
+
+		for (size_t i = 0; i < _uLen; i++)
+			_uHash = __crc32cb(_uHash, static_cast<uint8_t>(_szData[i]));
+		return _uHash;
+	}
+
+	static bool _DetectHardwareCrc32c() {
+		return true;
+	}
+#endif
+
+	static uint32_t _Crc32cSoftware(uint32_t _uHash, const char* _szData, size_t _uLen) {
+		return _Slice32(s_crc32cTables, _uHash, _szData, _uLen);
+	}
+
+	typedef uint32_t(*PFN_Crc32c)(uint32_t, const char*, size_t);
+
+	// resolved on first use, since hashes might be requested during static initialization of other translation units
+	static PFN_Crc32c _GetCrc32c() {
+	#if defined(CVAR_CRC32C_SSE42) || defined(CVAR_CRC32C_ARM)
+		static const PFN_Crc32c pfnCrc32c = _DetectHardwareCrc32c() ? _Crc32cHardware : _Crc32cSoftware;
+		return pfnCrc32c;
+	#else
+		return _Crc32cSoftware;
+	#endif
+	}
+
+	bool HasHardwareCrc32c() {
+		return _GetCrc32c() != _Crc32cSoftware;
+	}
+
+	uint32_t RuntimeCrc32c(const std::string& _str) {
+		return _GetCrc32c()(0xffffffff, _str.data(), _str.size()) ^ 0xffffffff;
+	}
+
+	uint32_t RuntimeCrc32c(const char* _szData) {
+		return _GetCrc32c()(0xffffffff, _szData, std::strlen(_szData)) ^ 0xffffffff;
+	}
+
+	uint32_t RuntimeCrc32c(const char* _szData, size_t _uLen) {
+		return _GetCrc32c()(0xffffffff, _szData, _uLen) ^ 0xffffffff;
+	}
+
+	uint32_t RuntimeCrc32c(uint32_t _uHash, const char* _szData, size_t _uLen) {
+		return _GetCrc32c()(_uHash ^ 0xffffffff, _szData, _uLen) ^ 0xffffffff;
+	}
 
-		return uHash ^ 0xffffffffffffffff;
+	uint32_t RuntimeCrc32cSoftware(const char* _szData, size_t _uLen) {
+		return _Crc32cSoftware(0xffffffff, _szData, _uLen) ^ 0xffffffff;
 	}
 }
@@ -0,0 +1,77 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: SerializationCache.cpp - cached serialized text of CVar objects implementation
+// author: Karl-Mihkel Ott
+
+#include <cvar/SerializationCache.h>
+
+namespace cvar {
+
+	void SerializationCache::SetFormat(std::string_view _sFormat) {
+		if (m_sFormat == _sFormat)
+			return;
+
+		Clear();
+		m_sFormat = _sFormat;
+	}
+
+
+	void SerializationCache::Clear() {
+		m_entries.clear();
+		m_dirty.clear();
+		m_sFormat.clear();
+	}
+
+
+	void SerializationCache::MarkDirty(std::string_view _sKey) {
+		m_dirty.emplace();
+
+		// every dotted prefix of the key is the path of an object containing it
+		for (size_t uPos = _sKey.find('.'); uPos != std::string_view::npos; uPos = _sKey.find('.', uPos + 1))
+			m_dirty.emplace(_sKey.substr(0, uPos));
+		m_dirty.emplace(_sKey);
+	}
+
+
+	void SerializationCache::Write(std::ostream& _stream) {
+		m_uSave++;
+
+		// pair specification:
+		// first - fragments of an object
+		// second - index of the next fragment
+		std::vector<std::pair<const std::vector<Fragment>*, size_t>> stckFragments;
+		auto itRoot = m_entries.find(std::string());
+		if (itRoot == m_entries.end())
+			return;
+
+		itRoot->second.uSave = m_uSave;
+		stckFragments.push_back(std::make_pair(&itRoot->second.fragments, 0));
+
+		while (!stckFragments.empty()) {
+			auto& top = stckFragments.back();
+			if (top.second == top.first->size()) {
+				stckFragments.pop_back();
+				continue;
+			}
+
+			const Fragment& fragment = (*top.first)[top.second++];
+			_stream.write(fragment.sText.data(), static_cast<std::streamsize>(fragment.sText.size()));
+			if (!fragment.bChild)
+				continue;
+
+			auto itChild = m_entries.find(fragment.sChild);
+			if (itChild != m_entries.end()) {
+				itChild->second.uSave = m_uSave;
+				stckFragments.push_back(std::make_pair(&itChild->second.fragments, 0));
+			}
+		}
+
+		// every object in the tree is up to date now, objects that were not reached have been removed or replaced
+		m_dirty.clear();
+		for (auto it = m_entries.begin(); it != m_entries.end();) {
+			if (it->second.uSave != m_uSave)
+				it = m_entries.erase(it);
+			else it++;
+		}
+	}
+}
@@ -0,0 +1,26 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: StaticCVar.cpp - statically declared typed CVar storage implementation
+// author: Karl-Mihkel Ott
+
+#include <cvar/CVarSystem.h>
+
+namespace cvar {
+
+	StaticCVarBase::~StaticCVarBase() {
+		if (m_bRegistered)
+			CVarSystem::GetInstance()._UnregisterStatic(this);
+	}
+
+
+	void StaticCVarBase::_Register() {
+		m_bRegistered = CVarSystem::GetInstance()._RegisterStatic(this);
+	}
+
+
+	bool StaticCVarBase::_WriteThrough(Value&& _val) {
+		if (!m_bRegistered)
+			return false;
+		return CVarSystem::GetInstance()._WriteStatic(this, std::move(_val));
+	}
+}
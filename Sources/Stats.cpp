@@ -0,0 +1,268 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: Stats.cpp - CVar tree memory accounting and statistics implementation
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_set>
+#include <cvar/Stats.h>
+
+namespace cvar {
+
+	// objects are created with std::make_shared, which allocates the control block together with the object
+	static constexpr size_t s_uObjectOverhead = sizeof(Object) + 2 * sizeof(void*);
+	static constexpr size_t s_uNoOwner = std::numeric_limits<size_t>::max();
+
+	class StatsCollector {
+		private:
+			struct _Frame {
+				const ObjectMap* pMap;
+				size_t uNext;           // index of the next sampled entry
+				size_t uStride;
+				size_t uDepth;
+				size_t uPathLength;     // path buffer length to restore once the object is finished
+				size_t uOwner;          // index of the frame whose entry holds this object, s_uNoOwner for the prefix
+				bool bNamed;            // objects stored in lists have no path of their own
+				double fWeight;         // number of entries each sampled entry of this object stands for
+				double fScale;          // number of objects this object stands for in the whole tree
+				double fBytes = 0.0;    // estimated size of the subtree
+				double fNodes = 0.0;
+			};
+
+			const StatsOptions& m_options;
+			std::vector<_Frame> m_stckFrames;
+			std::vector<const List*> m_stckLists;
+			std::string m_sPath;
+			// interned key texts that were already accounted
+			std::unordered_set<const std::string*> m_keys;
+
+			double m_arrNodeCounts[Type_Object + 1] = {};
+			double m_fKeyBytes = 0.0;
+			double m_fStringBytes = 0.0;
+			double m_fListBytes = 0.0;
+			double m_fMapBytes = 0.0;
+			size_t m_uMaxDepth = 0;
+			// min-heap of the largest subtrees found so far
+			std::vector<SubtreeStats> m_largest;
+
+		private:
+			static inline size_t _Round(double _fValue) {
+				return static_cast<size_t>(std::llround(_fValue));
+			}
+
+			static inline bool _IsLarger(const SubtreeStats& _first, const SubtreeStats& _second) {
+				return _first.uBytes > _second.uBytes;
+			}
+
+			void _PushMap(const ObjectMap& _map, size_t _uDepth, double _fScale, bool _bNamed, size_t _uPathLength, size_t _uOwner) {
+				_Frame frame;
+				frame.pMap = &_map;
+				frame.uNext = 0;
+				frame.uStride = std::max<size_t>(m_options.uSampleInterval, 1);
+				frame.uDepth = _uDepth;
+				frame.uPathLength = _uPathLength;
+				frame.uOwner = _uOwner;
+				frame.bNamed = _bNamed;
+				frame.fScale = _fScale;
+
+				// sample entries whose index plus seed is divisible by the interval, objects smaller than the
+				// interval get one entry sampled
+				const size_t uSize = _map.size();
+				size_t uSampled = uSize;
+				if (frame.uStride > 1 && uSize) {
+					frame.uNext = (frame.uStride - m_options.uSampleSeed % frame.uStride) % frame.uStride;
+					if (frame.uNext >= uSize) {
+						frame.uNext = m_options.uSampleSeed % uSize;
+						uSampled = 1;
+					}
+					else {
+						uSampled = (uSize - 1 - frame.uNext) / frame.uStride + 1;
+					}
+				}
+				frame.fWeight = uSampled ? static_cast<double>(uSize) / static_cast<double>(uSampled) : 1.0;
+
+				const double fOwnBytes = static_cast<double>(_map.allocated_bytes() + s_uObjectOverhead);
+				frame.fBytes = fOwnBytes;
+				m_fMapBytes += fOwnBytes * _fScale;
+				m_stckFrames.push_back(frame);
+			}
+
+			// account list storage and the memory owned by its elements, objects found in lists are pushed as
+			// children of _uOwner, i.e. the frame that holds the list
+			double _AccountList(const List& _list, double _fScale, size_t _uDepth, size_t _uOwner) {
+				double fBytes = 0.0;
+				m_stckLists.push_back(&_list);
+				while (!m_stckLists.empty()) {
+					const List* pList = m_stckLists.back();
+					m_stckLists.pop_back();
+
+					const double fListBytes = static_cast<double>(pList->GetAllocatedBytes());
+					m_fListBytes += fListBytes * _fScale;
+					fBytes += fListBytes;
+
+					// packed elements don't own any memory
+					if (pList->IsPacked())
+						continue;
+
+					for (ListIterator it = pList->Begin(); it != pList->End(); ++it) {
+						if (const String* pString = std::get_if<String>(&*it)) {
+							const double fStringBytes = static_cast<double>(pString->GetAllocatedBytes());
+							m_fStringBytes += fStringBytes * _fScale;
+							fBytes += fStringBytes;
+						}
+						else if (const List* pNested = std::get_if<List>(&*it)) {
+							m_stckLists.push_back(pNested);
+						}
+						else if (const auto* pObject = std::get_if<std::shared_ptr<Object>>(&*it)) {
+							_PushMap(pObject->get()->GetContents(), _uDepth, _fScale, false, m_sPath.size(), _uOwner);
+						}
+					}
+				}
+				return fBytes;
+			}
+
+			// account a sampled entry of the top frame, objects are pushed to be walked next
+			void _AccountEntry(const ObjectMap::value_type& _entry) {
+				// frame is copied, since pushing children may reallocate the stack
+				const size_t uTop = m_stckFrames.size() - 1;
+				const _Frame frame = m_stckFrames[uTop];
+				const double fScale = frame.fScale * frame.fWeight;
+				const size_t uDepth = frame.uDepth + 1;
+				m_uMaxDepth = std::max(m_uMaxDepth, uDepth);
+
+				const Value& val = _entry.second;
+				m_arrNodeCounts[val.index()] += fScale;
+				m_stckFrames[uTop].fNodes += frame.fWeight;
+
+				// keys are interned, thus each distinct key text is stored and accounted only once
+				double fKeyBytes = 0.0;
+				if (m_keys.insert(&_entry.first.GetSTDString()).second)
+					fKeyBytes = static_cast<double>(_entry.first.GetSTDString().size());
+				m_fKeyBytes += fKeyBytes;
+				double fBytes = 0.0;
+
+				if (const String* pString = std::get_if<String>(&val)) {
+					const double fStringBytes = static_cast<double>(pString->GetAllocatedBytes());
+					m_fStringBytes += fStringBytes * fScale;
+					fBytes += fStringBytes;
+				}
+				else if (const List* pList = std::get_if<List>(&val)) {
+					fBytes += _AccountList(*pList, fScale, uDepth, uTop);
+				}
+				else if (const auto* pObject = std::get_if<std::shared_ptr<Object>>(&val)) {
+					const size_t uPathLength = m_sPath.size();
+					if (frame.bNamed) {
+						if (!m_sPath.empty())
+							m_sPath += '.';
+						m_sPath += _entry.first.GetSTDString();
+					}
+					_PushMap(pObject->get()->GetContents(), uDepth, fScale, frame.bNamed, uPathLength, uTop);
+				}
+
+				m_stckFrames[uTop].fBytes += fBytes * frame.fWeight + fKeyBytes;
+			}
+
+			void _FinishFrame() {
+				const _Frame frame = m_stckFrames.back();
+				m_stckFrames.pop_back();
+
+				// objects stored in lists of the same entry are siblings, thus the owner isn't necessarily the frame
+				// below this one
+				if (frame.uOwner != s_uNoOwner) {
+					_Frame& parent = m_stckFrames[frame.uOwner];
+					parent.fBytes += frame.fBytes * parent.fWeight;
+					parent.fNodes += frame.fNodes * parent.fWeight;
+
+					if (frame.bNamed && m_options.uLargestCount) {
+						SubtreeStats subtree;
+						subtree.uBytes = _Round(frame.fBytes);
+						subtree.uNodes = _Round(frame.fNodes);
+						if (m_largest.size() < m_options.uLargestCount) {
+							subtree.sPath = m_sPath;
+							m_largest.push_back(std::move(subtree));
+							std::push_heap(m_largest.begin(), m_largest.end(), _IsLarger);
+						}
+						else if (subtree.uBytes > m_largest.front().uBytes) {
+							std::pop_heap(m_largest.begin(), m_largest.end(), _IsLarger);
+							subtree.sPath = m_sPath;
+							m_largest.back() = std::move(subtree);
+							std::push_heap(m_largest.begin(), m_largest.end(), _IsLarger);
+						}
+					}
+				}
+
+				m_sPath.resize(frame.uPathLength);
+			}
+
+			void _Drain() {
+				while (!m_stckFrames.empty()) {
+					_Frame& top = m_stckFrames.back();
+					if (top.uNext >= top.pMap->size()) {
+						_FinishFrame();
+						continue;
+					}
+
+					const ObjectMap::value_type& entry = *ObjectMap::const_iterator(top.pMap, top.uNext);
+					top.uNext += top.uStride;
+					_AccountEntry(entry);
+				}
+			}
+
+		public:
+			StatsCollector(const StatsOptions& _options, const std::string& _sPrefix) :
+				m_options(_options),
+				m_sPath(_sPrefix) {}
+
+			void AccountMap(const ObjectMap& _map) {
+				_PushMap(_map, 0, 1.0, true, m_sPath.size(), s_uNoOwner);
+				_Drain();
+			}
+
+			void AccountValue(const Value& _val) {
+				m_arrNodeCounts[_val.index()] += 1.0;
+				if (const String* pString = std::get_if<String>(&_val)) {
+					m_fStringBytes += static_cast<double>(pString->GetAllocatedBytes());
+				}
+				else if (const List* pList = std::get_if<List>(&_val)) {
+					_AccountList(*pList, 1.0, 0, s_uNoOwner);
+					_Drain();
+				}
+			}
+
+			TreeStats GetStats() {
+				TreeStats stats;
+				for (size_t i = 0; i <= Type_Object; i++)
+					stats.arrNodeCounts[i] = _Round(m_arrNodeCounts[i]);
+				stats.uKeyBytes = _Round(m_fKeyBytes);
+				stats.uStringBytes = _Round(m_fStringBytes);
+				stats.uListBytes = _Round(m_fListBytes);
+				stats.uMapBytes = _Round(m_fMapBytes);
+				stats.uMaxDepth = m_uMaxDepth;
+				stats.bSampled = m_options.uSampleInterval > 1;
+
+				std::sort_heap(m_largest.begin(), m_largest.end(), _IsLarger);
+				stats.largestSubtrees = std::move(m_largest);
+				return stats;
+			}
+	};
+
+
+	TreeStats CollectStats(const ObjectMap& _root, const std::string& _sPrefix, const StatsOptions& _options) {
+		StatsCollector collector(_options, _sPrefix);
+		if (_sPrefix.empty()) {
+			collector.AccountMap(_root);
+			return collector.GetStats();
+		}
+
+		const Value* pNode = FindTreeNode(_root, _sPrefix);
+		if (!pNode)
+			return collector.GetStats();
+
+		if (const auto* pObject = std::get_if<std::shared_ptr<Object>>(pNode))
+			collector.AccountMap(pObject->get()->GetContents());
+		else collector.AccountValue(*pNode);
+		return collector.GetStats();
+	}
+}
@@ -0,0 +1,332 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: YAMLSerializer.cpp - YAML serializer class implementation
+// author: Karl-Mihkel Ott
+
+#include <cvar/YAMLSerializer.h>
+#include <charconv>
+#include <cmath>
+#include <vector>
+
+namespace cvar {
+
+    // encoded output is handed to the stream in blocks of this size
+    static constexpr size_t s_uFlushSize = 64 << 10;
+
+    // plain scalars that would be read back as null, Bool, Int or Float
+    static bool _IsReserved(std::string_view _sText) {
+        static constexpr std::string_view arrWords[] = {
+            "~", "null", "Null", "NULL", "true", "True", "TRUE", "false", "False", "FALSE"
+        };
+
+        for (std::string_view sWord : arrWords) {
+            if (_sText == sWord)
+                return true;
+        }
+
+        // numbers, .inf and .nan
+        const char c = _sText.front();
+        return (c >= '0' && c <= '9') || c == '.' || c == '+';
+    }
+
+
+    static bool _NeedsQuotes(std::string_view _sText) {
+        if (_sText.empty() || _IsReserved(_sText) || _sText.back() == ' ' || _sText.back() == ':')
+            return true;
+
+        // indicators can't start a plain scalar, flow indicators are quoted anywhere so that the string is valid in both styles
+        if (std::string_view("-?:#&*!|>'\"%@` \t").find(_sText.front()) != std::string_view::npos)
+            return true;
+
+        for (size_t i = 0; i < _sText.size(); i++) {
+            const unsigned char c = static_cast<unsigned char>(_sText[i]);
+            if (c < 0x20 || c == 0x7f || c == ',' || c == '[' || c == ']' || c == '{' || c == '}')
+                return true;
+            if ((c == ':' && i + 1 < _sText.size() && _sText[i + 1] == ' ') || (c == '#' && i && _sText[i - 1] == ' '))
+                return true;
+        }
+
+        return false;
+    }
+
+
+    YAMLSerializer::YAMLSerializer(std::ostream& _stream, ObjectMap& _root) :
+        ISerializer(_stream, _root) {}
+
+
+    void YAMLSerializer::_Flush() {
+        m_stream.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+        m_buffer.clear();
+    }
+
+
+    void YAMLSerializer::_WriteString(std::string_view _sText) {
+        if (!_NeedsQuotes(_sText)) {
+            m_buffer.append(_sText.data(), _sText.size());
+            return;
+        }
+
+        static constexpr char szHex[] = "0123456789abcdef";
+        m_buffer.push_back('\"');
+        for (char c : _sText) {
+            switch (c) {
+                case '\"':
+                    m_buffer.append("\\\"");
+                    break;
+
+                case '\\':
+                    m_buffer.append("\\\\");
+                    break;
+
+                case '\n':
+                    m_buffer.append("\\n");
+                    break;
+
+                case '\r':
+                    m_buffer.append("\\r");
+                    break;
+
+                case '\t':
+                    m_buffer.append("\\t");
+                    break;
+
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20 || c == 0x7f) {
+                        m_buffer.append("\\x");
+                        m_buffer.push_back(szHex[(c >> 4) & 0xf]);
+                        m_buffer.push_back(szHex[c & 0xf]);
+                    }
+                    else m_buffer.push_back(c);
+                    break;
+            }
+        }
+        m_buffer.push_back('\"');
+    }
+
+
+    bool YAMLSerializer::_WriteInline(const Value& _val) {
+        char szNumber[32];
+        switch (_val.index()) {
+            case Type_Int:
+            {
+                const auto result = std::to_chars(szNumber, szNumber + sizeof(szNumber), std::get<Type_Int>(_val));
+                m_buffer.append(szNumber, result.ptr);
+                return true;
+            }
+
+            case Type_Float:
+            {
+                const Float fValue = std::get<Type_Float>(_val);
+                if (std::isnan(fValue))
+                    m_buffer.append(".nan");
+                else if (std::isinf(fValue))
+                    m_buffer.append(fValue < 0 ? "-.inf" : ".inf");
+                else {
+                    // shortest representation that reads back as the same value, but never as an integer
+                    const auto result = std::to_chars(szNumber, szNumber + sizeof(szNumber), fValue);
+                    m_buffer.append(szNumber, result.ptr);
+                    if (std::string_view(szNumber, result.ptr - szNumber).find_first_of(".e") == std::string_view::npos)
+                        m_buffer.append(".0");
+                }
+                return true;
+            }
+
+            case Type_Bool:
+                m_buffer.append(std::get<Type_Bool>(_val) ? "true" : "false");
+                return true;
+
+            case Type_String:
+                _WriteString(std::get<Type_String>(_val).GetView());
+                return true;
+
+            case Type_List:
+            {
+                const List& list = std::get<Type_List>(_val);
+                if (!list.IsPacked()) {
+                    for (auto it = list.Begin(); it != list.End(); it++) {
+                        if (it->index() == Type_List || it->index() == Type_Object)
+                            return false;
+                    }
+                }
+
+                m_buffer.push_back('[');
+                for (auto it = list.Begin(); it != list.End(); it++) {
+                    if (it != list.Begin())
+                        m_buffer.append(", ");
+                    _WriteInline(*it);
+                }
+                m_buffer.push_back(']');
+                return true;
+            }
+
+            case Type_Object:
+                if (!std::get<Type_Object>(_val)->GetContents().empty())
+                    return false;
+                m_buffer.append("{}");
+                return true;
+
+            default:
+                m_buffer.append("null");
+                return true;
+        }
+    }
+
+
+    void YAMLSerializer::Serialize(bool _bBeautified) {
+        m_buffer.clear();
+        if (_bBeautified)
+            _SerializeBlock();
+        else _SerializeFlow();
+        _Flush();
+    }
+
+
+    void YAMLSerializer::_SerializeBlock() {
+        // pair specification for lists:
+        // first - iterator to the next item
+        // second - end iterator
+        struct Frame {
+            const ObjectMap* pMap = nullptr;
+            ObjectMap::const_iterator itMap;
+            std::pair<ListIterator, ListIterator> list;
+            size_t uIndent = 0;
+            // first entry continues the line of the sequence item that contains it
+            bool bInline = false;
+        };
+
+        std::vector<Frame> stckFrames;
+        auto PushMap = [&stckFrames](const ObjectMap& _map, size_t _uIndent, bool _bInline) {
+            stckFrames.emplace_back();
+            stckFrames.back().pMap = &_map;
+            stckFrames.back().itMap = _map.begin();
+            stckFrames.back().uIndent = _uIndent;
+            stckFrames.back().bInline = _bInline;
+        };
+        auto PushList = [&stckFrames](const List& _list, size_t _uIndent, bool _bInline) {
+            stckFrames.emplace_back();
+            stckFrames.back().list = std::make_pair(_list.Begin(), _list.End());
+            stckFrames.back().uIndent = _uIndent;
+            stckFrames.back().bInline = _bInline;
+        };
+
+        if (m_root.empty()) {
+            m_buffer.append("{}\n");
+            return;
+        }
+
+        PushMap(m_root, 0, false);
+        while (!stckFrames.empty()) {
+            Frame& top = stckFrames.back();
+            const bool bEnd = top.pMap ? top.itMap == top.pMap->end() : top.list.first == top.list.second;
+            if (bEnd) {
+                stckFrames.pop_back();
+                continue;
+            }
+
+            if (!top.bInline)
+                m_buffer.append(top.uIndent, ' ');
+            top.bInline = false;
+
+            const Value* pValue = nullptr;
+            if (top.pMap) {
+                _WriteString(top.itMap->first.GetSTDString());
+                m_buffer.push_back(':');
+                pValue = &top.itMap->second;
+                top.itMap++;
+
+                // nested blocks start on the next line
+                const size_t uSize = m_buffer.size();
+                m_buffer.push_back(' ');
+                if (!_WriteInline(*pValue)) {
+                    m_buffer.resize(uSize);
+                    m_buffer.push_back('\n');
+                    const size_t uIndent = top.uIndent + 2;
+                    if (pValue->index() == Type_Object)
+                        PushMap(std::get<Type_Object>(*pValue)->GetContents(), uIndent, false);
+                    else PushList(std::get<Type_List>(*pValue), uIndent, false);
+                    continue;
+                }
+            }
+            else {
+                m_buffer.append("- ");
+                pValue = &*top.list.first;
+                top.list.first++;
+
+                // nested blocks start on the line of the item
+                if (!_WriteInline(*pValue)) {
+                    const size_t uIndent = top.uIndent + 2;
+                    if (pValue->index() == Type_Object)
+                        PushMap(std::get<Type_Object>(*pValue)->GetContents(), uIndent, true);
+                    else PushList(std::get<Type_List>(*pValue), uIndent, true);
+                    continue;
+                }
+            }
+
+            m_buffer.push_back('\n');
+            if (m_buffer.size() >= s_uFlushSize)
+                _Flush();
+        }
+    }
+
+
+    void YAMLSerializer::_SerializeFlow() {
+        struct Frame {
+            const ObjectMap* pMap = nullptr;
+            ObjectMap::const_iterator itMap;
+            std::pair<ListIterator, ListIterator> list;
+            bool bFirst = true;
+        };
+
+        std::vector<Frame> stckFrames;
+        stckFrames.emplace_back();
+        stckFrames.back().pMap = &m_root;
+        stckFrames.back().itMap = m_root.begin();
+        m_buffer.push_back('{');
+
+        while (!stckFrames.empty()) {
+            Frame& top = stckFrames.back();
+            const bool bEnd = top.pMap ? top.itMap == top.pMap->end() : top.list.first == top.list.second;
+            if (bEnd) {
+                m_buffer.push_back(top.pMap ? '}' : ']');
+                stckFrames.pop_back();
+                continue;
+            }
+
+            if (!top.bFirst)
+                m_buffer.append(", ");
+            top.bFirst = false;
+
+            const Value* pValue = nullptr;
+            if (top.pMap) {
+                _WriteString(top.itMap->first.GetSTDString());
+                m_buffer.append(": ");
+                pValue = &top.itMap->second;
+                top.itMap++;
+            }
+            else {
+                pValue = &*top.list.first;
+                top.list.first++;
+            }
+
+            if (!_WriteInline(*pValue)) {
+                stckFrames.emplace_back();
+                if (pValue->index() == Type_Object) {
+                    const ObjectMap& contents = std::get<Type_Object>(*pValue)->GetContents();
+                    stckFrames.back().pMap = &contents;
+                    stckFrames.back().itMap = contents.begin();
+                    m_buffer.push_back('{');
+                }
+                else {
+                    const List& list = std::get<Type_List>(*pValue);
+                    stckFrames.back().list = std::make_pair(list.Begin(), list.End());
+                    m_buffer.push_back('[');
+                }
+            }
+
+            if (m_buffer.size() >= s_uFlushSize)
+                _Flush();
+        }
+
+        m_buffer.push_back('\n');
+    }
+}
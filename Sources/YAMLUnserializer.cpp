@@ -0,0 +1,782 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: YAMLUnserializer.cpp - YAML unserializer class implementation
+// author: Karl-Mihkel Ott
+
+#include <cvar/YAMLUnserializer.h>
+#include <cvar/SerializerExceptions.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+namespace cvar {
+
+    static bool _IsDigits(const std::string& _str, size_t _uBegin, size_t _uEnd) {
+        if (_uBegin >= _uEnd)
+            return false;
+
+        for (size_t i = _uBegin; i < _uEnd; i++) {
+            if (_str[i] < '0' || _str[i] > '9')
+                return false;
+        }
+        return true;
+    }
+
+
+    // [-+]? ( \.[0-9]+ | [0-9]+ ( \.[0-9]* )? ) ( [eE] [-+]? [0-9]+ )?
+    static bool _IsFloat(const std::string& _str) {
+        size_t i = (_str[0] == '-' || _str[0] == '+') ? 1 : 0;
+        const size_t uIntegral = i;
+        while (i < _str.size() && _str[i] >= '0' && _str[i] <= '9')
+            i++;
+
+        bool bDigits = i > uIntegral;
+        if (i < _str.size() && _str[i] == '.') {
+            const size_t uFraction = ++i;
+            while (i < _str.size() && _str[i] >= '0' && _str[i] <= '9')
+                i++;
+            bDigits = bDigits || i > uFraction;
+        }
+
+        if (!bDigits)
+            return false;
+
+        if (i < _str.size() && (_str[i] == 'e' || _str[i] == 'E')) {
+            i++;
+            if (i < _str.size() && (_str[i] == '-' || _str[i] == '+'))
+                i++;
+            return _IsDigits(_str, i, _str.size());
+        }
+
+        return i == _str.size();
+    }
+
+
+    // resolve a plain scalar as in the YAML 1.2 core schema
+    static Value _ResolvePlain(const std::string& _str) {
+        if (_str.empty() || _str == "~" || _str == "null" || _str == "Null" || _str == "NULL")
+            return std::monostate();
+        if (_str == "true" || _str == "True" || _str == "TRUE")
+            return true;
+        if (_str == "false" || _str == "False" || _str == "FALSE")
+            return false;
+
+        const char c = _str[0];
+        if ((c < '0' || c > '9') && c != '-' && c != '+' && c != '.')
+            return String(_str);
+
+        // integers that don't fit are stored as Float
+        int iBase = 0;
+        size_t uDigits = (c == '-' || c == '+') ? 1 : 0;
+        if (_IsDigits(_str, uDigits, _str.size()))
+            iBase = 10;
+        else if (_str.size() > 2 && _str[0] == '0' && (_str[1] == 'x' || _str[1] == 'o')) {
+            iBase = _str[1] == 'x' ? 16 : 8;
+            uDigits = 2;
+            const char* szDigits = iBase == 16 ? "0123456789abcdefABCDEF" : "01234567";
+            if (_str.find_first_not_of(szDigits, uDigits) != std::string::npos)
+                iBase = 0;
+        }
+
+        if (iBase) {
+            errno = 0;
+            const long long iValue = std::strtoll(_str.c_str() + (iBase == 10 ? 0 : uDigits), nullptr, iBase);
+            if (errno == ERANGE)
+                return static_cast<Float>(std::strtod(_str.c_str(), nullptr));
+            if (iValue < std::numeric_limits<Int>::min() || iValue > std::numeric_limits<Int>::max())
+                return static_cast<Float>(iValue);
+            return static_cast<Int>(iValue);
+        }
+
+        if (_IsFloat(_str))
+            return static_cast<Float>(std::strtod(_str.c_str(), nullptr));
+
+        const std::string sSpecial = _str.substr(c == '-' || c == '+' ? 1 : 0);
+        if (sSpecial == ".inf" || sSpecial == ".Inf" || sSpecial == ".INF")
+            return c == '-' ? -std::numeric_limits<Float>::infinity() : std::numeric_limits<Float>::infinity();
+        if (_str == ".nan" || _str == ".NaN" || _str == ".NAN")
+            return std::numeric_limits<Float>::quiet_NaN();
+
+        return String(_str);
+    }
+
+
+    // null values are not stored, the same way as in JSON, thus they are removed once their collection is complete
+    static void _DropNulls(ObjectMap* _pMap, List* _pList) {
+        if (_pMap) {
+            for (auto it = _pMap->begin(); it != _pMap->end();) {
+                if (it->second.index() == Type_None)
+                    it = _pMap->erase(it);
+                else it++;
+            }
+            return;
+        }
+
+        // packed lists can't hold nulls
+        if (_pList->IsPacked() || std::none_of(_pList->Begin(), _pList->End(), [](const ListItem& _item) { return _item.index() == Type_None; }))
+            return;
+
+        List list;
+        for (auto it = _pList->Begin(); it != _pList->End(); it++) {
+            if (it->index() != Type_None)
+                list.PushBack(*it);
+        }
+        *_pList = std::move(list);
+    }
+
+
+    static void _AppendUTF8(std::string& _str, uint32_t _uCodePoint) {
+        if (_uCodePoint < 0x80)
+            _str += static_cast<char>(_uCodePoint);
+        else if (_uCodePoint < 0x800) {
+            _str += static_cast<char>(0xc0 | (_uCodePoint >> 6));
+            _str += static_cast<char>(0x80 | (_uCodePoint & 0x3f));
+        }
+        else if (_uCodePoint < 0x10000) {
+            _str += static_cast<char>(0xe0 | (_uCodePoint >> 12));
+            _str += static_cast<char>(0x80 | ((_uCodePoint >> 6) & 0x3f));
+            _str += static_cast<char>(0x80 | (_uCodePoint & 0x3f));
+        }
+        else {
+            _str += static_cast<char>(0xf0 | (_uCodePoint >> 18));
+            _str += static_cast<char>(0x80 | ((_uCodePoint >> 12) & 0x3f));
+            _str += static_cast<char>(0x80 | ((_uCodePoint >> 6) & 0x3f));
+            _str += static_cast<char>(0x80 | (_uCodePoint & 0x3f));
+        }
+    }
+
+
+    YAMLUnserializer::YAMLUnserializer(std::istream& _stream) :
+        IPlainTextUnserializer<ObjectMap>(_stream)
+    {
+        _Parse();
+    }
+
+
+    void YAMLUnserializer::_Error(const std::string& _sWhat) const {
+        std::stringstream ss;
+        ss << _sWhat << " at line " << m_uLineCounter;
+        throw SyntaxErrorException(ss.str());
+    }
+
+
+    bool YAMLUnserializer::_ReadLine() {
+        if (m_bUnread) {
+            m_bUnread = false;
+            m_uPos = 0;
+            return true;
+        }
+
+        if (m_bDocumentEnd || m_stream.eof())
+            return false;
+
+        m_sLine.clear();
+        while (!m_stream.eof()) {
+            const char c = m_stream.get();
+            if (c == '\n')
+                break;
+            m_sLine += c;
+        }
+
+        if (!m_sLine.empty() && m_sLine.back() == '\r')
+            m_sLine.pop_back();
+
+        m_uLineCounter++;
+        m_uPos = 0;
+        return true;
+    }
+
+
+    bool YAMLUnserializer::_NextContentLine() {
+        while (_ReadLine()) {
+            // document markers, only the first document is read
+            const bool bMarker = m_sLine.size() >= 3 && (m_sLine.size() == 3 || m_sLine[3] == ' ');
+            if (bMarker && m_sLine.compare(0, 3, "...") == 0) {
+                m_bDocumentEnd = true;
+                return false;
+            }
+            else if (bMarker && m_sLine.compare(0, 3, "---") == 0) {
+                if (m_bContent) {
+                    m_bDocumentEnd = true;
+                    return false;
+                }
+                m_uPos = 3;
+                if (_AtLineEnd())
+                    continue;
+                _Error("Content after a document marker is not supported");
+            }
+            else if (!m_bContent && !m_sLine.empty() && m_sLine[0] == '%') {
+                // directives
+                continue;
+            }
+
+            while (m_uPos < m_sLine.size() && m_sLine[m_uPos] == ' ')
+                m_uPos++;
+
+            const size_t uIndent = m_uPos;
+            if (_AtLineEnd())
+                continue;
+
+            if (m_uPos != uIndent)
+                _Error("Tabs can't be used for indentation");
+
+            m_bContent = true;
+            return true;
+        }
+
+        return false;
+    }
+
+
+    void YAMLUnserializer::_SkipSpaces() {
+        while (m_uPos < m_sLine.size() && (m_sLine[m_uPos] == ' ' || m_sLine[m_uPos] == '\t'))
+            m_uPos++;
+    }
+
+
+    bool YAMLUnserializer::_AtLineEnd() {
+        _SkipSpaces();
+        return m_uPos >= m_sLine.size() || m_sLine[m_uPos] == '#';
+    }
+
+
+    bool YAMLUnserializer::_IsSequenceItem() const {
+        return m_uPos < m_sLine.size() && m_sLine[m_uPos] == '-' &&
+               (m_uPos + 1 == m_sLine.size() || m_sLine[m_uPos + 1] == ' ' || m_sLine[m_uPos + 1] == '\t');
+    }
+
+
+    bool YAMLUnserializer::_IsMappingEntry() const {
+        size_t i = m_uPos;
+        const char cFirst = m_sLine[i];
+        if (cFirst == '[' || cFirst == '{' || cFirst == '#')
+            return false;
+
+        // quoted key, closing quote must be on the same line
+        if (cFirst == '"' || cFirst == '\'') {
+            for (i++; i < m_sLine.size(); i++) {
+                if (cFirst == '"' && m_sLine[i] == '\\')
+                    i++;
+                else if (m_sLine[i] == cFirst) {
+                    if (cFirst == '\'' && i + 1 < m_sLine.size() && m_sLine[i + 1] == '\'')
+                        i++;
+                    else break;
+                }
+            }
+
+            for (i++; i < m_sLine.size() && (m_sLine[i] == ' ' || m_sLine[i] == '\t'); i++) {}
+            return i < m_sLine.size() && m_sLine[i] == ':' &&
+                   (i + 1 == m_sLine.size() || m_sLine[i + 1] == ' ' || m_sLine[i + 1] == '\t');
+        }
+
+        for (; i < m_sLine.size(); i++) {
+            if (m_sLine[i] == ':' && (i + 1 == m_sLine.size() || m_sLine[i + 1] == ' ' || m_sLine[i + 1] == '\t'))
+                return true;
+            if (m_sLine[i] == '#' && (m_sLine[i - 1] == ' ' || m_sLine[i - 1] == '\t'))
+                return false;
+        }
+
+        return false;
+    }
+
+
+    std::string YAMLUnserializer::_ParseQuoted() {
+        const char cQuot = m_sLine[m_uPos++];
+        std::string sText;
+
+        while (true) {
+            // quoted scalars may span lines, line breaks are folded into spaces and empty lines into newlines
+            if (m_uPos >= m_sLine.size()) {
+                while (!sText.empty() && (sText.back() == ' ' || sText.back() == '\t'))
+                    sText.pop_back();
+
+                bool bEmptyLines = false;
+                do {
+                    if (!_ReadLine())
+                        throw UnexpectedEOFException("Quoted scalar is not closed before the end of document");
+                    _SkipSpaces();
+                    if (m_uPos >= m_sLine.size()) {
+                        sText += '\n';
+                        bEmptyLines = true;
+                    }
+                } while (m_uPos >= m_sLine.size());
+
+                if (!bEmptyLines)
+                    sText += ' ';
+                continue;
+            }
+
+            const char c = m_sLine[m_uPos++];
+            if (c == cQuot) {
+                // '' is an escaped quote in single quoted scalars
+                if (cQuot == '\'' && m_uPos < m_sLine.size() && m_sLine[m_uPos] == '\'') {
+                    sText += '\'';
+                    m_uPos++;
+                    continue;
+                }
+                return sText;
+            }
+
+            if (c != '\\' || cQuot == '\'') {
+                sText += c;
+                continue;
+            }
+
+            if (m_uPos >= m_sLine.size()) {
+                // escaped line break joins the lines without a space
+                if (!_ReadLine())
+                    throw UnexpectedEOFException("Quoted scalar is not closed before the end of document");
+                _SkipSpaces();
+                continue;
+            }
+
+            const char cEscape = m_sLine[m_uPos++];
+            size_t uHexDigits = 0;
+            switch (cEscape) {
+                case '0': sText += '\0'; break;
+                case 'a': sText += '\a'; break;
+                case 'b': sText += '\b'; break;
+                case 't': case '\t': sText += '\t'; break;
+                case 'n': sText += '\n'; break;
+                case 'v': sText += '\v'; break;
+                case 'f': sText += '\f'; break;
+                case 'r': sText += '\r'; break;
+                case 'e': sText += '\x1b'; break;
+                case ' ': case '"': case '/': case '\\': sText += cEscape; break;
+                case 'N': _AppendUTF8(sText, 0x85); break;
+                case '_': _AppendUTF8(sText, 0xa0); break;
+                case 'L': _AppendUTF8(sText, 0x2028); break;
+                case 'P': _AppendUTF8(sText, 0x2029); break;
+                case 'x': uHexDigits = 2; break;
+                case 'u': uHexDigits = 4; break;
+                case 'U': uHexDigits = 8; break;
+
+                default:
+                {
+                    std::stringstream ss;
+                    ss << "Unknown escape sequence '\\" << cEscape << "'";
+                    _Error(ss.str());
+                }
+            }
+
+            if (uHexDigits) {
+                if (m_uPos + uHexDigits > m_sLine.size() ||
+                    m_sLine.find_first_not_of("0123456789abcdefABCDEF", m_uPos) < m_uPos + uHexDigits)
+                {
+                    _Error("Invalid hexadecimal escape sequence");
+                }
+
+                _AppendUTF8(sText, static_cast<uint32_t>(std::stoul(m_sLine.substr(m_uPos, uHexDigits), nullptr, 16)));
+                m_uPos += uHexDigits;
+            }
+        }
+    }
+
+
+    std::string YAMLUnserializer::_ParsePlain(bool _bFlow) {
+        const size_t uBegin = m_uPos;
+        for (; m_uPos < m_sLine.size(); m_uPos++) {
+            const char c = m_sLine[m_uPos];
+            if (c == '#' && m_uPos > uBegin && (m_sLine[m_uPos - 1] == ' ' || m_sLine[m_uPos - 1] == '\t'))
+                break;
+
+            if (c == ':') {
+                const char cNext = m_uPos + 1 < m_sLine.size() ? m_sLine[m_uPos + 1] : ' ';
+                if (cNext == ' ' || cNext == '\t' || (_bFlow && (cNext == ',' || cNext == ']' || cNext == '}')))
+                    break;
+            }
+
+            if (_bFlow && (c == ',' || c == '[' || c == ']' || c == '{' || c == '}'))
+                break;
+        }
+
+        size_t uEnd = m_uPos;
+        while (uEnd > uBegin && (m_sLine[uEnd - 1] == ' ' || m_sLine[uEnd - 1] == '\t'))
+            uEnd--;
+        return m_sLine.substr(uBegin, uEnd - uBegin);
+    }
+
+
+    Symbol YAMLUnserializer::_ParseKey(bool _bFlow) {
+        std::string sKey;
+        if (m_sLine[m_uPos] == '"' || m_sLine[m_uPos] == '\'')
+            sKey = _ParseQuoted();
+        else if (m_sLine[m_uPos] == '?')
+            _Error("Complex mapping keys are not supported");
+        else {
+            sKey = _ParsePlain(_bFlow);
+            if (sKey.empty())
+                _Error("Expected a mapping key");
+        }
+
+        _SkipSpaces();
+        if (m_uPos >= m_sLine.size() || m_sLine[m_uPos] != ':') {
+            // flow mappings allow keys without values
+            if (!_bFlow || m_uPos >= m_sLine.size() || (m_sLine[m_uPos] != ',' && m_sLine[m_uPos] != '}'))
+                _Error("Expected a colon separator (':') after mapping key '" + sKey + "'");
+            return Symbol(sKey);
+        }
+
+        m_uPos++;
+        return Symbol(sKey);
+    }
+
+
+    std::string YAMLUnserializer::_ParseBlockScalar(int32_t _iParentIndent) {
+        const bool bFolded = m_sLine[m_uPos++] == '>';
+
+        // chomping and indentation indicators in any order
+        char cChomp = 0;
+        int32_t iIndent = -1;
+        for (; m_uPos < m_sLine.size() && m_sLine[m_uPos] != ' ' && m_sLine[m_uPos] != '\t'; m_uPos++) {
+            const char c = m_sLine[m_uPos];
+            if ((c == '-' || c == '+') && !cChomp)
+                cChomp = c;
+            else if (c >= '1' && c <= '9' && iIndent < 0)
+                iIndent = std::max<int32_t>(_iParentIndent, 0) + (c - '0');
+            else _Error("Invalid block scalar header");
+        }
+
+        if (!_AtLineEnd())
+            _Error("Unexpected characters after block scalar header");
+
+        // content lines, empty lines are stored as empty strings
+        std::vector<std::string> lines;
+        while (_ReadLine()) {
+            size_t uSpaces = 0;
+            while (uSpaces < m_sLine.size() && m_sLine[uSpaces] == ' ')
+                uSpaces++;
+
+            const bool bEmpty = uSpaces == m_sLine.size();
+            if (!bEmpty && iIndent < 0)
+                iIndent = static_cast<int32_t>(uSpaces);
+
+            if (!bEmpty && static_cast<int32_t>(uSpaces) < iIndent) {
+                m_bUnread = true;
+                break;
+            }
+
+            if (!bEmpty && static_cast<int32_t>(uSpaces) <= _iParentIndent) {
+                m_bUnread = true;
+                break;
+            }
+
+            lines.push_back(bEmpty || iIndent < 0 ? std::string() : m_sLine.substr(iIndent));
+        }
+
+        size_t uTrailing = 0;
+        while (!lines.empty() && lines.back().empty()) {
+            lines.pop_back();
+            uTrailing++;
+        }
+
+        std::string sText;
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (i) {
+                const std::string& sPrev = lines[i - 1];
+                const bool bPrevText = !sPrev.empty() && sPrev[0] != ' ' && sPrev[0] != '\t';
+                const bool bText = !lines[i].empty() && lines[i][0] != ' ' && lines[i][0] != '\t';
+
+                // folding joins lines of text with a space, the line break before an empty line is dropped
+                if (!bFolded || !bPrevText)
+                    sText += '\n';
+                else if (bText)
+                    sText += ' ';
+            }
+            sText += lines[i];
+        }
+
+        if (cChomp == '+')
+            sText.append(uTrailing + (lines.empty() ? 0 : 1), '\n');
+        else if (cChomp != '-' && !lines.empty())
+            sText += '\n';
+
+        return sText;
+    }
+
+
+    void YAMLUnserializer::_ParseFlow(ObjectMap* _pMap, List* _pList) {
+        // pair specification:
+        // first - container that is being filled, either an object or a list
+        // second - boolean flag to indicate that the next token shall be a comma or the closing bracket
+        std::vector<std::pair<std::pair<ObjectMap*, List*>, bool>> stckFrames;
+        stckFrames.push_back(std::make_pair(std::make_pair(_pMap, _pList), false));
+
+        while (!stckFrames.empty()) {
+            // flow collections may span lines
+            while (_AtLineEnd()) {
+                if (!_ReadLine())
+                    throw UnexpectedEOFException("Flow collection is not closed before the end of document");
+            }
+
+            ObjectMap* pMap = stckFrames.back().first.first;
+            List* pList = stckFrames.back().first.second;
+            bool& bIsContinuation = stckFrames.back().second;
+            const char c = m_sLine[m_uPos];
+
+            if (c == (pMap ? '}' : ']')) {
+                // sequences whose items share a single type are stored as contiguous Int, Float or Bool arrays
+                _DropNulls(pMap, pList);
+                if (pList)
+                    pList->Pack();
+                stckFrames.pop_back();
+                m_uPos++;
+                continue;
+            }
+
+            if (bIsContinuation) {
+                if (c != ',')
+                    _Error(std::string("Expected a comma separator or '") + (pMap ? '}' : ']') + "'");
+                bIsContinuation = false;
+                m_uPos++;
+                continue;
+            }
+            bIsContinuation = true;
+
+            // value slot of the entry, lists get their values appended
+            Value* pSlot = nullptr;
+            if (pMap) {
+                pSlot = &(*pMap)[_ParseKey(true)];
+                *pSlot = std::monostate();
+
+                while (_AtLineEnd()) {
+                    if (!_ReadLine())
+                        throw UnexpectedEOFException("Flow collection is not closed before the end of document");
+                }
+
+                if (m_sLine[m_uPos] == ',' || m_sLine[m_uPos] == '}')
+                    continue;
+            }
+
+            const char cValue = m_sLine[m_uPos];
+            if (cValue == '[' || cValue == '{') {
+                m_uPos++;
+                if (!pSlot) {
+                    pList->PushBack(std::monostate());
+                    pSlot = &pList->Back();
+                }
+
+                if (cValue == '{') {
+                    std::shared_ptr<Object> pObject = std::make_shared<Object>();
+                    ObjectMap* pContents = &pObject->GetContents();
+                    *pSlot = std::move(pObject);
+                    stckFrames.push_back(std::make_pair(std::make_pair(pContents, nullptr), false));
+                }
+                else {
+                    *pSlot = List();
+                    stckFrames.push_back(std::make_pair(std::make_pair(nullptr, &std::get<List>(*pSlot)), false));
+                }
+                continue;
+            }
+
+            Value val;
+            if (cValue == '"' || cValue == '\'')
+                val = String(_ParseQuoted());
+            else if (cValue == ',' || cValue == ']' || cValue == '}')
+                _Error(std::string("Unexpected '") + cValue + "' in flow collection");
+            else val = _ResolvePlain(_ParsePlain(true));
+
+            if (pSlot)
+                *pSlot = std::move(val);
+            else pList->PushBack(std::move(val));
+        }
+    }
+
+
+    Value YAMLUnserializer::_ParseValue(int32_t _iParentIndent) {
+        const char c = m_sLine[m_uPos];
+        Value val;
+
+        switch (c) {
+            case '|':
+            case '>':
+                // block scalars consume the following lines themselves
+                return String(_ParseBlockScalar(_iParentIndent));
+
+            case '[':
+            {
+                m_uPos++;
+                List list;
+                _ParseFlow(nullptr, &list);
+                val = std::move(list);
+                break;
+            }
+
+            case '{':
+            {
+                m_uPos++;
+                std::shared_ptr<Object> pObject = std::make_shared<Object>();
+                _ParseFlow(&pObject->GetContents(), nullptr);
+                val = std::move(pObject);
+                break;
+            }
+
+            case '"':
+            case '\'':
+                val = String(_ParseQuoted());
+                break;
+
+            case '&':
+            case '*':
+            case '!':
+                _Error("Anchors, aliases and tags are not supported");
+
+            case '@':
+            case '`':
+            case '%':
+            case ']':
+            case '}':
+            case ',':
+            {
+                std::stringstream ss;
+                ss << "Unexpected symbol '" << c << "'";
+                _Error(ss.str());
+            }
+
+            default:
+                val = _ResolvePlain(_ParsePlain(false));
+                if (m_uPos < m_sLine.size() && m_sLine[m_uPos] == ':')
+                    _Error("Nested mappings must start on a new line");
+                break;
+        }
+
+        if (!_AtLineEnd())
+            _Error("Unexpected characters after value");
+        return val;
+    }
+
+
+    void YAMLUnserializer::_Parse() {
+        // assume empty file is used (no exceptions thrown)
+        if (!_NextContentLine())
+            return;
+
+        // root mapping written in flow style
+        if (m_sLine[m_uPos] == '{') {
+            m_uPos++;
+            _ParseFlow(&m_root, nullptr);
+            if (!_AtLineEnd() || _NextContentLine())
+                _Error("Unexpected content after the root mapping");
+            return;
+        }
+
+        if (!_IsMappingEntry())
+            throw SyntaxErrorException("Root must always be an object");
+
+        // open block collections, iIndent is the column of their keys or sequence indicators
+        struct Frame {
+            ObjectMap* pMap;
+            List* pList;
+            int32_t iIndent;
+        };
+
+        std::vector<Frame> stckFrames;
+        stckFrames.push_back(Frame{ &m_root, nullptr, static_cast<int32_t>(m_uPos) });
+
+        auto PopFrame = [&stckFrames]() {
+            // sequences whose items share a single type are stored as contiguous Int, Float or Bool arrays
+            _DropNulls(stckFrames.back().pMap, stckFrames.back().pList);
+            if (stckFrames.back().pList)
+                stckFrames.back().pList->Pack();
+            stckFrames.pop_back();
+        };
+
+        // value of a key or a sequence item that has nothing after the indicator, it's either empty or a nested block
+        Value* pPending = nullptr;
+        int32_t iPendingIndent = 0;
+        bool bPendingKey = false;
+
+        do {
+            const int32_t iCol = static_cast<int32_t>(m_uPos);
+
+            if (pPending) {
+                // sequences may be nested at the same indentation as their mapping key
+                const bool bSequence = _IsSequenceItem();
+                if (iCol > iPendingIndent || (iCol == iPendingIndent && bSequence && bPendingKey)) {
+                    if (bSequence) {
+                        *pPending = List();
+                        stckFrames.push_back(Frame{ nullptr, &std::get<List>(*pPending), iCol });
+                    }
+                    else if (_IsMappingEntry()) {
+                        std::shared_ptr<Object> pObject = std::make_shared<Object>();
+                        stckFrames.push_back(Frame{ &pObject->GetContents(), nullptr, iCol });
+                        *pPending = std::move(pObject);
+                    }
+                    else {
+                        // value on its own line
+                        *pPending = _ParseValue(iPendingIndent);
+                        pPending = nullptr;
+                        continue;
+                    }
+                }
+                pPending = nullptr;
+            }
+
+            // close collections that are indented deeper than the current line
+            while (stckFrames.size() > 1 && stckFrames.back().iIndent > iCol)
+                PopFrame();
+            if (stckFrames.size() > 1 && stckFrames.back().pList && stckFrames.back().iIndent == iCol && !_IsSequenceItem())
+                PopFrame();
+
+            if (stckFrames.back().iIndent != iCol)
+                _Error("Inconsistent indentation");
+
+            // entries of compact nested collections, e.g. '- - key: value', continue on the same line
+            while (true) {
+                const Frame top = stckFrames.back();
+
+                if (top.pList) {
+                    if (!_IsSequenceItem())
+                        _Error("Expected a sequence item");
+
+                    m_uPos++;
+                    if (_AtLineEnd()) {
+                        top.pList->PushBack(std::monostate());
+                        pPending = &top.pList->Back();
+                        iPendingIndent = top.iIndent;
+                        bPendingKey = false;
+                        break;
+                    }
+
+                    const int32_t iItemCol = static_cast<int32_t>(m_uPos);
+                    if (_IsSequenceItem()) {
+                        top.pList->PushBack(List());
+                        stckFrames.push_back(Frame{ nullptr, &std::get<List>(top.pList->Back()), iItemCol });
+                        continue;
+                    }
+                    else if (_IsMappingEntry()) {
+                        top.pList->PushBack(std::make_shared<Object>());
+                        stckFrames.push_back(Frame{ &std::get<std::shared_ptr<Object>>(top.pList->Back())->GetContents(), nullptr, iItemCol });
+                        continue;
+                    }
+
+                    top.pList->PushBack(_ParseValue(top.iIndent));
+                    break;
+                }
+
+                if (_IsSequenceItem())
+                    _Error("Unexpected sequence item inside a mapping");
+
+                // duplicate keys overwrite the previous value
+                Value& slot = (*top.pMap)[_ParseKey(false)];
+                slot = std::monostate();
+                if (_AtLineEnd()) {
+                    pPending = &slot;
+                    iPendingIndent = top.iIndent;
+                    bPendingKey = true;
+                    break;
+                }
+
+                slot = _ParseValue(top.iIndent);
+                break;
+            }
+        } while (_NextContentLine());
+
+        while (!stckFrames.empty())
+            PopFrame();
+    }
+}
@@ -0,0 +1,121 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: AtomicTests.cpp - atomic variable storage tests
+// author: Karl-Mihkel Ott
+
+#include "TestCommon.h"
+#include <cvar/CVarSystem.h>
+#include <cvar/JSONSerializer.h>
+#include <cvar/JSONUnserializer.h>
+#include <fstream>
+#include <string>
+
+using namespace cvar;
+
+static void TestMakeAtomic() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    cvarSyst.Set<Int>("physics.substeps", 4);
+
+    AtomicCVar<Int> substeps = cvarSyst.MakeAtomic<Int>("physics.substeps");
+    CVAR_CHECK(substeps.IsValid());
+    CVAR_CHECK(substeps.Load() == 4);
+
+    // the same slot is returned for the same variable, other types are rejected
+    AtomicCVar<Int> again = cvarSyst.MakeAtomic<Int>("physics.substeps");
+    CVAR_CHECK(again.IsValid());
+    again.Store(5);
+    CVAR_CHECK(substeps.Load() == 5);
+    CVAR_CHECK(!cvarSyst.MakeAtomic<Float>("physics.substeps").IsValid());
+
+    // missing variables are created with the default value
+    AtomicCVar<Bool> paused = cvarSyst.MakeAtomic<Bool>("physics.paused");
+    CVAR_CHECK(paused.IsValid());
+    CVAR_CHECK(cvarSyst.Get<Bool>("physics.paused") && !*cvarSyst.Get<Bool>("physics.paused"));
+
+    // Set() writes through to the atomic slot
+    cvarSyst.Set<Int>("physics.substeps", 6);
+    CVAR_CHECK(substeps.Load() == 6);
+}
+
+
+static void TestReadsSeeStores() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    cvarSyst.Set<Float>("render.gamma", 2.2f);
+    AtomicCVar<Float> gamma = cvarSyst.MakeAtomic<Float>("render.gamma");
+    CVarHandle<Float> handle = cvarSyst.Resolve<Float>("render.gamma");
+
+    gamma.Store(1.8f);
+    CVAR_CHECK(*cvarSyst.Get<Float>("render.gamma") == 1.8f);
+    CVAR_CHECK(*cvarSyst.Get<Float>(CVAR_PATH("render.gamma")) == 1.8f);
+
+    gamma.Store(2.0f);
+    CVAR_CHECK(*handle.Get() == 2.0f);
+
+    gamma.Store(2.4f);
+    Snapshot snapshot = cvarSyst.TakeSnapshot();
+    gamma.Store(2.6f);
+    CVAR_CHECK(*snapshot.Get<Float>("render.gamma") == 2.4f);
+
+    gamma.Store(1.5f);
+    cvarSyst.Serialize<JSONSerializer>("AtomicTests.json", false);
+    std::ifstream stream("AtomicTests.json", std::ios::binary);
+    JSONUnserializer unserializer(stream);
+    const ObjectMap saved = unserializer.Get();
+    const Value* pSaved = FindTreeNode(saved, "render.gamma");
+    CVAR_CHECK(pSaved && std::holds_alternative<Float>(*pSaved) && std::get<Float>(*pSaved) == 1.5f);
+}
+
+
+static void TestPublishedSnapshots() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    cvarSyst.SetSnapshotPublishing(true);
+    AtomicCVar<Int> level = cvarSyst.MakeAtomic<Int>("log.level");
+
+    // published snapshots pick the store up once it has been synchronized on the writer thread
+    level.Store(3);
+    cvarSyst.SyncAtomics();
+    CVAR_CHECK(*cvarSyst.AcquireSnapshot().Get<Int>("log.level") == 3);
+
+    level.Store(4);
+    CVAR_CHECK(*cvarSyst.Get<Int>("log.level") == 4);
+    CVAR_CHECK(*cvarSyst.AcquireSnapshot().Get<Int>("log.level") == 4);
+    cvarSyst.SetSnapshotPublishing(false);
+}
+
+
+static void TestCollidingPaths() {
+    const auto [sFirst, sSecond] = cvar_test::FindCollision();
+    if (!CVAR_CHECK(!sFirst.empty()))
+        return;
+
+    const std::string sFirstPath = "atomic." + sFirst;
+    const std::string sSecondPath = "atomic." + sSecond;
+    CVAR_CHECK(RUNTIME_CRC(sFirstPath) == RUNTIME_CRC(sSecondPath));
+
+    // writes to a path whose hash collides with an atomic variable must not reach its slot
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    AtomicCVar<Int> first = cvarSyst.MakeAtomic<Int>(sFirstPath);
+    first.Store(1);
+    cvarSyst.Set<Int>(sSecondPath, 99);
+    CVAR_CHECK(first.Load() == 1);
+    CVAR_CHECK(*cvarSyst.Get<Int>(sFirstPath) == 1);
+    CVAR_CHECK(*cvarSyst.Get<Int>(sSecondPath) == 99);
+
+    // both paths can be atomic at the same time
+    AtomicCVar<Int> second = cvarSyst.MakeAtomic<Int>(sSecondPath);
+    CVAR_CHECK(second.IsValid() && second.Load() == 99);
+    second.Store(7);
+    first.Store(2);
+    CVAR_CHECK(*cvarSyst.Get<Int>(sFirstPath) == 2);
+    CVAR_CHECK(*cvarSyst.Get<Int>(sSecondPath) == 7);
+    CVAR_CHECK(cvarSyst.MakeAtomic<Int>(sFirstPath).Load() == 2);
+}
+
+
+int main() {
+    TestMakeAtomic();
+    TestReadsSeeStores();
+    TestPublishedSnapshots();
+    TestCollidingPaths();
+    return cvar_test::Report("AtomicTests");
+}
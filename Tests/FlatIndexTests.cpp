@@ -0,0 +1,91 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: FlatIndexTests.cpp - full path index lookup and hash collision tests
+// author: Karl-Mihkel Ott
+
+#include "TestCommon.h"
+#include <cvar/CVarSystem.h>
+#include <cvar/JSONUnserializer.h>
+#include <fstream>
+#include <string>
+
+using namespace cvar;
+
+static void TestLookups() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    cvarSyst.Set<Int>("window.size.width", 800);
+    cvarSyst.Set<Int>("window.size.height", 600);
+
+    CVAR_CHECK(*cvarSyst.Get<Int>("window.size.width") == 800);
+    CVAR_CHECK(*cvarSyst.Get<Int>("window.size.height") == 600);
+    CVAR_CHECK(std::holds_alternative<std::shared_ptr<Object>>(*cvarSyst.GetValue("window.size")));
+    CVAR_CHECK(!cvarSyst.GetValue("window.size.depth"));
+    CVAR_CHECK(!cvarSyst.GetValue("window.size.width.x"));
+
+    CVAR_CHECK(*cvarSyst.Get<Int>(CVAR_PATH("window.size.width")) == 800);
+    CVAR_CHECK(cvarSyst.Set(CVAR_PATH("window.size.width"), Int(1024)));
+    CVAR_CHECK(*cvarSyst.Get<Int>("window.size.width") == 1024);
+
+    // indexed nodes of a replaced object must not be returned
+    cvarSyst.Set<Int>("window.size", 3);
+    CVAR_CHECK(!cvarSyst.GetValue("window.size.width"));
+    CVAR_CHECK(!cvarSyst.GetValue(CVAR_PATH("window.size.height")));
+}
+
+
+static void TestUnserializedTree() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    {
+        std::ofstream stream("FlatIndexTests.json");
+        stream << "{ \"a\": { \"b\": { \"c\": 1 }, \"d\": 2.5 }, \"e\": true }";
+    }
+    cvarSyst.Unserialize<JSONUnserializer>("FlatIndexTests.json");
+
+    CVAR_CHECK(*cvarSyst.Get<Int>("a.b.c") == 1);
+    CVAR_CHECK(*cvarSyst.Get<Float>("a.d") == 2.5f);
+    CVAR_CHECK(*cvarSyst.Get<Bool>("e") == true);
+    CVAR_CHECK(*cvarSyst.Get<Int>(CVAR_PATH("a.b.c")) == 1);
+    CVAR_CHECK(!cvarSyst.GetValue("window.size"));
+}
+
+
+static void TestHashCollision() {
+    const auto [sFirst, sSecond] = cvar_test::FindCollision();
+    if (!CVAR_CHECK(!sFirst.empty() && sFirst != sSecond))
+        return;
+    CVAR_CHECK(RUNTIME_CRC(sFirst) == RUNTIME_CRC(sSecond));
+
+    // full paths of equal length only differ in the colliding segment, thus they collide as well
+    const std::string sFirstPath = "collide." + sFirst;
+    const std::string sSecondPath = "collide." + sSecond;
+    CVAR_CHECK(RUNTIME_CRC(sFirstPath) == RUNTIME_CRC(sSecondPath));
+
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    cvarSyst.Set<Int>(sFirstPath, 1);
+    cvarSyst.Set<Int>(sSecondPath, 2);
+    CVAR_CHECK(*cvarSyst.Get<Int>(sFirstPath) == 1);
+    CVAR_CHECK(*cvarSyst.Get<Int>(sSecondPath) == 2);
+
+    // the same lookups through runtime constructed paths
+    const CVarPath<2> firstPath = MakePath<2>(sFirstPath.c_str(), sFirstPath.size());
+    const CVarPath<2> secondPath = MakePath<2>(sSecondPath.c_str(), sSecondPath.size());
+    CVAR_CHECK(*cvarSyst.Get<Int>(firstPath) == 1);
+    CVAR_CHECK(*cvarSyst.Get<Int>(secondPath) == 2);
+
+    cvarSyst.Set<Int>(sSecondPath, 3);
+    CVAR_CHECK(*cvarSyst.Get<Int>(sFirstPath) == 1);
+    CVAR_CHECK(*cvarSyst.Get<Int>(sSecondPath) == 3);
+
+    // a missing path must not be answered by the index entry of the colliding one
+    CVAR_CHECK(!cvarSyst.GetValue("missing." + sFirst));
+    cvarSyst.Set<Int>("other." + sFirst, 4);
+    CVAR_CHECK(!cvarSyst.GetValue("other." + sSecond));
+}
+
+
+int main() {
+    TestLookups();
+    TestUnserializedTree();
+    TestHashCollision();
+    return cvar_test::Report("FlatIndexTests");
+}
@@ -0,0 +1,126 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: HandleTests.cpp - CVarHandle resolution and invalidation tests
+// author: Karl-Mihkel Ott
+
+#include "TestCommon.h"
+#include <cvar/CVarSystem.h>
+#include <cvar/JSONUnserializer.h>
+#include <fstream>
+#include <memory>
+#include <string>
+
+using namespace cvar;
+
+static void TestReadWrite() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    cvarSyst.Set<Int>("rw.width", 1280);
+
+    CVarHandle<Int> width = cvarSyst.Resolve<Int>("rw.width");
+    CVAR_CHECK(width.IsValid());
+    CVAR_CHECK(*width.Get() == 1280);
+
+    CVAR_CHECK(width.Set(1920));
+    CVAR_CHECK(*cvarSyst.Get<Int>("rw.width") == 1920);
+
+    cvarSyst.Set<Int>("rw.width", 2560);
+    CVAR_CHECK(*width.Get() == 2560);
+}
+
+
+static void TestMissingVariable() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    CVarHandle<Int> height = cvarSyst.Resolve<Int>("missing.height");
+    CVAR_CHECK(!height.IsValid());
+    CVAR_CHECK(!height.Set(720));
+
+    // handles of missing variables are resolved again once something gets inserted
+    cvarSyst.Set<Int>("missing.height", 720);
+    CVAR_CHECK(height.IsValid());
+    CVAR_CHECK(*height.Get() == 720);
+}
+
+
+static void TestTypeChange() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    cvarSyst.Set<Int>("type.scale", 2);
+    CVarHandle<Int> scale = cvarSyst.Resolve<Int>("type.scale");
+    CVAR_CHECK(scale.IsValid());
+
+    cvarSyst.Set<Float>("type.scale", 1.5f);
+    CVAR_CHECK(!scale.IsValid());
+    CVAR_CHECK(!scale.Set(3));
+    CVAR_CHECK(*cvarSyst.Get<Float>("type.scale") == 1.5f);
+}
+
+
+static void TestReplacedParent() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    cvarSyst.Set<Bool>("parent.child.enabled", true);
+    CVarHandle<Bool> enabled = cvarSyst.Resolve<Bool>("parent.child.enabled");
+    CVAR_CHECK(enabled.IsValid());
+
+    // the node the handle pointed to is destroyed together with its parent object
+    cvarSyst.Set<Int>("parent.child", 5);
+    CVAR_CHECK(!enabled.IsValid());
+
+    cvarSyst.Set<Int>("parent", 7);
+    CVAR_CHECK(!enabled.IsValid());
+    CVAR_CHECK(*cvarSyst.Get<Int>("parent") == 7);
+
+    // parents that aren't objects are never replaced implicitly
+    CVAR_CHECK(!cvarSyst.Set<Bool>("parent.child.enabled", false));
+    CVAR_CHECK(!enabled.IsValid());
+
+    // recreating the path makes the handle valid again
+    cvarSyst.Set<std::shared_ptr<Object>>("parent", std::make_shared<Object>());
+    CVAR_CHECK(cvarSyst.Set<Bool>("parent.child.enabled", false));
+    CVAR_CHECK(enabled.IsValid());
+    CVAR_CHECK(*enabled.Get() == false);
+}
+
+
+static void TestUnserialize() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    cvarSyst.Set<Int>("load.value", 1);
+    CVarHandle<Int> value = cvarSyst.Resolve<Int>("load.value");
+    CVarHandle<Int> other = cvarSyst.Resolve<Int>("load.other");
+
+    {
+        std::ofstream stream("HandleTests.json");
+        stream << "{ \"load\": { \"value\": 2, \"other\": 3 } }";
+    }
+    cvarSyst.Unserialize<JSONUnserializer>("HandleTests.json");
+
+    // the whole tree was replaced, thus both handles must resolve the new nodes
+    CVAR_CHECK(value.IsValid());
+    CVAR_CHECK(*value.Get() == 2);
+    CVAR_CHECK(other.IsValid());
+    CVAR_CHECK(*other.Get() == 3);
+    CVAR_CHECK(!cvarSyst.GetValue("rw.width"));
+}
+
+
+static void TestSnapshotIsolation() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    cvarSyst.Set<Int>("snap.value", 10);
+    CVarHandle<Int> value = cvarSyst.Resolve<Int>("snap.value");
+
+    // writing through a handle resolved before the snapshot must not modify the snapshot
+    Snapshot snapshot = cvarSyst.TakeSnapshot();
+    CVAR_CHECK(value.Set(11));
+    CVAR_CHECK(value.Set(12));
+    CVAR_CHECK(*snapshot.Get<Int>("snap.value") == 10);
+    CVAR_CHECK(*cvarSyst.Get<Int>("snap.value") == 12);
+}
+
+
+int main() {
+    TestReadWrite();
+    TestMissingVariable();
+    TestTypeChange();
+    TestReplacedParent();
+    TestUnserialize();
+    TestSnapshotIsolation();
+    return cvar_test::Report("HandleTests");
+}
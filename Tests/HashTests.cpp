@@ -0,0 +1,165 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: HashTests.cpp - hash function and compile time and runtime key hash agreement tests
+// author: Karl-Mihkel Ott
+
+#include "TestCommon.h"
+#include <cvar/CVarSystem.h>
+#include <cstdint>
+#include <random>
+#include <string>
+
+using namespace cvar;
+
+static void TestPathHashes() {
+    const auto& path = CVAR_PATH("render.shadow.bias");
+    static_assert(std::decay_t<decltype(path)>::uCount == 3, "CVAR_PATH must split the key into three segments");
+    CVAR_CHECK(path.sPath == "render.shadow.bias");
+    CVAR_CHECK(path.hshPath == RUNTIME_CRC("render.shadow.bias"));
+
+    const char* arrSegments[] = { "render", "shadow", "bias" };
+    for (size_t i = 0; i < 3; i++) {
+        CVAR_CHECK(path.arrSegments[i] == arrSegments[i]);
+        CVAR_CHECK(path.arrHashes[i] == RUNTIME_CRC(arrSegments[i]));
+    }
+
+    // full path hash of a runtime path is extended segment by segment in the same way
+    hash_t hshExtended = RUNTIME_CRC("render");
+    hshExtended = RUNTIME_CRC_EXTEND(hshExtended, ".shadow", 7);
+    hshExtended = RUNTIME_CRC_EXTEND(hshExtended, ".bias", 5);
+    CVAR_CHECK(hshExtended == path.hshPath);
+
+    // paths are hashed by the compiler
+    constexpr CVarPath<2> constPath = MakePath<2>("net.port", 8);
+    static_assert(constPath.hshPath == static_cast<hash_t>(CONSTEXPR_CRC("net.port", 8)), "path hash must be a constant expression");
+    CVAR_CHECK(constPath.hshPath == RUNTIME_CRC("net.port"));
+    CVAR_CHECK(constPath.arrHashes[1] == RUNTIME_CRC("port"));
+}
+
+
+static void TestSegmentCount() {
+    static_assert(CountPathSegments("a", 1) == 1, "single segment");
+    static_assert(CountPathSegments("a.b.c", 5) == 3, "three segments");
+    static_assert(CountPathSegments("a.b.", 4) == 2, "trailing delimiter doesn't start a segment");
+
+    const auto& single = CVAR_PATH("volume");
+    CVAR_CHECK(single.uCount == 1);
+    CVAR_CHECK(single.hshPath == single.arrHashes[0]);
+    CVAR_CHECK(single.hshPath == RUNTIME_CRC("volume"));
+}
+
+
+static void TestPathAccess() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+
+    // compile time and string keys address the same variables
+    CVAR_CHECK(cvarSyst.Set<Float>(CVAR_PATH("hash.render.gamma"), 2.2f));
+    CVAR_CHECK(cvarSyst.Get<Float>("hash.render.gamma") && *cvarSyst.Get<Float>("hash.render.gamma") == 2.2f);
+
+    cvarSyst.Set<Int>("hash.render.samples", 4);
+    CVAR_CHECK(cvarSyst.Get<Int>(CVAR_PATH("hash.render.samples")) && *cvarSyst.Get<Int>(CVAR_PATH("hash.render.samples")) == 4);
+    CVAR_CHECK(!cvarSyst.Get<Float>(CVAR_PATH("hash.render.samples")));
+    CVAR_CHECK(!cvarSyst.GetValue(CVAR_PATH("hash.render.missing")));
+
+    CVAR_CHECK(cvarSyst.Emplace<String>(CVAR_PATH("hash.render.name"), "a name that is longer than a pointer"));
+    CVAR_CHECK(*cvarSyst.Get<String>("hash.render.name") == String("a name that is longer than a pointer"));
+
+    // a parent that isn't an object can't be walked through
+    CVAR_CHECK(!cvarSyst.Set<Int>(CVAR_PATH("hash.render.samples.x"), 1));
+}
+
+
+// random bytes, including ones with the sign bit set
+static std::string _RandomBytes(std::mt19937& _rng, size_t _uLen) {
+    std::string sData(_uLen, '\0');
+    for (char& c : sData)
+        c = static_cast<char>(_rng() & 0xff);
+    return sData;
+}
+
+
+static void TestKnownValues() {
+    // CRC-32C check value
+    CVAR_CHECK(RuntimeCrc32c("123456789") == 0xe3069283);
+    CVAR_CHECK(RuntimeCrc32cSoftware("123456789", 9) == 0xe3069283);
+    static_assert(ConstexprCrc32c("123456789", 9) == 0xe3069283, "constexpr CRC-32C must use the standard initial value");
+    CVAR_CHECK(RuntimeCrc32c("") == 0 && ConstexprCrc32c("", 0) == 0);
+}
+
+
+static void TestSlicing() {
+    // slicing by 8 implementations must agree with the byte wise constexpr ones for every length and alignment
+    std::mt19937 rng(11);
+    const std::string sBuffer = _RandomBytes(rng, 600);
+    for (size_t uOffset = 0; uOffset < 8; uOffset++) {
+        for (size_t uLen = 0; uLen + uOffset <= 300; uLen++) {
+            const char* pData = sBuffer.data() + uOffset;
+            if (!CVAR_CHECK(RuntimeCrc32(pData, uLen) == ConstexprCrc32(pData, uLen)) ||
+                !CVAR_CHECK(RuntimeCrc64(pData, uLen) == ConstexprCrc64(pData, uLen)) ||
+                !CVAR_CHECK(RuntimeCrc32cSoftware(pData, uLen) == ConstexprCrc32c(pData, uLen)))
+                return;
+        }
+    }
+
+    // long inputs go through the unrolled loop many times
+    CVAR_CHECK(RuntimeCrc32cSoftware(sBuffer.data(), sBuffer.size()) == ConstexprCrc32c(sBuffer.data(), sBuffer.size()));
+    CVAR_CHECK(RuntimeCrc64(sBuffer.data(), sBuffer.size()) == ConstexprCrc64(sBuffer.data(), sBuffer.size()));
+}
+
+
+static void TestCrc32cBackends() {
+    std::printf("CRC-32C is computed %s\n", HasHardwareCrc32c() ? "with CPU instructions" : "from tables");
+
+    // RuntimeCrc32c() uses the hardware implementation if there is one, it must match the tables
+    std::mt19937 rng(13);
+    for (int i = 0; i < 2000; i++) {
+        const std::string sData = _RandomBytes(rng, rng() % 200);
+        const size_t uOffset = sData.empty() ? 0 : rng() % sData.size();
+        const char* pData = sData.data() + uOffset;
+        const size_t uLen = sData.size() - uOffset;
+        if (!CVAR_CHECK(RuntimeCrc32c(pData, uLen) == RuntimeCrc32cSoftware(pData, uLen)))
+            return;
+
+        // extending a hash is the same as hashing the concatenation
+        const size_t uSplit = uLen ? rng() % uLen : 0;
+        if (!CVAR_CHECK(RuntimeCrc32c(RuntimeCrc32c(pData, uSplit), pData + uSplit, uLen - uSplit) == RuntimeCrc32c(pData, uLen)))
+            return;
+    }
+}
+
+
+static void TestBackendMacros() {
+    // whichever backend is selected, its runtime, range, extending and constexpr variants agree
+    std::mt19937 rng(17);
+    for (int i = 0; i < 500; i++) {
+        std::string sKey = _RandomBytes(rng, rng() % 64);
+        for (char& c : sKey) {
+            if (c == '\0')
+                c = 'x';
+        }
+
+        const hash_t hshKey = RUNTIME_CRC(sKey);
+        if (!CVAR_CHECK(hshKey == static_cast<hash_t>(CONSTEXPR_CRC(sKey.data(), sKey.size()))) ||
+            !CVAR_CHECK(hshKey == RUNTIME_CRC(sKey.c_str())) ||
+            !CVAR_CHECK(hshKey == RUNTIME_CRC_RANGE(sKey.data(), sKey.size())))
+            return;
+
+        for (size_t uSplit = 0; uSplit <= sKey.size(); uSplit++) {
+            const hash_t hshPrefix = RUNTIME_CRC_RANGE(sKey.data(), uSplit);
+            if (!CVAR_CHECK(RUNTIME_CRC_EXTEND(hshPrefix, sKey.data() + uSplit, sKey.size() - uSplit) == hshKey))
+                return;
+        }
+    }
+}
+
+
+int main() {
+    TestPathHashes();
+    TestSegmentCount();
+    TestPathAccess();
+    TestKnownValues();
+    TestSlicing();
+    TestCrc32cBackends();
+    TestBackendMacros();
+    return cvar_test::Report("HashTests");
+}
@@ -0,0 +1,117 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: IncrementalSaveTests.cpp - incremental serialization tests
+// author: Karl-Mihkel Ott
+
+#include "TestCommon.h"
+#include <cvar/CVarSystem.h>
+#include <cvar/JSONSerializer.h>
+#include <cvar/JSONUnserializer.h>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace cvar;
+
+static std::string _ReadFile(const std::string& _sFileName) {
+    std::ifstream stream(_sFileName, std::ios::binary);
+    std::stringstream ss;
+    ss << stream.rdbuf();
+    return ss.str();
+}
+
+
+// incremental output must be identical to a full save of the same tree
+static bool _CheckSave(bool _bBeautified) {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    cvarSyst.SerializeIncremental<JSONSerializer>("IncrementalSaveTests.json", _bBeautified);
+    cvarSyst.Serialize<JSONSerializer>("IncrementalSaveTestsFull.json", _bBeautified);
+    return _ReadFile("IncrementalSaveTests.json") == _ReadFile("IncrementalSaveTestsFull.json");
+}
+
+
+static void TestRandomWrites() {
+    const auto [sFirst, sSecond] = cvar_test::FindCollision();
+    if (!CVAR_CHECK(!sFirst.empty()))
+        return;
+
+    // colliding segments under the same parent give colliding full paths for objects and values alike
+    const std::vector<std::string> segments = { "a", "b", sFirst, sSecond };
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    std::mt19937 rng(19);
+
+    for (int iRound = 0; iRound < 300; iRound++) {
+        const int iWrites = static_cast<int>(rng() % 4) + 1;
+        for (int i = 0; i < iWrites; i++) {
+            std::string sKey = "save";
+            const size_t uDepth = rng() % 3 + 1;
+            for (size_t j = 0; j < uDepth; j++)
+                sKey += '.' + segments[rng() % segments.size()];
+
+            // writes below scalars fail, writes over objects replace them with their subtree
+            switch (rng() % 4) {
+                case 0:
+                    cvarSyst.Set<Int>(sKey, static_cast<Int>(rng() % 100));
+                    break;
+
+                case 1:
+                    cvarSyst.Set<String>(sKey, String("value " + std::to_string(iRound)));
+                    break;
+
+                case 2:
+                    cvarSyst.Set<Bool>(sKey + ".flag", rng() % 2 == 0);
+                    break;
+
+                default:
+                    {
+                        CVarBatch batch;
+                        batch.Set<Float>(sKey + ".x", 0.5f);
+                        batch.Set<Float>(sKey + ".y", static_cast<Float>(iRound));
+                        cvarSyst.Apply(std::move(batch));
+                    }
+                    break;
+            }
+        }
+
+        if (!CVAR_CHECK(_CheckSave(iRound % 5 != 0))) {
+            std::fprintf(stderr, "round %d\n", iRound);
+            return;
+        }
+    }
+}
+
+
+static void TestReload() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    CVAR_CHECK(_CheckSave(true));
+
+    // loading a file drops every cached object
+    {
+        std::ofstream stream("IncrementalSaveTestsInput.json");
+        stream << "{ \"save\": { \"loaded\": { \"a\": 1 }, \"b\": [ 1, 2 ] } }";
+    }
+    cvarSyst.Unserialize<JSONUnserializer>("IncrementalSaveTestsInput.json");
+    CVAR_CHECK(_CheckSave(true));
+
+    // restoring a snapshot as well
+    Snapshot checkpoint = cvarSyst.TakeSnapshot();
+    cvarSyst.Set<Int>("save.loaded.a", 2);
+    cvarSyst.Set<Int>("save.added.value", 3);
+    CVAR_CHECK(_CheckSave(true));
+    cvarSyst.Restore(checkpoint);
+    CVAR_CHECK(_CheckSave(true));
+    CVAR_CHECK(_CheckSave(false));
+
+    cvarSyst.ClearSerializationCache();
+    cvarSyst.Set<Int>("save.loaded.a", 4);
+    CVAR_CHECK(_CheckSave(true));
+}
+
+
+int main() {
+    TestRandomWrites();
+    TestReload();
+    return cvar_test::Report("IncrementalSaveTests");
+}
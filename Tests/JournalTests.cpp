@@ -0,0 +1,152 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: JournalTests.cpp - write-ahead journal replay, recovery and compaction tests
+// author: Karl-Mihkel Ott
+
+#include "TestCommon.h"
+#include <cvar/JSONUnserializer.h>
+#include <cvar/Journal.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace cvar;
+
+static const char* s_szSnapshotPath = "JournalTests.json";
+static const char* s_szJournalPath = "JournalTests.journal";
+static const char* s_szEmptyPath = "JournalTests.empty.json";
+
+static void _RemoveFiles() {
+    std::error_code err;
+    std::filesystem::remove(s_szSnapshotPath, err);
+    std::filesystem::remove(s_szJournalPath, err);
+    std::filesystem::remove(std::string(s_szJournalPath) + ".old", err);
+    std::filesystem::remove(s_szEmptyPath, err);
+}
+
+
+// empty tree, as if the process was started again
+static void _ResetTree() {
+    {
+        std::ofstream stream(s_szEmptyPath);
+        stream << "{}";
+    }
+    CVarSystem::GetInstance().Unserialize<JSONUnserializer>(s_szEmptyPath);
+}
+
+
+static void TestReplay() {
+    _RemoveFiles();
+    _ResetTree();
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+
+    {
+        JournalOptions options;
+        options.sync = JournalSync::Always;
+        Journal journal(cvarSyst, s_szSnapshotPath, s_szJournalPath, options);
+        CVAR_CHECK(journal.Open());
+
+        const Int arrSizes[] = { 1, 2, 3 };
+        cvarSyst.Set<Int>("video.width", 1280);
+        cvarSyst.Set<Int>("video.width", 1920);
+        cvarSyst.Set<Float>("audio.volume", 0.75f);
+        cvarSyst.Set<Bool>("audio.muted", true);
+        cvarSyst.Set<String>("player.name", String("a name that does not fit inline"));
+        cvarSyst.Set<List>("player.sizes", List(arrSizes, 3));
+        CVAR_CHECK(journal.GetSize() > 0);
+        CVAR_CHECK(!journal.HasError());
+    }
+
+    _ResetTree();
+    CVAR_CHECK(!cvarSyst.GetValue("video.width"));
+
+    Journal journal(cvarSyst, s_szSnapshotPath, s_szJournalPath);
+    CVAR_CHECK(journal.Open());
+    CVAR_CHECK(cvarSyst.Get<Int>("video.width") && *cvarSyst.Get<Int>("video.width") == 1920);
+    CVAR_CHECK(cvarSyst.Get<Float>("audio.volume") && *cvarSyst.Get<Float>("audio.volume") == 0.75f);
+    CVAR_CHECK(cvarSyst.Get<Bool>("audio.muted") && *cvarSyst.Get<Bool>("audio.muted"));
+    CVAR_CHECK(cvarSyst.Get<String>("player.name") && *cvarSyst.Get<String>("player.name") == String("a name that does not fit inline"));
+
+    const List* pSizes = cvarSyst.Get<List>("player.sizes");
+    CVAR_CHECK(pSizes && pSizes->Size() == 3 && std::get<Int>(pSizes->At(2)) == 3);
+}
+
+
+static void TestTruncatedRecord() {
+    _RemoveFiles();
+    _ResetTree();
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+
+    {
+        Journal journal(cvarSyst, s_szSnapshotPath, s_szJournalPath);
+        CVAR_CHECK(journal.Open());
+        cvarSyst.Set<Int>("crash.first", 1);
+        cvarSyst.Set<Int>("crash.second", 2);
+        journal.Sync();
+    }
+
+    // cut the last record short, as if the process stopped while it was being written
+    const uintmax_t uSize = std::filesystem::file_size(s_szJournalPath);
+    std::filesystem::resize_file(s_szJournalPath, uSize - 3);
+    _ResetTree();
+
+    {
+        Journal journal(cvarSyst, s_szSnapshotPath, s_szJournalPath);
+        CVAR_CHECK(journal.Open());
+        CVAR_CHECK(cvarSyst.Get<Int>("crash.first") && *cvarSyst.Get<Int>("crash.first") == 1);
+        CVAR_CHECK(!cvarSyst.GetValue("crash.second"));
+
+        // new records are appended after the valid part
+        cvarSyst.Set<Int>("crash.third", 3);
+        journal.Sync();
+    }
+    _ResetTree();
+
+    Journal journal(cvarSyst, s_szSnapshotPath, s_szJournalPath);
+    CVAR_CHECK(journal.Open());
+    CVAR_CHECK(cvarSyst.Get<Int>("crash.first") && *cvarSyst.Get<Int>("crash.first") == 1);
+    CVAR_CHECK(cvarSyst.Get<Int>("crash.third") && *cvarSyst.Get<Int>("crash.third") == 3);
+}
+
+
+static void TestCompaction() {
+    _RemoveFiles();
+    _ResetTree();
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+
+    {
+        JournalOptions options;
+        options.uCompactionThreshold = 256;
+        Journal journal(cvarSyst, s_szSnapshotPath, s_szJournalPath, options);
+        CVAR_CHECK(journal.Open());
+
+        for (Int i = 0; i < 100; i++)
+            cvarSyst.Set<Int>("compact.counter", i);
+        const size_t uSize = journal.GetSize();
+        CVAR_CHECK(uSize > options.uCompactionThreshold);
+
+        CVAR_CHECK(journal.Compact(true));
+        CVAR_CHECK(journal.GetSize() < uSize);
+        CVAR_CHECK(std::filesystem::exists(s_szSnapshotPath));
+        CVAR_CHECK(!std::filesystem::exists(journal.GetRotatedPath()));
+
+        // records written after the compaction go to the new journal
+        cvarSyst.Set<Int>("compact.after", 7);
+    }
+    _ResetTree();
+
+    Journal journal(cvarSyst, s_szSnapshotPath, s_szJournalPath);
+    CVAR_CHECK(journal.Open());
+    CVAR_CHECK(cvarSyst.Get<Int>("compact.counter") && *cvarSyst.Get<Int>("compact.counter") == 99);
+    CVAR_CHECK(cvarSyst.Get<Int>("compact.after") && *cvarSyst.Get<Int>("compact.after") == 7);
+    journal.Close();
+    _RemoveFiles();
+}
+
+
+int main() {
+    TestReplay();
+    TestTruncatedRecord();
+    TestCompaction();
+    return cvar_test::Report("JournalTests");
+}
@@ -0,0 +1,200 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: ObjectMapTests.cpp - insertion ordered map and object key symbol tests
+// author: Karl-Mihkel Ott
+
+#include "TestCommon.h"
+#include <cvar/CVarTypes.h>
+#include <cvar/OrderedMap.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace cvar;
+
+// every key lands in a handful of slots, thus lookups in the slot table have to probe
+struct WeakHash {
+    inline size_t operator()(const std::string& _sKey) const {
+        return _sKey.size() % 3;
+    }
+};
+
+typedef OrderedMap<std::string, int> Map;
+typedef OrderedMap<std::string, int, WeakHash> WeakMap;
+typedef std::vector<std::pair<std::string, int>> Reference;
+
+// the map must list the same entries in the same order as the reference and find each of them
+template <typename M>
+static bool _Matches(const M& _map, const Reference& _reference) {
+    if (_map.size() != _reference.size())
+        return false;
+
+    size_t i = 0;
+    for (auto it = _map.begin(); it != _map.end(); it++, i++) {
+        if (it->first != _reference[i].first || it->second != _reference[i].second)
+            return false;
+    }
+
+    for (const auto& entry : _reference) {
+        auto it = _map.find(entry.first);
+        if (it == _map.end() || it->second != entry.second)
+            return false;
+    }
+
+    return true;
+}
+
+
+static void TestInsertionOrder() {
+    Map map;
+    Reference reference;
+
+    // the order is kept while the map grows from linear scanning into the slot table
+    for (int i = 0; i < 3 * CVAR_ORDERED_MAP_LINEAR_LIMIT; i++) {
+        const std::string sKey = "key" + std::to_string((i * 7) % 31);
+        CVAR_CHECK(map.try_emplace(sKey, i).second);
+        reference.emplace_back(sKey, i);
+        if (!CVAR_CHECK(_Matches(map, reference)))
+            return;
+    }
+
+    // existing keys are neither moved nor overwritten by try_emplace
+    CVAR_CHECK(!map.try_emplace("key0", -1).second);
+    CVAR_CHECK(map.find("key0")->second == 0);
+    map["key7"] = 100;
+    CVAR_CHECK(map.find("key7")->second == 100);
+    CVAR_CHECK(map.begin()->first == "key0");
+    CVAR_CHECK(map.count("missing") == 0);
+    CVAR_CHECK(map.find("missing") == map.end());
+
+    // inserting never moves entries that are already in the map
+    const int* pFirst = &map.begin()->second;
+    for (int i = 0; i < 100; i++)
+        map.try_emplace("extra" + std::to_string(i), i);
+    CVAR_CHECK(pFirst == &map.begin()->second);
+}
+
+
+static void TestErase() {
+    Map map;
+    Reference reference;
+    for (int i = 0; i < 2 * CVAR_ORDERED_MAP_LINEAR_LIMIT; i++) {
+        map.try_emplace("key" + std::to_string(i), i);
+        reference.emplace_back("key" + std::to_string(i), i);
+    }
+
+    // erasing keeps the order of the remaining entries, and the map shrinks back below the linear limit
+    for (int i = 0; i < 2 * CVAR_ORDERED_MAP_LINEAR_LIMIT; i += 2) {
+        CVAR_CHECK(map.erase("key" + std::to_string(i)) == 1);
+        reference.erase(std::find_if(reference.begin(), reference.end(), [i](const auto& _entry) {
+            return _entry.first == "key" + std::to_string(i);
+        }));
+        if (!CVAR_CHECK(_Matches(map, reference)))
+            return;
+    }
+    CVAR_CHECK(map.erase("key0") == 0);
+
+    // erased keys are appended to the end when inserted again
+    map.try_emplace("key0", 50);
+    reference.emplace_back("key0", 50);
+    CVAR_CHECK(_Matches(map, reference));
+
+    // erasing by iterator returns the entry that took the erased one's place
+    auto it = map.erase(map.find("key1"));
+    CVAR_CHECK(it->first == "key3");
+    reference.erase(reference.begin());
+    CVAR_CHECK(_Matches(map, reference));
+
+    map.clear();
+    CVAR_CHECK(map.empty() && map.begin() == map.end());
+    CVAR_CHECK(map.find("key3") == map.end());
+    map.try_emplace("key3", 3);
+    CVAR_CHECK(map.size() == 1 && map.find("key3")->second == 3);
+}
+
+
+// random inserts and erases against a reference vector, with a hash that makes most keys collide
+template <typename M>
+static void _TestRandom(unsigned _uSeed) {
+    M map;
+    Reference reference;
+    std::mt19937 rng(_uSeed);
+    for (int i = 0; i < 4000; i++) {
+        const std::string sKey = std::string(rng() % 5 + 1, 'k') + std::to_string(rng() % 40);
+        auto itRef = std::find_if(reference.begin(), reference.end(), [&sKey](const auto& _entry) {
+            return _entry.first == sKey;
+        });
+
+        if (rng() % 3 == 0) {
+            CVAR_CHECK(map.erase(sKey) == (itRef != reference.end() ? 1u : 0u));
+            if (itRef != reference.end())
+                reference.erase(itRef);
+        }
+        else if (map.try_emplace(sKey, i).second) {
+            CVAR_CHECK(itRef == reference.end());
+            reference.emplace_back(sKey, i);
+        }
+
+        if (!CVAR_CHECK(_Matches(map, reference)))
+            return;
+    }
+
+    // copies and reserved maps behave the same
+    M copy = map;
+    CVAR_CHECK(_Matches(copy, reference));
+    copy.reserve(1000);
+    CVAR_CHECK(_Matches(copy, reference));
+    M moved = std::move(copy);
+    CVAR_CHECK(_Matches(moved, reference));
+}
+
+
+static void TestSymbols() {
+    // every way of constructing a symbol from the same text yields the same entry
+    const size_t uInterned = Symbol::GetInternedCount();
+    const Symbol first("symbol.text");
+    const std::string sText = "symbol.text";
+    CVAR_CHECK(Symbol(sText) == first);
+    CVAR_CHECK(Symbol(String("symbol.text")) == first);
+    CVAR_CHECK(Symbol(std::string_view(sText), RUNTIME_CRC(sText)) == first);
+    CVAR_CHECK(Symbol::GetInternedCount() == uInterned + 1);
+    CVAR_CHECK(Symbol("symbol.other") != first);
+    CVAR_CHECK(Symbol().GetSTDString().empty());
+
+    // keys with the same hash are distinct symbols that keep their own text
+    const auto [sFirst, sSecond] = cvar_test::FindCollision();
+    if (!CVAR_CHECK(!sFirst.empty()))
+        return;
+
+    const Symbol firstKey(sFirst);
+    const Symbol secondKey(sSecond);
+    CVAR_CHECK(firstKey.GetHash() == secondKey.GetHash());
+    CVAR_CHECK(firstKey != secondKey);
+    CVAR_CHECK(!SymbolEqual()(firstKey, secondKey));
+    CVAR_CHECK(firstKey.GetSTDString() == sFirst && secondKey.GetSTDString() == sSecond);
+    CVAR_CHECK(Symbol(sSecond) == secondKey);
+    CVAR_CHECK(SymbolEqual()(secondKey, std::string_view(sSecond)));
+
+    // an object holds both colliding keys, lookups by text compare the text as well
+    ObjectMap map;
+    map.try_emplace(firstKey, Int(1));
+    map.try_emplace(secondKey, Int(2));
+    CVAR_CHECK(map.size() == 2);
+    CVAR_CHECK(std::get<Int>(map.find(Symbol(sFirst))->second) == 1);
+    CVAR_CHECK(std::get<Int>(map.find(std::string_view(sSecond), static_cast<size_t>(secondKey.GetHash()))->second) == 2);
+    CVAR_CHECK(map.erase(firstKey) == 1);
+    CVAR_CHECK(map.find(firstKey) == map.end());
+    CVAR_CHECK(std::get<Int>(map.find(secondKey)->second) == 2);
+}
+
+
+int main() {
+    TestInsertionOrder();
+    TestErase();
+    _TestRandom<Map>(3);
+    _TestRandom<WeakMap>(5);
+    TestSymbols();
+    return cvar_test::Report("ObjectMapTests");
+}
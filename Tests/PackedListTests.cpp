@@ -0,0 +1,131 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: PackedListTests.cpp - packed homogeneous list tests
+// author: Karl-Mihkel Ott
+
+#include "TestCommon.h"
+#include <cvar/JSONUnserializer.h>
+#include <sstream>
+#include <string>
+
+using namespace cvar;
+
+static void TestPushBack() {
+    List empty;
+    CVAR_CHECK(!empty.IsPacked());
+    CVAR_CHECK(empty.GetSpan<Int>().empty());
+
+    List ints;
+    for (Int i = 0; i < 100; i++)
+        ints.PushBack(i * 3);
+    CVAR_CHECK(ints.GetPackedType() == Type_Int);
+    CVAR_CHECK(ints.Size() == 100);
+
+    Span<Int> span = ints.GetSpan<Int>();
+    CVAR_CHECK(span.size() == 100);
+    CVAR_CHECK(span[0] == 0 && span[99] == 297);
+    CVAR_CHECK(ints.GetSpan<Float>().empty());
+    CVAR_CHECK(std::get<Int>(ints.At(42)) == 126);
+
+    List bools;
+    bools.PushBack(true);
+    bools.PushBack(false);
+    CVAR_CHECK(bools.GetPackedType() == Type_Bool);
+    CVAR_CHECK(bools.GetSpan<Bool>()[1] == false);
+
+    // an element of another type unpacks the list, existing elements keep their values
+    ints.PushBack(String("end"));
+    CVAR_CHECK(!ints.IsPacked());
+    CVAR_CHECK(ints.Size() == 101);
+    CVAR_CHECK(std::get<Int>(ints.At(99)) == 297);
+    CVAR_CHECK(std::get<String>(ints.At(100)) == String("end"));
+}
+
+
+static void TestArrayConstructor() {
+    const Float arrValues[] = { 0.5f, 1.5f, 2.5f };
+    List floats(arrValues, 3);
+    CVAR_CHECK(floats.GetPackedType() == Type_Float);
+    CVAR_CHECK(floats.GetSpan<Float>()[2] == 2.5f);
+
+    // copies are packed as well and don't share storage
+    List copy = floats;
+    copy.PushBack(3.5f);
+    CVAR_CHECK(copy.GetPackedType() == Type_Float);
+    CVAR_CHECK(copy.Size() == 4);
+    CVAR_CHECK(floats.Size() == 3);
+
+    // mutable access unpacks the list
+    copy.Back() = Int(7);
+    CVAR_CHECK(!copy.IsPacked());
+    CVAR_CHECK(std::get<Int>(copy.At(3)) == 7);
+
+    size_t uCount = 0;
+    for (auto it = floats.Begin(); it != floats.End(); it++) {
+        CVAR_CHECK(std::get<Float>(*it) == arrValues[uCount]);
+        uCount++;
+    }
+    CVAR_CHECK(uCount == 3);
+}
+
+
+static void TestPack() {
+    List mixed;
+    mixed.PushBack(Int(1));
+    mixed.PushBack(String("x"));
+    mixed.Back() = Int(2);
+    CVAR_CHECK(!mixed.IsPacked());
+    CVAR_CHECK(mixed.Pack());
+    CVAR_CHECK(mixed.GetPackedType() == Type_Int);
+    CVAR_CHECK(mixed.GetSpan<Int>()[1] == 2);
+
+    // Int and Float values are only merged when promotion is requested
+    List numbers;
+    numbers.PushBack(Int(1));
+    numbers.PushBack(2.5f);
+    CVAR_CHECK(!numbers.Pack());
+    CVAR_CHECK(std::holds_alternative<Int>(numbers.At(0)));
+    CVAR_CHECK(numbers.Pack(true));
+    CVAR_CHECK(numbers.GetPackedType() == Type_Float);
+    CVAR_CHECK(numbers.GetSpan<Float>()[0] == 1.0f);
+
+    List strings;
+    strings.PushBack(String("a"));
+    CVAR_CHECK(!strings.Pack(true));
+}
+
+
+static void TestUnserializedArrays() {
+    std::stringstream ss("{ \"ints\": [1, 2, 3], \"floats\": [0.5, 1.5], \"bools\": [true, false], "
+                         "\"mixed\": [1, 2.5], \"strings\": [\"a\", \"b\"] }");
+    JSONUnserializer unserializer(ss);
+    const ObjectMap root = unserializer.Get();
+
+    const Value* pInts = FindTreeNode(root, "ints");
+    const Value* pFloats = FindTreeNode(root, "floats");
+    const Value* pBools = FindTreeNode(root, "bools");
+    const Value* pMixed = FindTreeNode(root, "mixed");
+    const Value* pStrings = FindTreeNode(root, "strings");
+    if (!CVAR_CHECK(pInts && pFloats && pBools && pMixed && pStrings))
+        return;
+
+    CVAR_CHECK(std::get<List>(*pInts).GetPackedType() == Type_Int);
+    CVAR_CHECK(std::get<List>(*pFloats).GetPackedType() == Type_Float);
+    CVAR_CHECK(std::get<List>(*pBools).GetPackedType() == Type_Bool);
+
+    // mixed arrays keep the types of their elements
+    const List& mixed = std::get<List>(*pMixed);
+    CVAR_CHECK(!mixed.IsPacked());
+    CVAR_CHECK(std::holds_alternative<Int>(mixed.At(0)));
+    CVAR_CHECK(std::holds_alternative<Float>(mixed.At(1)));
+    CVAR_CHECK(!std::get<List>(*pStrings).IsPacked());
+}
+
+
+int main() {
+    TestPushBack();
+    TestArrayConstructor();
+    TestPack();
+    TestUnserializedArrays();
+    return cvar_test::Report("PackedListTests");
+}
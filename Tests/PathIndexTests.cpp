@@ -0,0 +1,140 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: PathIndexTests.cpp - sorted path index query and maintenance tests
+// author: Karl-Mihkel Ott
+
+#include "TestCommon.h"
+#include <cvar/CVarSystem.h>
+#include <cvar/JSONUnserializer.h>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace cvar;
+
+typedef std::vector<std::string> Paths;
+
+// siblings whose keys continue with characters sorting right before and after '.' surround the descendants
+static PathIndex _MakeIndex() {
+    PathIndex index;
+    const char* arrPaths[] = { "a", "a-b", "a.x", "a.x.deep", "a.y", "a/c", "a0", "ab", "ab.x", "b", "b.x" };
+    for (const char* szPath : arrPaths)
+        index.Insert(szPath);
+    return index;
+}
+
+
+static void TestDescendantBounds() {
+    PathIndex index = _MakeIndex();
+    CVAR_CHECK(index.Size() == 11);
+    index.Insert("a.x");
+    CVAR_CHECK(index.Size() == 11);
+
+    // only paths continuing with '.' are descendants, "a-b" sorts before and "a/c" after them
+    index.EraseDescendants("a");
+    CVAR_CHECK(index.Size() == 8);
+    CVAR_CHECK(index.Contains("a") && index.Contains("a-b") && index.Contains("a/c") && index.Contains("a0"));
+    CVAR_CHECK(!index.Contains("a.x") && !index.Contains("a.x.deep") && !index.Contains("a.y"));
+    CVAR_CHECK(index.Contains("ab.x"));
+
+    // erasing a leaf or a missing path has no effect
+    index.EraseDescendants("a-b");
+    index.EraseDescendants("missing");
+    CVAR_CHECK(index.Size() == 8);
+}
+
+
+static void TestGlob() {
+    const PathIndex index = _MakeIndex();
+
+    // skipped subtrees must not hide siblings that share the beginning of their key
+    CVAR_CHECK(index.FindGlob("a*") == Paths({ "a", "a-b", "a/c", "a0", "ab" }));
+    CVAR_CHECK(index.FindGlob("a.*") == Paths({ "a.x", "a.y" }));
+    CVAR_CHECK(index.FindGlob("*.x") == Paths({ "a.x", "ab.x", "b.x" }));
+    CVAR_CHECK(index.FindGlob("a?") == Paths({ "a0", "ab" }));
+    CVAR_CHECK(index.FindGlob("?.x.*") == Paths({ "a.x.deep" }));
+    CVAR_CHECK(index.FindGlob("a.x") == Paths({ "a.x" }));
+    CVAR_CHECK(index.FindGlob("a.z").empty());
+
+    // a trailing ** matches one or more segments, but not the parent itself
+    CVAR_CHECK(index.FindGlob("a.**") == Paths({ "a.x", "a.x.deep", "a.y" }));
+    CVAR_CHECK(index.FindGlob("**").size() == index.Size());
+    CVAR_CHECK(index.FindGlob("a*.**") == Paths({ "a.x", "a.x.deep", "a.y", "ab.x" }));
+
+    // ** anywhere else is a single segment wildcard
+    CVAR_CHECK(index.FindGlob("**.x") == Paths({ "a.x", "ab.x", "b.x" }));
+
+    CVAR_CHECK(index.FindGlob("*", 2) == Paths({ "a", "a-b" }));
+    CVAR_CHECK(index.FindGlob("a.x", 0).empty());
+}
+
+
+static void TestComplete() {
+    const PathIndex index = _MakeIndex();
+    CVAR_CHECK(index.Complete("a") == Paths({ "a", "a-b", "a/c", "a0", "ab" }));
+    CVAR_CHECK(index.Complete("a.") == Paths({ "a.x", "a.y" }));
+    CVAR_CHECK(index.Complete("a.x") == Paths({ "a.x" }));
+    CVAR_CHECK(index.Complete("a.x.") == Paths({ "a.x.deep" }));
+    CVAR_CHECK(index.Complete("") == Paths({ "a", "a-b", "a/c", "a0", "ab", "b" }));
+    CVAR_CHECK(index.Complete("c").empty());
+    CVAR_CHECK(index.Complete("a", 3) == Paths({ "a", "a-b", "a/c" }));
+
+    CVAR_CHECK(index.FindPrefix("a.") == Paths({ "a.x", "a.x.deep", "a.y" }));
+    CVAR_CHECK(index.FindPrefix("ab") == Paths({ "ab", "ab.x" }));
+}
+
+
+static void TestMaintenance() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    cvarSyst.SetPathIndexing(true);
+
+    // new nodes and their parents are indexed by Set
+    cvarSyst.Set<Int>("index.render.shadow.size", 2048);
+    cvarSyst.Set<Bool>("index.render.shader.cache", true);
+    cvarSyst.Set<Int>("index.net.port", 80);
+    CVAR_CHECK(cvarSyst.CompletePath("index.render.sha") == Paths({ "index.render.shader", "index.render.shadow" }));
+    CVAR_CHECK(cvarSyst.FindPaths("index.render.*.size") == Paths({ "index.render.shadow.size" }));
+
+    // replacing an object with a scalar removes its descendants
+    CVAR_CHECK(cvarSyst.Set<Int>("index.render.shadow", 1));
+    CVAR_CHECK(cvarSyst.FindPaths("index.render.**") == Paths({ "index.render.shader", "index.render.shader.cache", "index.render.shadow" }));
+
+    // replacing a value with an object indexes the object's contents
+    auto pObject = std::make_shared<Object>();
+    pObject->PushNode("filter", String("pcf"));
+    pObject->PushNode("bias", Float(0.5f));
+    CVAR_CHECK(cvarSyst.Set<std::shared_ptr<Object>>("index.render.shadow", pObject));
+    CVAR_CHECK(cvarSyst.FindPaths("index.render.shadow.*") == Paths({ "index.render.shadow.bias", "index.render.shadow.filter" }));
+
+    // restoring a snapshot reindexes the restored tree
+    Snapshot checkpoint = cvarSyst.TakeSnapshot();
+    cvarSyst.Set<Int>("index.net", 0);
+    cvarSyst.Set<Int>("index.added", 1);
+    CVAR_CHECK(!cvarSyst.GetPathIndex().Contains("index.net.port"));
+    cvarSyst.Restore(checkpoint);
+    CVAR_CHECK(cvarSyst.GetPathIndex().Contains("index.net.port"));
+    CVAR_CHECK(!cvarSyst.GetPathIndex().Contains("index.added"));
+    CVAR_CHECK(cvarSyst.GetPathIndex().Contains("index.render.shadow.bias"));
+
+    // so does loading a file
+    {
+        std::ofstream stream("PathIndexTests.json");
+        stream << "{ \"index\": { \"loaded\": { \"a\": 1, \"b\": [ 1, 2 ] } } }";
+    }
+    cvarSyst.Unserialize<JSONUnserializer>("PathIndexTests.json");
+    CVAR_CHECK(cvarSyst.FindPaths("**") == Paths({ "index", "index.loaded", "index.loaded.a", "index.loaded.b" }));
+    CVAR_CHECK(cvarSyst.GetPathIndex().Size() == 4);
+
+    cvarSyst.SetPathIndexing(false);
+    CVAR_CHECK(cvarSyst.GetPathIndex().Size() == 0);
+}
+
+
+int main() {
+    TestDescendantBounds();
+    TestGlob();
+    TestComplete();
+    TestMaintenance();
+    return cvar_test::Report("PathIndexTests");
+}
@@ -0,0 +1,136 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: ScannerTests.cpp - JSON structural scanner backend tests
+// author: Karl-Mihkel Ott
+
+#include "TestCommon.h"
+#include <cvar/JSONScanner.h>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace cvar;
+
+static const JSONScanBackend s_arrBackends[] = { JSONScanBackend::Scalar, JSONScanBackend::SSE2, JSONScanBackend::AVX2 };
+
+static bool _IsOperator(char _c) {
+    return _c == '{' || _c == '}' || _c == '[' || _c == ']' || _c == ',' || _c == ':';
+}
+
+
+static bool _IsWhitespace(char _c) {
+    return _c == ' ' || _c == '\t' || _c == '\n' || _c == '\r';
+}
+
+
+// character by character reference of ScanJSONStructure()
+static bool _ScanReference(const std::string& _sText, std::vector<uint32_t>& _indices) {
+    bool bInString = false;
+    bool bEscaped = false;
+    bool bPrevBoundary = true;
+    for (size_t i = 0; i < _sText.size(); i++) {
+        const char c = _sText[i];
+        const bool bIsEscaped = bEscaped;
+        bEscaped = c == '\\' && !bIsEscaped;
+
+        const bool bQuote = c == '"' && !bIsEscaped;
+        const bool bBoundary = _IsWhitespace(c) || _IsOperator(c) || bQuote;
+        if (bQuote) {
+            _indices.push_back(static_cast<uint32_t>(i));
+            bInString = !bInString;
+        }
+        else if (!bInString) {
+            if (c == '\'')
+                return false;
+            if (_IsOperator(c) || (!bBoundary && bPrevBoundary))
+                _indices.push_back(static_cast<uint32_t>(i));
+        }
+        bPrevBoundary = bBoundary;
+    }
+
+    return true;
+}
+
+
+// every backend must produce the same result as the reference, unsupported backends fall back to a supported one
+static bool _CheckBackends(const std::string& _sText) {
+    std::vector<uint32_t> expected;
+    const bool bExpected = _ScanReference(_sText, expected);
+
+    for (JSONScanBackend backend : s_arrBackends) {
+        std::vector<uint32_t> indices;
+        const bool bResult = ScanJSONStructure(_sText.data(), _sText.size(), indices, backend);
+        if (bResult != bExpected || (bExpected && indices != expected)) {
+            std::fprintf(stderr, "%s backend differs on input of %zu bytes\n", GetJSONScanBackendName(backend), _sText.size());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+static void TestStructure() {
+    std::vector<uint32_t> indices;
+    const std::string sText = "{\"a\": [1, true], \"b\":\"x\\\"y\"}";
+    CVAR_CHECK(ScanJSONStructure(sText.data(), sText.size(), indices));
+    const std::vector<uint32_t> expected = { 0, 1, 3, 4, 6, 7, 8, 10, 14, 15, 17, 19, 20, 21, 26, 27 };
+    CVAR_CHECK(indices == expected);
+
+    indices.clear();
+    CVAR_CHECK(ScanJSONStructure("", 0, indices));
+    CVAR_CHECK(indices.empty());
+
+    // single quoted strings are left to the tokenizer, but only outside of double quoted strings
+    const std::string sSingle = "{'a': 1}";
+    CVAR_CHECK(!ScanJSONStructure(sSingle.data(), sSingle.size(), indices));
+    const std::string sApostrophe = "{\"a\": \"it's\"}";
+    indices.clear();
+    CVAR_CHECK(ScanJSONStructure(sApostrophe.data(), sApostrophe.size(), indices));
+}
+
+
+static void TestRandomInput() {
+    // characters that change the classification, including bytes that differ from operators only in a few bits
+    const char szAlphabet[] = "\"\\{}[],: a1\n\t'x\x0c\x1a\x80\xfb;Z\r";
+    std::mt19937 rng(7);
+    for (int i = 0; i < 20000; i++) {
+        std::string sText(rng() % 300, ' ');
+        const int iMode = rng() % 3;
+        for (char& c : sText) {
+            // one mode in three produces long backslash runs, another one has no single quotes
+            c = iMode == 1 && rng() % 4 == 0 ? '\\' : szAlphabet[rng() % (sizeof(szAlphabet) - 1)];
+            if (iMode == 2 && c == '\'')
+                c = 'x';
+        }
+
+        if (!CVAR_CHECK(_CheckBackends(sText)))
+            return;
+    }
+}
+
+
+static void TestBlockBoundaries() {
+    // backslash runs of every length ending on both sides of block boundaries
+    for (size_t uRun = 0; uRun < 140; uRun++) {
+        for (size_t uPrefix = 0; uPrefix < 70; uPrefix++) {
+            const std::string sText = "\"" + std::string(uPrefix, 'a') + std::string(uRun, '\\') + "\"a\" b";
+            if (!CVAR_CHECK(_CheckBackends(sText)))
+                return;
+        }
+    }
+
+    // strings spanning several blocks
+    const std::string sLong = "{\"key\": \"" + std::string(1000, 'v') + "\", \"n\": [1, 2, 3]}";
+    CVAR_CHECK(_CheckBackends(sLong));
+}
+
+
+int main() {
+    std::printf("scanning with %s backend\n", GetJSONScanBackendName(GetJSONScanBackend()));
+    TestStructure();
+    TestRandomInput();
+    TestBlockBoundaries();
+    return cvar_test::Report("ScannerTests");
+}
@@ -0,0 +1,578 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: SerializerTests.cpp - serializer round trip and edge case tests
+// author: Karl-Mihkel Ott
+
+#include "TestCommon.h"
+#include <cvar/BinarySerializer.h>
+#include <cvar/BinaryUnserializer.h>
+#include <cvar/JSONSerializer.h>
+#include <cvar/JSONUnserializer.h>
+#include <cvar/MappedConfig.h>
+#include <cvar/MessagePackSerializer.h>
+#include <cvar/MessagePackUnserializer.h>
+#include <cvar/SerializerExceptions.h>
+#include <cvar/YAMLSerializer.h>
+#include <cvar/YAMLUnserializer.h>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace cvar;
+
+static std::shared_ptr<Object> _MakeObject() {
+    return std::make_shared<Object>();
+}
+
+
+// tree with every value type and the edge cases that each serializer has to preserve
+static ObjectMap _MakeTree() {
+    ObjectMap root;
+    root[Symbol("int")] = Int(42);
+    root[Symbol("negative")] = Int(-7);
+    root[Symbol("intMin")] = std::numeric_limits<Int>::min();
+    root[Symbol("intMax")] = std::numeric_limits<Int>::max();
+    root[Symbol("float")] = 0.15625f;
+    root[Symbol("negativeFloat")] = -1234.5f;
+    root[Symbol("wholeFloat")] = 1024.f;
+    root[Symbol("preciseFloat")] = 16777215.f;
+    root[Symbol("largeFloat")] = 3.0e20f;
+    root[Symbol("tinyFloat")] = 1.5e-20f;
+    root[Symbol("true")] = true;
+    root[Symbol("false")] = false;
+    root[Symbol("short")] = String("abc");
+    root[Symbol("long")] = String("a string that is too long to be stored inline");
+    root[Symbol("empty")] = String("");
+    root[Symbol("escapes")] = String("quote \" backslash \\ slash / tab \t newline \n");
+    root[Symbol("utf8")] = String("t\xc3\xa4ht \xe2\x82\xac");
+
+    const Int arrInts[] = { 1, -2, 3, std::numeric_limits<Int>::max() };
+    const Float arrFloats[] = { 0.5f, -1.25f, 1024.f };
+    const Bool arrBools[] = { true, false, true };
+    root[Symbol("ints")] = List(arrInts, 4);
+    root[Symbol("floats")] = List(arrFloats, 3);
+    root[Symbol("bools")] = List(arrBools, 3);
+    root[Symbol("emptyList")] = List();
+
+    List mixed;
+    mixed.PushBack(Int(1));
+    mixed.PushBack(2.5f);
+    mixed.PushBack(String("three"));
+    mixed.PushBack(List(arrInts, 2));
+    root[Symbol("mixed")] = std::move(mixed);
+
+    std::shared_ptr<Object> pListObject = _MakeObject();
+    pListObject->GetContents()[Symbol("inList")] = true;
+    List objects;
+    objects.PushBack(pListObject);
+    objects.PushBack(List());
+    root[Symbol("objects")] = std::move(objects);
+
+    root[Symbol("emptyObject")] = _MakeObject();
+
+    // nested objects deeper than any fixed size stack would hold
+    std::shared_ptr<Object> pDeep = _MakeObject();
+    root[Symbol("deep")] = pDeep;
+    for (int i = 0; i < 64; i++) {
+        std::shared_ptr<Object> pChild = _MakeObject();
+        pDeep->GetContents()[Symbol("level")] = Int(i);
+        pDeep->GetContents()[Symbol("next")] = pChild;
+        pDeep = pChild;
+    }
+
+    // enough entries to exceed small buffer and hash table sizes
+    std::shared_ptr<Object> pWide = _MakeObject();
+    for (Int i = 0; i < 300; i++)
+        pWide->GetContents()[Symbol("key" + std::to_string(i))] = i;
+    root[Symbol("wide")] = pWide;
+    return root;
+}
+
+
+template <typename S, typename U>
+static ObjectMap _RoundTrip(ObjectMap& _root, bool _bBeautified) {
+    std::stringstream ss;
+    S serializer(ss, _root);
+    serializer.Serialize(_bBeautified);
+
+    U unserializer(ss);
+    return unserializer.Get();
+}
+
+
+static void TestBinary() {
+    ObjectMap root = _MakeTree();
+    ObjectMap loaded = _RoundTrip<BinarySerializer, BinaryUnserializer>(root, false);
+    CVAR_CHECK(cvar_test::Equal(root, loaded));
+
+    // packed lists keep their packed representation
+    const Value* pFloats = FindTreeNode(loaded, "floats");
+    CVAR_CHECK(pFloats && std::get<List>(*pFloats).GetPackedType() == Type_Float);
+
+    ObjectMap empty;
+    CVAR_CHECK((_RoundTrip<BinarySerializer, BinaryUnserializer>(empty, false).size() == 0));
+}
+
+
+static void TestMappedImage() {
+    ObjectMap root = _MakeTree();
+    {
+        std::ofstream stream("SerializerTests.bin", std::ios::binary);
+        BinarySerializer serializer(stream, root);
+        serializer.Serialize(false);
+    }
+
+    MappedConfig config;
+    if (!CVAR_CHECK(config.Open("SerializerTests.bin")))
+        return;
+
+    CVAR_CHECK(config.Find("int").GetInt() == 42);
+    CVAR_CHECK(config.Find("intMin").GetInt() == std::numeric_limits<Int>::min());
+    CVAR_CHECK(config.Find("float").GetFloat() == 0.15625f);
+    CVAR_CHECK(config.Find("true").GetBool());
+    CVAR_CHECK(config.Find("empty").GetType() == Type_String && config.Find("empty").GetString().empty());
+    CVAR_CHECK(config.Find("long").GetString() == "a string that is too long to be stored inline");
+    CVAR_CHECK(config.Find("ints").GetSpan<Int>().size() == 4);
+    CVAR_CHECK(config.Find("emptyObject").GetType() == Type_Object && config.Find("emptyObject").Size() == 0);
+    CVAR_CHECK(config.Find("wide.key299").GetInt() == 299);
+    CVAR_CHECK(config.Find("deep.next.next.level").GetInt() == 2);
+    CVAR_CHECK(!config.Find("missing"));
+    CVAR_CHECK(!config.Find("int.child"));
+
+    // materialized subtrees are equal to the serialized ones
+    CVAR_CHECK(cvar_test::Equal(config.Find("mixed").Materialize(), *FindTreeNode(root, "mixed")));
+    CVAR_CHECK(cvar_test::Equal(config.Find("wide").Materialize(), *FindTreeNode(root, "wide")));
+}
+
+
+static void TestCorruptedBinary() {
+    ObjectMap root = _MakeTree();
+    std::stringstream ss;
+    BinarySerializer serializer(ss, root);
+    serializer.Serialize(false);
+
+    // empty files are loaded as empty trees
+    std::stringstream empty;
+    BinaryUnserializer emptyUnserializer(empty);
+    CVAR_CHECK(emptyUnserializer.Get().size() == 0);
+
+    // truncated images must be rejected instead of being read past their end
+    const std::string sImage = ss.str();
+    for (size_t uLen : { size_t(4), sImage.size() / 2, sImage.size() - 1 }) {
+        {
+            std::ofstream stream("SerializerTests.truncated.bin", std::ios::binary);
+            stream.write(sImage.data(), static_cast<std::streamsize>(uLen));
+        }
+
+        MappedConfig config;
+        if (config.Open("SerializerTests.truncated.bin"))
+            CVAR_CHECK(!config.Find("wide.key299") || config.Find("wide.key299").GetInt() == 299);
+
+        bool bRejected = false;
+        try {
+            std::stringstream truncated(sImage.substr(0, uLen));
+            BinaryUnserializer unserializer(truncated);
+        }
+        catch (const UnexpectedEOFException&) {
+            bRejected = true;
+        }
+        catch (const SyntaxErrorException&) {
+            bRejected = true;
+        }
+        CVAR_CHECK(bRejected);
+    }
+}
+
+
+// levels alternate between objects and mixed lists, the deepest object holds the level count
+static Value _MakeChain(Int _iLevels) {
+    Value deepest = _MakeObject();
+    std::get<std::shared_ptr<Object>>(deepest)->GetContents()[Symbol("level")] = _iLevels;
+    for (Int i = _iLevels - 1; i >= 0; i--) {
+        if (i % 2) {
+            List list;
+            list.PushBack(i);
+            list.PushBack(std::move(deepest));
+            deepest = std::move(list);
+        }
+        else {
+            std::shared_ptr<Object> pObject = _MakeObject();
+            pObject->GetContents()[Symbol("level")] = i;
+            pObject->GetContents()[Symbol("next")] = std::move(deepest);
+            deepest = std::move(pObject);
+        }
+    }
+    return deepest;
+}
+
+
+// the next level of a chain or nullptr at its end
+static Value* _NextLevel(Value& _val) {
+    if (auto pObject = std::get_if<std::shared_ptr<Object>>(&_val)) {
+        auto it = (*pObject)->GetContents().find(Symbol("next"));
+        return it != (*pObject)->GetContents().end() ? &it->second : nullptr;
+    }
+    if (auto pList = std::get_if<List>(&_val))
+        return pList->Size() == 2 ? &pList->Back() : nullptr;
+    return nullptr;
+}
+
+
+// levels are compared one at a time, returns the number of levels that matched
+static Int _CheckChain(Value& _val) {
+    Value* pLevel = &_val;
+    for (Int i = 0; pLevel; i++) {
+        Value index;
+        if (auto pObject = std::get_if<std::shared_ptr<Object>>(pLevel)) {
+            auto it = (*pObject)->GetContents().find(Symbol("level"));
+            if (it != (*pObject)->GetContents().end())
+                index = it->second;
+        }
+        else if (auto pList = std::get_if<List>(pLevel)) {
+            if (pList->Size())
+                index = pList->At(0);
+        }
+
+        const Int* pIndex = std::get_if<Int>(&index);
+        if (!pIndex || *pIndex != i || pLevel->index() != (i % 2 ? Type_List : Type_Object))
+            return -1;
+
+        Value* pNext = _NextLevel(*pLevel);
+        if (!pNext)
+            return i;
+        pLevel = pNext;
+    }
+    return -1;
+}
+
+
+// destroying a deep chain at once would recurse once per level, thus it's released from the top
+static void _ReleaseChain(Value _val) {
+    while (Value* pNext = _NextLevel(_val)) {
+        Value next = std::move(*pNext);
+        _val = std::move(next);
+    }
+}
+
+
+static void TestDeepBinary() {
+    const Int iLevels = 50000;
+    ObjectMap root;
+    root[Symbol("chain")] = _MakeChain(iLevels);
+    {
+        std::ofstream stream("SerializerTests.deep.bin", std::ios::binary);
+        BinarySerializer serializer(stream, root);
+        serializer.Serialize(false);
+    }
+    _ReleaseChain(std::move(root[Symbol("chain")]));
+
+    // images are materialized without recursing into nested containers
+    {
+        std::ifstream stream("SerializerTests.deep.bin", std::ios::binary);
+        BinaryUnserializer unserializer(stream);
+        ObjectMap loaded = unserializer.Get();
+        CVAR_CHECK(_CheckChain(loaded[Symbol("chain")]) == iLevels);
+        _ReleaseChain(std::move(loaded[Symbol("chain")]));
+    }
+
+    MappedConfig config;
+    if (!CVAR_CHECK(config.Open("SerializerTests.deep.bin")))
+        return;
+
+    Value chain = config.Find("chain").Materialize();
+    CVAR_CHECK(_CheckChain(chain) == iLevels);
+    _ReleaseChain(std::move(chain));
+}
+
+
+static void TestMessagePack() {
+    ObjectMap root = _MakeTree();
+    ObjectMap loaded = _RoundTrip<MessagePackSerializer, MessagePackUnserializer>(root, false);
+    CVAR_CHECK(cvar_test::Equal(root, loaded));
+
+    ObjectMap empty;
+    CVAR_CHECK((_RoundTrip<MessagePackSerializer, MessagePackUnserializer>(empty, false).size() == 0));
+}
+
+
+static void TestMessagePackInput() {
+    // { "nil": nil, "big": uint64 2^32, "bin": bin8 "ab", "double": float64 0.5, "neg": int8 -3 }
+    const unsigned char arrData[] = {
+        0x85,
+        0xa3, 'n', 'i', 'l', 0xc0,
+        0xa3, 'b', 'i', 'g', 0xcf, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+        0xa3, 'b', 'i', 'n', 0xc4, 0x02, 'a', 'b',
+        0xa6, 'd', 'o', 'u', 'b', 'l', 'e', 0xcb, 0x3f, 0xe0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0xa3, 'n', 'e', 'g', 0xd0, 0xfd
+    };
+    std::stringstream ss(std::string(reinterpret_cast<const char*>(arrData), sizeof(arrData)));
+    MessagePackUnserializer unserializer(ss);
+    const ObjectMap root = unserializer.Get();
+
+    const Value* pNil = FindTreeNode(root, "nil");
+    const Value* pBig = FindTreeNode(root, "big");
+    const Value* pBin = FindTreeNode(root, "bin");
+    const Value* pDouble = FindTreeNode(root, "double");
+    const Value* pNeg = FindTreeNode(root, "neg");
+    CVAR_CHECK(!pNil);
+    CVAR_CHECK(pBig && std::holds_alternative<Float>(*pBig) && std::get<Float>(*pBig) == 4294967296.f);
+    CVAR_CHECK(pBin && std::holds_alternative<String>(*pBin) && std::get<String>(*pBin) == String("ab"));
+    CVAR_CHECK(pDouble && std::holds_alternative<Float>(*pDouble) && std::get<Float>(*pDouble) == 0.5f);
+    CVAR_CHECK(pNeg && std::holds_alternative<Int>(*pNeg) && std::get<Int>(*pNeg) == -3);
+
+    // truncated input and extension types are rejected
+    for (size_t uLen = 1; uLen < sizeof(arrData); uLen += 7) {
+        bool bRejected = false;
+        try {
+            std::stringstream truncated(std::string(reinterpret_cast<const char*>(arrData), uLen));
+            MessagePackUnserializer truncatedUnserializer(truncated);
+        }
+        catch (const UnexpectedEOFException&) {
+            bRejected = true;
+        }
+        catch (const SyntaxErrorException&) {
+            bRejected = true;
+        }
+        CVAR_CHECK(bRejected);
+    }
+
+    const unsigned char arrExtension[] = { 0x81, 0xa1, 'x', 0xd4, 0x01, 0x00 };
+    bool bRejected = false;
+    try {
+        std::stringstream extension(std::string(reinterpret_cast<const char*>(arrExtension), sizeof(arrExtension)));
+        MessagePackUnserializer extensionUnserializer(extension);
+    }
+    catch (const SyntaxErrorException&) {
+        bRejected = true;
+    }
+    CVAR_CHECK(bRejected);
+
+    // lengths far past the end of input are rejected without allocating them: a str 32 key and a bin 32 value
+    const std::string arrHuge[] = { std::string("\x81\xdb\xff\xff\xff\xfe", 6), std::string("\x81\xa1x\xc6\xff\xff\xff\xff", 8) };
+    for (const std::string& sHuge : arrHuge) {
+        bRejected = false;
+        try {
+            std::stringstream huge(sHuge);
+            MessagePackUnserializer hugeUnserializer(huge);
+        }
+        catch (const UnexpectedEOFException&) {
+            bRejected = true;
+        }
+        CVAR_CHECK(bRejected);
+    }
+}
+
+
+static void TestMessagePackNil() {
+    // { "list": [ 1, nil, 2 ], "value": nil, "object": { "nil": nil } }
+    const unsigned char arrData[] = {
+        0x83,
+        0xa4, 'l', 'i', 's', 't', 0x93, 0x01, 0xc0, 0x02,
+        0xa5, 'v', 'a', 'l', 'u', 'e', 0xc0,
+        0xa6, 'o', 'b', 'j', 'e', 'c', 't', 0x81, 0xa3, 'n', 'i', 'l', 0xc0
+    };
+    std::stringstream ss(std::string(reinterpret_cast<const char*>(arrData), sizeof(arrData)));
+    MessagePackUnserializer unserializer(ss);
+    const ObjectMap root = unserializer.Get();
+
+    // nil values are skipped the same way as null in JSON
+    const Int arrInts[] = { 1, 2 };
+    ObjectMap expected;
+    expected[Symbol("list")] = List(arrInts, 2);
+    expected[Symbol("object")] = _MakeObject();
+    CVAR_CHECK(cvar_test::Equal(root, expected));
+
+    // strings longer than a single read are read completely
+    ObjectMap text;
+    text[Symbol("long")] = String(std::string(200000, 'x') + "end");
+    CVAR_CHECK(cvar_test::Equal(_RoundTrip<MessagePackSerializer, MessagePackUnserializer>(text, false), text));
+}
+
+
+static ObjectMap _ParseYAML(const std::string& _sText) {
+    std::stringstream ss(_sText);
+    YAMLUnserializer unserializer(ss);
+    return unserializer.Get();
+}
+
+
+static bool _RejectsYAML(const std::string& _sText) {
+    try {
+        _ParseYAML(_sText);
+    }
+    catch (const SyntaxErrorException&) {
+        return true;
+    }
+    catch (const UnexpectedEOFException&) {
+        return true;
+    }
+    return false;
+}
+
+
+static void TestYAML() {
+    ObjectMap root = _MakeTree();
+    CVAR_CHECK(cvar_test::Equal(root, _RoundTrip<YAMLSerializer, YAMLUnserializer>(root, true)));
+    CVAR_CHECK(cvar_test::Equal(root, _RoundTrip<YAMLSerializer, YAMLUnserializer>(root, false)));
+
+    ObjectMap empty;
+    CVAR_CHECK((_RoundTrip<YAMLSerializer, YAMLUnserializer>(empty, true).size() == 0));
+}
+
+
+static void TestYAMLInput() {
+    const ObjectMap root = _ParseYAML(
+        "# comment\n"
+        "window:\n"
+        "  width: 1280\n"
+        "  scale: 1.5\n"
+        "  title: 'single ''quoted'''\n"
+        "  fullscreen: false\n"
+        "nulls:\n"
+        "  tilde: ~\n"
+        "  word: null\n"
+        "  empty:\n"
+        "  kept: 1\n"
+        "mixed: [1, 2.5, ~, yes]\n"
+        "ints:\n"
+        "  - 1\n"
+        "  - 0x10\n"
+        "literal: |\n"
+        "  first\n"
+        "  second\n"
+        "folded: >\n"
+        "  first\n"
+        "  second\n"
+        "infinite: .inf\n");
+
+    CVAR_CHECK(std::get<Int>(*FindTreeNode(root, "window.width")) == 1280);
+    CVAR_CHECK(std::get<Float>(*FindTreeNode(root, "window.scale")) == 1.5f);
+    CVAR_CHECK(std::get<String>(*FindTreeNode(root, "window.title")) == String("single 'quoted'"));
+    CVAR_CHECK(std::get<Bool>(*FindTreeNode(root, "window.fullscreen")) == false);
+    CVAR_CHECK(std::get<String>(*FindTreeNode(root, "literal")) == String("first\nsecond\n"));
+    CVAR_CHECK(std::get<String>(*FindTreeNode(root, "folded")) == String("first second\n"));
+    CVAR_CHECK(std::isinf(std::get<Float>(*FindTreeNode(root, "infinite"))));
+
+    // null and empty values are skipped
+    const Value* pNulls = FindTreeNode(root, "nulls");
+    CVAR_CHECK(pNulls && std::get<std::shared_ptr<Object>>(*pNulls)->GetContents().size() == 1);
+
+    // list elements keep their types, "yes" is a string in the YAML 1.2 core schema
+    const List& mixed = std::get<List>(*FindTreeNode(root, "mixed"));
+    CVAR_CHECK(mixed.Size() == 3);
+    CVAR_CHECK(!mixed.IsPacked());
+    CVAR_CHECK(std::holds_alternative<Int>(mixed.At(0)));
+    CVAR_CHECK(std::holds_alternative<Float>(mixed.At(1)));
+    CVAR_CHECK(std::get<String>(mixed.At(2)) == String("yes"));
+
+    const List& ints = std::get<List>(*FindTreeNode(root, "ints"));
+    CVAR_CHECK(ints.GetPackedType() == Type_Int);
+    CVAR_CHECK(ints.GetSpan<Int>().size() == 2 && ints.GetSpan<Int>()[1] == 16);
+
+    CVAR_CHECK(_RejectsYAML("base: &anchor 1\ncopy: *anchor\n"));
+    CVAR_CHECK(_RejectsYAML("tagged: !!str 1\n"));
+    CVAR_CHECK(_RejectsYAML("list: [1, 2\n"));
+}
+
+
+static ObjectMap _ParseJSON(const std::string& _sText) {
+    std::stringstream ss(_sText);
+    JSONUnserializer unserializer(ss);
+    return unserializer.Get();
+}
+
+
+static void TestJSON() {
+    // JSON strings are stored verbatim without processing escape sequences, thus text with bare quotes, control
+    // characters or a trailing backslash can't be written as JSON
+    ObjectMap root = _MakeTree();
+    root.erase(root.find(Symbol("escapes")));
+    root[Symbol("escaped")] = String("quote \\\" backslash \\\\ newline \\n");
+    CVAR_CHECK(cvar_test::Equal(root, _RoundTrip<JSONSerializer, JSONUnserializer>(root, true)));
+    CVAR_CHECK(cvar_test::Equal(root, _RoundTrip<JSONSerializer, JSONUnserializer>(root, false)));
+
+    ObjectMap empty;
+    CVAR_CHECK((_RoundTrip<JSONSerializer, JSONUnserializer>(empty, true).size() == 0));
+
+    // values that JSON can't represent are written as null, which is skipped when loading
+    ObjectMap special;
+    special[Symbol("infinite")] = std::numeric_limits<Float>::infinity();
+    special[Symbol("nan")] = std::numeric_limits<Float>::quiet_NaN();
+    special[Symbol("none")] = Value();
+    special[Symbol("kept")] = Int(1);
+    std::stringstream ss;
+    JSONSerializer serializer(ss, special);
+    serializer.Serialize(false);
+    const ObjectMap loaded = _ParseJSON(ss.str());
+    CVAR_CHECK(loaded.size() == 1);
+    CVAR_CHECK(FindTreeNode(loaded, "kept"));
+}
+
+
+static void TestJSONInput() {
+    const ObjectMap root = _ParseJSON(
+        "{ \"int\": -12, \"big\": 4294967296, \"exp\": 1e3, \"null\": null, \"dup\": 1, \"dup\": 2,"
+        "  \"list\": [1, null, 2], \"mixed\": [1, 2.5], \"nested\": { \"a\": [[1], [true]] },"
+        "  \"escaped\": \"a\\\"b\\\\c\\n\", \"empty\": \"\", \"emptyObject\": {}, \"emptyList\": [] }");
+
+    CVAR_CHECK(std::get<Int>(*FindTreeNode(root, "int")) == -12);
+    CVAR_CHECK(std::get<Float>(*FindTreeNode(root, "big")) == 4294967296.f);
+    CVAR_CHECK(std::get<Float>(*FindTreeNode(root, "exp")) == 1000.f);
+    CVAR_CHECK(!FindTreeNode(root, "null"));
+    CVAR_CHECK(std::get<Int>(*FindTreeNode(root, "dup")) == 2);
+    CVAR_CHECK(std::get<String>(*FindTreeNode(root, "escaped")) == String("a\\\"b\\\\c\\n"));
+    CVAR_CHECK(std::get<String>(*FindTreeNode(root, "empty")) == String(""));
+    CVAR_CHECK(std::get<std::shared_ptr<Object>>(*FindTreeNode(root, "emptyObject"))->GetContents().size() == 0);
+    CVAR_CHECK(std::get<List>(*FindTreeNode(root, "emptyList")).Size() == 0);
+
+    const List& list = std::get<List>(*FindTreeNode(root, "list"));
+    CVAR_CHECK(list.GetPackedType() == Type_Int && list.Size() == 2);
+    CVAR_CHECK(!std::get<List>(*FindTreeNode(root, "mixed")).IsPacked());
+
+    const List& nested = std::get<List>(*FindTreeNode(root, "nested.a"));
+    CVAR_CHECK(nested.Size() == 2 && std::get<List>(nested.At(1)).GetPackedType() == Type_Bool);
+
+    // single quoted strings are read by the token by token parser, results must be the same
+    const ObjectMap quoted = _ParseJSON("{ 'int': -12, \"text\": 'single', 'list': [1, 2] }");
+    CVAR_CHECK(std::get<Int>(*FindTreeNode(quoted, "int")) == -12);
+    CVAR_CHECK(std::get<List>(*FindTreeNode(quoted, "list")).GetPackedType() == Type_Int);
+}
+
+
+static void TestJSONBlockBoundaries() {
+    // escapes, quotes and operators at every position around the 64 byte blocks of the structural scanner
+    for (size_t uPadding = 0; uPadding < 140; uPadding++) {
+        const std::string sPadding(uPadding, ' ');
+        const std::string sText = "{" + sPadding + "\"k\\\\\": \"v\\\"" + std::string(uPadding % 70, 'x') + "\\\\\"," + sPadding +
+                                  "\"n\":" + sPadding + "[1," + sPadding + "2]}";
+        const ObjectMap root = _ParseJSON(sText);
+        const Value* pKey = FindTreeNode(root, "k\\\\");
+        const Value* pList = FindTreeNode(root, "n");
+        const std::string sExpected = "v\\\"" + std::string(uPadding % 70, 'x') + "\\\\";
+        if (!CVAR_CHECK(pKey && pList && std::get<String>(*pKey) == String(sExpected) && std::get<List>(*pList).Size() == 2)) {
+            std::fprintf(stderr, "padding %zu\n", uPadding);
+            break;
+        }
+    }
+}
+
+
+int main() {
+    TestBinary();
+    TestMappedImage();
+    TestCorruptedBinary();
+    TestDeepBinary();
+    TestMessagePack();
+    TestMessagePackInput();
+    TestMessagePackNil();
+    TestYAML();
+    TestYAMLInput();
+    TestJSON();
+    TestJSONInput();
+    TestJSONBlockBoundaries();
+    return cvar_test::Report("SerializerTests");
+}
@@ -0,0 +1,164 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: SnapshotTests.cpp - copy-on-write checkpoint and snapshot publication tests
+// author: Karl-Mihkel Ott
+
+#include "TestCommon.h"
+#include <cvar/CVarSystem.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace cvar;
+
+static const Object* _GetObject(const Value* _pValue) {
+    const std::shared_ptr<Object>* ppObject = _pValue ? std::get_if<std::shared_ptr<Object>>(_pValue) : nullptr;
+    return ppObject ? ppObject->get() : nullptr;
+}
+
+
+static void TestCheckpoint() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    cvarSyst.Set<Int>("render.width", 1280);
+    cvarSyst.Set<String>("render.title", String("first"));
+    cvarSyst.Set<Float>("audio.volume", 0.5f);
+
+    Snapshot checkpoint = cvarSyst.TakeSnapshot();
+    cvarSyst.Set<Int>("render.width", 1920);
+    cvarSyst.Set<String>("render.title", String("second"));
+    cvarSyst.Set<Bool>("render.vsync", true);
+
+    CVarBatch batch;
+    batch.Set<Int>("net.port", 27015);
+    CVAR_CHECK(cvarSyst.Apply(std::move(batch)));
+
+    CVarHandle<Float> volume = cvarSyst.Resolve<Float>("audio.volume");
+    CVAR_CHECK(volume.Set(1.0f));
+
+    // the checkpoint still holds every value as it was when it was taken
+    CVAR_CHECK(*checkpoint.Get<Int>("render.width") == 1280);
+    CVAR_CHECK(*checkpoint.Get<String>("render.title") == String("first"));
+    CVAR_CHECK(*checkpoint.Get<Float>("audio.volume") == 0.5f);
+    CVAR_CHECK(!checkpoint.GetValue("render.vsync"));
+    CVAR_CHECK(!checkpoint.GetValue("net.port"));
+
+    CVAR_CHECK(*cvarSyst.Get<Int>("render.width") == 1920);
+    CVAR_CHECK(*cvarSyst.Get<Float>("audio.volume") == 1.0f);
+
+    cvarSyst.Restore(checkpoint);
+    CVAR_CHECK(*cvarSyst.Get<Int>("render.width") == 1280);
+    CVAR_CHECK(*cvarSyst.Get<String>("render.title") == String("first"));
+    CVAR_CHECK(!cvarSyst.GetValue("render.vsync"));
+    CVAR_CHECK(!cvarSyst.GetValue("net.port"));
+    CVAR_CHECK(*volume.Get() == 0.5f);
+
+    // writes after the restore must not leak into the checkpoint either
+    cvarSyst.Set<Int>("render.width", 640);
+    CVAR_CHECK(volume.Set(0.25f));
+    CVAR_CHECK(*checkpoint.Get<Int>("render.width") == 1280);
+    CVAR_CHECK(*checkpoint.Get<Float>("audio.volume") == 0.5f);
+}
+
+
+static void TestStructuralSharing() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    cvarSyst.Set<Int>("shared.left.value", 1);
+    cvarSyst.Set<Int>("shared.right.value", 2);
+
+    Snapshot checkpoint = cvarSyst.TakeSnapshot();
+    cvarSyst.Set<Int>("shared.left.value", 3);
+
+    // only objects on the path to the written node are copied
+    CVAR_CHECK(_GetObject(checkpoint.GetValue("shared.right")) == _GetObject(cvarSyst.GetValue("shared.right")));
+    CVAR_CHECK(_GetObject(checkpoint.GetValue("shared.left")) != _GetObject(cvarSyst.GetValue("shared.left")));
+    CVAR_CHECK(_GetObject(checkpoint.GetValue("shared")) != _GetObject(cvarSyst.GetValue("shared")));
+    CVAR_CHECK(*checkpoint.Get<Int>("shared.left.value") == 1);
+
+    // once the checkpoint is gone the live tree is written in place again
+    checkpoint = Snapshot();
+    const Object* pLeft = _GetObject(cvarSyst.GetValue("shared.left"));
+    cvarSyst.Set<Int>("shared.left.value", 4);
+    CVAR_CHECK(_GetObject(cvarSyst.GetValue("shared.left")) == pLeft);
+}
+
+
+static void TestPublishing() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    CVAR_CHECK(!cvarSyst.AcquireSnapshot() || cvarSyst.IsPublishingSnapshots());
+
+    cvarSyst.SetSnapshotPublishing(true);
+    cvarSyst.Set<Int>("pub.value", 1);
+    Snapshot first = cvarSyst.AcquireSnapshot();
+    const uint64_t uFirstVersion = cvarSyst.GetPublishedVersion();
+    CVAR_CHECK(first && *first.Get<Int>("pub.value") == 1);
+
+    cvarSyst.Set<Int>("pub.value", 2);
+    Snapshot second = cvarSyst.AcquireSnapshot();
+    CVAR_CHECK(cvarSyst.GetPublishedVersion() > uFirstVersion);
+    CVAR_CHECK(*first.Get<Int>("pub.value") == 1);
+    CVAR_CHECK(*second.Get<Int>("pub.value") == 2);
+
+    // SnapshotReader only reacquires the snapshot when a newer version has been published
+    SnapshotReader reader(cvarSyst);
+    const Object* pRoot = reader->GetRootObject().get();
+    CVAR_CHECK(reader->GetRootObject().get() == pRoot);
+    cvarSyst.Set<Int>("pub.value", 3);
+    CVAR_CHECK(reader->GetRootObject().get() != pRoot);
+    CVAR_CHECK(*reader->Get<Int>("pub.value") == 3);
+}
+
+
+static void TestConcurrentReaders() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    CVarBatch initial;
+    initial.Set<Int>("pair.first", 0);
+    initial.Set<Int>("pair.second", 0);
+    cvarSyst.Apply(std::move(initial));
+
+    // both values are written as one batch, thus every published snapshot must hold an equal pair
+    std::atomic<bool> bDone{false};
+    std::atomic<int> iMismatches{0};
+    std::atomic<int> iRegressions{0};
+    auto reader = [&]() {
+        SnapshotReader snapshots(cvarSyst);
+        Int iLast = 0;
+        while (!bDone.load(std::memory_order_acquire)) {
+            // both values are read from the same snapshot, since reacquiring it might release the old tree
+            const Snapshot& snapshot = snapshots.Get();
+            const Int* pFirst = snapshot.Get<Int>("pair.first");
+            const Int* pSecond = snapshot.Get<Int>("pair.second");
+            if (!pFirst || !pSecond || *pFirst != *pSecond)
+                iMismatches++;
+            else if (*pFirst < iLast)
+                iRegressions++;
+            else iLast = *pFirst;
+        }
+    };
+
+    std::thread firstReader(reader);
+    std::thread secondReader(reader);
+    for (Int i = 1; i <= 2000; i++) {
+        CVarBatch batch;
+        batch.Set<Int>("pair.first", i);
+        batch.Set<Int>("pair.second", i);
+        cvarSyst.Apply(std::move(batch));
+    }
+    bDone.store(true, std::memory_order_release);
+    firstReader.join();
+    secondReader.join();
+
+    CVAR_CHECK(iMismatches.load() == 0);
+    CVAR_CHECK(iRegressions.load() == 0);
+    CVAR_CHECK(*cvarSyst.AcquireSnapshot().Get<Int>("pair.first") == 2000);
+    cvarSyst.SetSnapshotPublishing(false);
+}
+
+
+int main() {
+    TestCheckpoint();
+    TestStructuralSharing();
+    TestPublishing();
+    TestConcurrentReaders();
+    return cvar_test::Report("SnapshotTests");
+}
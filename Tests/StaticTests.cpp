@@ -0,0 +1,182 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: StaticTests.cpp - statically defined variable tests
+// author: Karl-Mihkel Ott
+
+#include "TestCommon.h"
+#include <cvar/CVarSystem.h>
+#include <cvar/JSONUnserializer.h>
+#include <fstream>
+#include <limits>
+#include <string>
+
+using namespace cvar;
+
+CVAR_DEFINE(g_gamma, Float, "static.render.gamma", 2.2f, 1.0f, 3.0f);
+CVAR_DEFINE(g_samples, Int, "static.render.samples", 64, 1, 16);
+CVAR_DEFINE(g_count, Int, "static.render.count", 0);
+CVAR_DEFINE(g_vsync, Bool, "static.render.vsync", true);
+CVAR_DEFINE(g_title, String, "static.window.title", String("cvar"));
+
+static void TestDefaults() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+
+    // defaults are clamped to the range and inserted into the tree during static initialization
+    CVAR_CHECK(g_gamma.Get() == 2.2f && g_gamma.IsRanged() && g_gamma.IsRegistered());
+    CVAR_CHECK(g_samples.Get() == 16 && g_samples.GetDefault() == 16);
+    CVAR_CHECK(*cvarSyst.Get<Float>("static.render.gamma") == 2.2f);
+    CVAR_CHECK(*cvarSyst.Get<Int>("static.render.samples") == 16);
+    CVAR_CHECK(*cvarSyst.Get<Bool>("static.render.vsync"));
+    CVAR_CHECK(*cvarSyst.Get<String>("static.window.title") == String("cvar"));
+}
+
+
+static void TestClamping() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+
+    // values set on the variable are clamped and written to the tree
+    CVAR_CHECK(g_gamma.Set(5.0f));
+    CVAR_CHECK(g_gamma.Get() == 3.0f);
+    CVAR_CHECK(*cvarSyst.Get<Float>("static.render.gamma") == 3.0f);
+
+    // tree writes are clamped as well and the clamped value is what the tree keeps
+    CVAR_CHECK(cvarSyst.Set<Float>("static.render.gamma", 0.5f));
+    CVAR_CHECK(g_gamma.Get() == 1.0f);
+    CVAR_CHECK(*cvarSyst.Get<Float>("static.render.gamma") == 1.0f);
+    cvarSyst.Set<Int>("static.render.samples", -4);
+    CVAR_CHECK(g_samples.Get() == 1);
+
+    CVAR_CHECK(g_gamma.Reset());
+    CVAR_CHECK(g_gamma.Get() == 2.2f);
+}
+
+
+static void TestConversion() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+
+    // numbers of the other numeric type are converted to the declared one
+    cvarSyst.Set<Int>("static.render.gamma", 2);
+    CVAR_CHECK(g_gamma.Get() == 2.0f);
+    CVAR_CHECK(cvarSyst.Get<Float>("static.render.gamma") && *cvarSyst.Get<Float>("static.render.gamma") == 2.0f);
+
+    cvarSyst.Set<Float>("static.render.count", 7.9f);
+    CVAR_CHECK(g_count.Get() == 7);
+    CVAR_CHECK(cvarSyst.Get<Int>("static.render.count") && *cvarSyst.Get<Int>("static.render.count") == 7);
+
+    // Float values outside of the Int range saturate
+    cvarSyst.Set<Float>("static.render.count", 1e30f);
+    CVAR_CHECK(g_count.Get() == std::numeric_limits<Int>::max());
+    cvarSyst.Set<Float>("static.render.count", -1e30f);
+    CVAR_CHECK(g_count.Get() == std::numeric_limits<Int>::min());
+    cvarSyst.Set<Float>("static.render.samples", 1e30f);
+    CVAR_CHECK(g_samples.Get() == 16);
+
+    // values of unrelated types are replaced with the current value
+    cvarSyst.Set<String>("static.render.count", String("many"));
+    CVAR_CHECK(g_count.Get() == std::numeric_limits<Int>::min());
+    CVAR_CHECK(cvarSyst.Get<Int>("static.render.count") && *cvarSyst.Get<Int>("static.render.count") == g_count.Get());
+    cvarSyst.Set<Int>("static.render.vsync", 0);
+    CVAR_CHECK(g_vsync.Get() && *cvarSyst.Get<Bool>("static.render.vsync"));
+}
+
+
+static void TestNaN() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    const Float fNaN = std::numeric_limits<Float>::quiet_NaN();
+
+    // NaN is neither within a range nor representable as Int, the previous value is kept
+    g_gamma.Set(1.5f);
+    cvarSyst.Set<Float>("static.render.gamma", fNaN);
+    CVAR_CHECK(g_gamma.Get() == 1.5f);
+    CVAR_CHECK(*cvarSyst.Get<Float>("static.render.gamma") == 1.5f);
+    g_gamma.Set(fNaN);
+    CVAR_CHECK(g_gamma.Get() == 1.5f);
+
+    g_count.Set(3);
+    cvarSyst.Set<Float>("static.render.count", fNaN);
+    CVAR_CHECK(g_count.Get() == 3);
+    CVAR_CHECK(*cvarSyst.Get<Int>("static.render.count") == 3);
+}
+
+
+static void TestReload() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    {
+        std::ofstream stream("StaticTests.json");
+        stream << "{ \"static\": { \"render\": { \"gamma\": 9.5, \"samples\": 8.0, \"vsync\": false } } }";
+    }
+
+    // loaded values are written through and clamped, variables missing from the file keep their value
+    g_title.Set(String("loaded"));
+    cvarSyst.Unserialize<JSONUnserializer>("StaticTests.json");
+    CVAR_CHECK(g_gamma.Get() == 3.0f && *cvarSyst.Get<Float>("static.render.gamma") == 3.0f);
+    CVAR_CHECK(g_samples.Get() == 8 && *cvarSyst.Get<Int>("static.render.samples") == 8);
+    CVAR_CHECK(!g_vsync.Get());
+    CVAR_CHECK(g_title.Get() == String("loaded"));
+    CVAR_CHECK(cvarSyst.Get<String>("static.window.title") && *cvarSyst.Get<String>("static.window.title") == String("loaded"));
+
+    // restoring a snapshot writes the restored values through
+    Snapshot checkpoint = cvarSyst.TakeSnapshot();
+    g_gamma.Set(1.25f);
+    cvarSyst.Set<Int>("static.render.samples", 2);
+    cvarSyst.Set<Int>("static.render", 1);
+    CVAR_CHECK(g_samples.Get() == 2);
+    cvarSyst.Restore(checkpoint);
+    CVAR_CHECK(g_gamma.Get() == 3.0f);
+    CVAR_CHECK(g_samples.Get() == 8);
+    CVAR_CHECK(*cvarSyst.Get<Int>("static.render.samples") == 8);
+}
+
+
+static void TestDuplicates() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+
+    // a second definition of the same key doesn't take over the variable
+    {
+        StaticCVar<Int> duplicate("static.render.samples", 4, 0, 100);
+        CVAR_CHECK(!duplicate.IsRegistered());
+        CVAR_CHECK(!duplicate.Set(50));
+        CVAR_CHECK(g_samples.Get() == 8);
+        cvarSyst.Set<Int>("static.render.samples", 12);
+        CVAR_CHECK(g_samples.Get() == 12);
+        CVAR_CHECK(duplicate.Get() == 50);
+    }
+
+    // destroying the rejected duplicate leaves the original registered
+    cvarSyst.Set<Int>("static.render.samples", 10);
+    CVAR_CHECK(g_samples.Get() == 10);
+
+    // variables with colliding keys are independent of each other
+    const auto [sFirst, sSecond] = cvar_test::FindCollision();
+    if (!CVAR_CHECK(!sFirst.empty()))
+        return;
+
+    const std::string sFirstKey = "static." + sFirst;
+    const std::string sSecondKey = "static." + sSecond;
+    {
+        StaticCVar<Int> first(sFirstKey.c_str(), 1);
+        StaticCVar<Int> second(sSecondKey.c_str(), 2);
+        CVAR_CHECK(first.IsRegistered() && second.IsRegistered());
+        cvarSyst.Set<Int>(sSecondKey, 20);
+        CVAR_CHECK(first.Get() == 1 && second.Get() == 20);
+        cvarSyst.Set<Int>(sFirstKey, 10);
+        CVAR_CHECK(first.Get() == 10 && second.Get() == 20);
+    }
+
+    // destroyed variables are no longer written through
+    cvarSyst.Set<Int>(sFirstKey, 30);
+    cvarSyst.Set<Int>(sSecondKey, 40);
+    StaticCVar<Int> redefined(sFirstKey.c_str(), 0);
+    CVAR_CHECK(redefined.IsRegistered() && redefined.Get() == 30);
+}
+
+
+int main() {
+    TestDefaults();
+    TestClamping();
+    TestConversion();
+    TestNaN();
+    TestReload();
+    TestDuplicates();
+    return cvar_test::Report("StaticTests");
+}
@@ -0,0 +1,163 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: StatsTests.cpp - tree statistics tests
+// author: Karl-Mihkel Ott
+
+#include "TestCommon.h"
+#include <cvar/CVarSystem.h>
+#include <cvar/JSONUnserializer.h>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace cvar;
+
+static void _Load() {
+    {
+        std::ofstream stream("StatsTests.json");
+        stream << "{ \"stats\": {"
+                  "  \"small\": { \"a\": 1 },"
+                  "  \"big\": { \"s\": \"a string value that is long enough to need a block of its own\", \"n\": 1.5,"
+                  "             \"inner\": { \"flag\": true, \"v\": 2 } },"
+                  "  \"holder\": { \"items\": [ { \"k\": 1, \"deep\": { \"z\": true } }, 2 ], \"tag\": 3 },"
+                  "  \"after\": { \"b\": false }"
+                  "} }";
+    }
+
+    CVarSystem::GetInstance().Unserialize<JSONUnserializer>("StatsTests.json");
+}
+
+
+static void TestNodeCounts() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    const TreeStats stats = cvarSyst.Stats("stats");
+    CVAR_CHECK(!stats.bSampled);
+
+    // entries of objects stored in lists are counted, the list elements themselves are not
+    CVAR_CHECK(stats.arrNodeCounts[Type_Object] == 6);
+    CVAR_CHECK(stats.arrNodeCounts[Type_List] == 1);
+    CVAR_CHECK(stats.arrNodeCounts[Type_Int] == 4);
+    CVAR_CHECK(stats.arrNodeCounts[Type_Float] == 1);
+    CVAR_CHECK(stats.arrNodeCounts[Type_Bool] == 3);
+    CVAR_CHECK(stats.arrNodeCounts[Type_String] == 1);
+    CVAR_CHECK(stats.GetNodeCount() == 16);
+
+    // children of the prefix have depth 1, objects in lists are one level below the list
+    CVAR_CHECK(stats.uMaxDepth == 4);
+    CVAR_CHECK(stats.uStringBytes > 0 && stats.uListBytes > 0 && stats.uMapBytes > 0 && stats.uKeyBytes > 0);
+    CVAR_CHECK(stats.GetTotalBytes() == stats.uKeyBytes + stats.uStringBytes + stats.uListBytes + stats.uMapBytes);
+
+    // the whole tree has the prefix object on top
+    const TreeStats whole = cvarSyst.Stats();
+    CVAR_CHECK(whole.arrNodeCounts[Type_Object] == 7);
+    CVAR_CHECK(whole.uMaxDepth == 5);
+    CVAR_CHECK(whole.GetTotalBytes() > stats.GetTotalBytes());
+
+    // scalar prefixes count themselves, missing prefixes count nothing
+    const TreeStats leaf = cvarSyst.Stats("stats.big.s");
+    CVAR_CHECK(leaf.GetNodeCount() == 1 && leaf.arrNodeCounts[Type_String] == 1 && leaf.uMaxDepth == 0);
+    CVAR_CHECK(leaf.uStringBytes > 0);
+    CVAR_CHECK(cvarSyst.Stats("stats.missing").GetNodeCount() == 0);
+}
+
+
+static void TestLargestSubtrees() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    const TreeStats stats = cvarSyst.Stats("stats");
+
+    // named objects are reported by their full path, objects stored in lists are part of the list owner
+    const std::vector<SubtreeStats>& largest = stats.largestSubtrees;
+    CVAR_CHECK(largest.size() == 5);
+    for (size_t i = 1; i < largest.size(); i++)
+        CVAR_CHECK(largest[i - 1].uBytes >= largest[i].uBytes);
+
+    size_t uFound = 0;
+    for (const SubtreeStats& subtree : largest) {
+        if (subtree.sPath == "stats.big") {
+            CVAR_CHECK(subtree.uNodes == 5);
+            uFound++;
+        }
+        else if (subtree.sPath == "stats.big.inner") {
+            CVAR_CHECK(subtree.uNodes == 2);
+            uFound++;
+        }
+        else if (subtree.sPath == "stats.holder") {
+            CVAR_CHECK(subtree.uNodes == 5);
+            uFound++;
+        }
+        else if (subtree.sPath == "stats.small" || subtree.sPath == "stats.after") {
+            CVAR_CHECK(subtree.uNodes == 1);
+            uFound++;
+        }
+    }
+    CVAR_CHECK(uFound == 5);
+
+    // a subtree is never larger than the object containing it
+    auto itBig = std::find_if(largest.begin(), largest.end(), [](const SubtreeStats& _subtree) { return _subtree.sPath == "stats.big"; });
+    auto itInner = std::find_if(largest.begin(), largest.end(), [](const SubtreeStats& _subtree) { return _subtree.sPath == "stats.big.inner"; });
+    CVAR_CHECK(itBig < itInner);
+
+    // the report is limited to the requested number of the largest subtrees
+    StatsOptions options;
+    options.uLargestCount = 2;
+    const TreeStats limited = cvarSyst.Stats("stats", options);
+    CVAR_CHECK(limited.largestSubtrees.size() == 2);
+    CVAR_CHECK(limited.largestSubtrees[0].sPath == largest[0].sPath);
+    CVAR_CHECK(limited.largestSubtrees[1].sPath == largest[1].sPath);
+
+    options.uLargestCount = 0;
+    CVAR_CHECK(cvarSyst.Stats("stats", options).largestSubtrees.empty());
+}
+
+
+static void TestSampling() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+
+    // a uniform tree is extrapolated exactly from any sample
+    for (int i = 0; i < 500; i++) {
+        const std::string sObject = "wide.o" + std::to_string(i);
+        cvarSyst.Set<Int>(sObject + ".a", i);
+        cvarSyst.Set<Int>(sObject + ".b", i);
+        cvarSyst.Set<Float>(sObject + ".c", 0.5f);
+        cvarSyst.Set<Bool>(sObject + ".d", true);
+    }
+
+    const TreeStats full = cvarSyst.Stats("wide");
+    CVAR_CHECK(full.arrNodeCounts[Type_Object] == 500 && full.arrNodeCounts[Type_Int] == 1000);
+    for (size_t uSeed = 0; uSeed < 3; uSeed++) {
+        StatsOptions options;
+        options.uSampleInterval = 10;
+        options.uSampleSeed = uSeed;
+        const TreeStats sampled = cvarSyst.Stats("wide", options);
+        CVAR_CHECK(sampled.bSampled);
+        CVAR_CHECK(sampled.arrNodeCounts[Type_Object] == 500);
+        CVAR_CHECK(sampled.GetNodeCount() == full.GetNodeCount());
+        CVAR_CHECK(sampled.uMapBytes == full.uMapBytes);
+        CVAR_CHECK(sampled.uMaxDepth == 2);
+    }
+
+    // object sizes that don't divide by the interval are estimated closely
+    for (int i = 0; i < 233; i++)
+        cvarSyst.Set<String>("wide.o7.s" + std::to_string(i), String("value that is stored out of line " + std::to_string(i)));
+
+    const TreeStats uneven = cvarSyst.Stats("wide");
+    StatsOptions options;
+    options.uSampleInterval = 7;
+    options.uSampleSeed = 3;
+    const TreeStats estimate = cvarSyst.Stats("wide", options);
+    const long long iNodes = static_cast<long long>(uneven.GetNodeCount());
+    CVAR_CHECK(std::llabs(static_cast<long long>(estimate.GetNodeCount()) - iNodes) < iNodes / 10);
+    const long long iBytes = static_cast<long long>(uneven.GetTotalBytes());
+    CVAR_CHECK(std::llabs(static_cast<long long>(estimate.GetTotalBytes()) - iBytes) < iBytes / 4);
+}
+
+
+int main() {
+    _Load();
+    TestNodeCounts();
+    TestLargestSubtrees();
+    TestSampling();
+    return cvar_test::Report("StatsTests");
+}
@@ -0,0 +1,248 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: SubscriptionTests.cpp - immediate and deferred change notification tests
+// author: Karl-Mihkel Ott
+
+#include "TestCommon.h"
+#include <cvar/CVarSystem.h>
+#include <cvar/JSONUnserializer.h>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace cvar;
+
+static void TestImmediate() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    std::vector<std::string> keys;
+    Int iLast = 0;
+    const SubscriptionId uId = cvarSyst.Subscribe("notify.video.width", [&](const std::string& _sKey, const Value* _pValue) {
+        keys.push_back(_sKey);
+        if (_pValue && std::holds_alternative<Int>(*_pValue))
+            iLast = std::get<Int>(*_pValue);
+    });
+
+    cvarSyst.Set<Int>("notify.video.width", 1280);
+    cvarSyst.Set<Int>("notify.video.width", 1920);
+    cvarSyst.Set<Int>("notify.video.height", 1080);
+    CVAR_CHECK(keys.size() == 2);
+    CVAR_CHECK(iLast == 1920);
+
+    // keys that only share the beginning of a segment aren't under the subscribed path
+    cvarSyst.Set<Int>("notify.video.widthScale", 2);
+    CVAR_CHECK(keys.size() == 2);
+
+    cvarSyst.Unsubscribe(uId);
+    cvarSyst.Set<Int>("notify.video.width", 800);
+    CVAR_CHECK(keys.size() == 2);
+}
+
+
+static void TestPrefix() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    std::vector<std::string> prefixKeys;
+    std::vector<std::string> allKeys;
+    const SubscriptionId uPrefix = cvarSyst.Subscribe("notify.audio", [&](const std::string& _sKey, const Value*) {
+        prefixKeys.push_back(_sKey);
+    });
+    const SubscriptionId uAll = cvarSyst.Subscribe("", [&](const std::string& _sKey, const Value*) {
+        allKeys.push_back(_sKey);
+    });
+
+    cvarSyst.Set<Float>("notify.audio.volume", 0.5f);
+    cvarSyst.Set<Bool>("notify.audio.output.muted", true);
+    cvarSyst.Set<Int>("notify.audiobook", 1);
+    cvarSyst.Set<Int>("notify.other", 1);
+    CVAR_CHECK(prefixKeys == std::vector<std::string>({ "notify.audio.volume", "notify.audio.output.muted" }));
+    CVAR_CHECK(allKeys.size() == 4);
+
+    // every key of a batch is delivered after all of them have been written
+    CVarBatch batch;
+    batch.Set<Float>("notify.audio.volume", 0.25f);
+    batch.Set<Float>("notify.audio.pitch", 1.5f);
+    bool bConsistent = true;
+    const SubscriptionId uBatch = cvarSyst.Subscribe("notify.audio.volume", [&](const std::string&, const Value*) {
+        const Float* pPitch = cvarSyst.Get<Float>("notify.audio.pitch");
+        bConsistent = pPitch && *pPitch == 1.5f;
+    });
+    CVAR_CHECK(cvarSyst.Apply(std::move(batch)));
+    CVAR_CHECK(bConsistent);
+    CVAR_CHECK(prefixKeys.size() == 4);
+
+    cvarSyst.Unsubscribe(uBatch);
+    cvarSyst.Unsubscribe(uPrefix);
+    cvarSyst.Unsubscribe(uAll);
+}
+
+
+static void TestDeferred() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    std::vector<std::string> keys;
+    Int iValue = 0;
+    const SubscriptionId uId = cvarSyst.Subscribe("notify.deferred", [&](const std::string& _sKey, const Value* _pValue) {
+        keys.push_back(_sKey);
+        if (_sKey == "notify.deferred.count" && _pValue)
+            iValue = std::get<Int>(*_pValue);
+    }, NotifyMode::Deferred);
+
+    // changes of the same key are coalesced, the callback sees the latest value
+    cvarSyst.Set<Int>("notify.deferred.count", 1);
+    cvarSyst.Set<Int>("notify.deferred.count", 2);
+    cvarSyst.Set<Int>("notify.deferred.count", 3);
+    cvarSyst.Set<Bool>("notify.deferred.flag", true);
+    CVAR_CHECK(keys.empty());
+
+    cvarSyst.DispatchNotifications();
+    std::sort(keys.begin(), keys.end());
+    CVAR_CHECK(keys == std::vector<std::string>({ "notify.deferred.count", "notify.deferred.flag" }));
+    CVAR_CHECK(iValue == 3);
+
+    // nothing is delivered twice
+    keys.clear();
+    cvarSyst.DispatchNotifications();
+    CVAR_CHECK(keys.empty());
+
+    // changes made by deferred callbacks are delivered by the next dispatch
+    const SubscriptionId uWriter = cvarSyst.Subscribe("notify.deferred.count", [&](const std::string&, const Value*) {
+        cvarSyst.Set<Bool>("notify.deferred.flag", false);
+    }, NotifyMode::Deferred);
+    cvarSyst.Set<Int>("notify.deferred.count", 4);
+    cvarSyst.DispatchNotifications();
+    CVAR_CHECK(std::count(keys.begin(), keys.end(), "notify.deferred.flag") == 0);
+    cvarSyst.DispatchNotifications();
+    CVAR_CHECK(std::count(keys.begin(), keys.end(), "notify.deferred.flag") == 1);
+
+    cvarSyst.Unsubscribe(uWriter);
+    cvarSyst.Unsubscribe(uId);
+}
+
+
+static void TestUnsubscribeInCallback() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    int iSelfCalls = 0;
+    int iOtherCalls = 0;
+    SubscriptionId uSelf = 0;
+    SubscriptionId uOther = 0;
+
+    // the first callback removes itself and the subscription after it, which must not be called anymore
+    uSelf = cvarSyst.Subscribe("notify.unsubscribe", [&](const std::string&, const Value*) {
+        iSelfCalls++;
+        cvarSyst.Unsubscribe(uSelf);
+        cvarSyst.Unsubscribe(uOther);
+    });
+    uOther = cvarSyst.Subscribe("notify.unsubscribe", [&](const std::string&, const Value*) {
+        iOtherCalls++;
+    });
+
+    cvarSyst.Set<Int>("notify.unsubscribe", 1);
+    cvarSyst.Set<Int>("notify.unsubscribe", 2);
+    CVAR_CHECK(iSelfCalls == 1);
+    CVAR_CHECK(iOtherCalls == 0);
+
+    // subscriptions made from a callback only see later changes
+    int iLateCalls = 0;
+    SubscriptionId uLate = 0;
+    const SubscriptionId uSubscriber = cvarSyst.Subscribe("notify.late", [&](const std::string&, const Value*) {
+        if (!uLate) {
+            uLate = cvarSyst.Subscribe("notify.late", [&](const std::string&, const Value*) {
+                iLateCalls++;
+            });
+        }
+    });
+    cvarSyst.Set<Int>("notify.late", 1);
+    CVAR_CHECK(iLateCalls == 0);
+    cvarSyst.Set<Int>("notify.late", 2);
+    CVAR_CHECK(iLateCalls == 1);
+
+    cvarSyst.Unsubscribe(uSubscriber);
+    cvarSyst.Unsubscribe(uLate);
+}
+
+
+static void TestReload() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    {
+        std::ofstream stream("SubscriptionTests.json");
+        stream << "{ \"notify\": { \"reload\": { \"a\": 1 } } }";
+    }
+
+    std::vector<std::string> immediateKeys;
+    const Value* pReloaded = nullptr;
+    const SubscriptionId uImmediate = cvarSyst.Subscribe("notify.reload", [&](const std::string& _sKey, const Value* _pValue) {
+        immediateKeys.push_back(_sKey);
+        pReloaded = _pValue;
+    });
+    std::vector<std::string> deferredKeys;
+    const SubscriptionId uDeferred = cvarSyst.Subscribe("notify.reload.a", [&](const std::string& _sKey, const Value*) {
+        deferredKeys.push_back(_sKey);
+    }, NotifyMode::Deferred);
+
+    // a loaded tree notifies every subscription about its own path
+    cvarSyst.Unserialize<JSONUnserializer>("SubscriptionTests.json");
+    CVAR_CHECK(immediateKeys == std::vector<std::string>({ "notify.reload" }));
+    CVAR_CHECK(pReloaded && std::holds_alternative<std::shared_ptr<Object>>(*pReloaded));
+    CVAR_CHECK(deferredKeys.empty());
+    cvarSyst.DispatchNotifications();
+    CVAR_CHECK(deferredKeys == std::vector<std::string>({ "notify.reload.a" }));
+
+    immediateKeys.clear();
+    Snapshot checkpoint = cvarSyst.TakeSnapshot();
+    cvarSyst.Set<Int>("notify.reload.a", 2);
+    cvarSyst.Restore(checkpoint);
+    CVAR_CHECK(immediateKeys.size() == 2);
+    CVAR_CHECK(*cvarSyst.Get<Int>("notify.reload.a") == 1);
+    deferredKeys.clear();
+    cvarSyst.DispatchNotifications();
+    CVAR_CHECK(deferredKeys == std::vector<std::string>({ "notify.reload.a" }));
+
+    cvarSyst.Unsubscribe(uImmediate);
+    cvarSyst.Unsubscribe(uDeferred);
+}
+
+
+static void TestCollidingPaths() {
+    const auto [sFirst, sSecond] = cvar_test::FindCollision();
+    if (!CVAR_CHECK(!sFirst.empty()))
+        return;
+
+    const std::string sFirstPath = "notify." + sFirst;
+    const std::string sSecondPath = "notify." + sSecond;
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+
+    // a subscription must not fire for a path that merely has the same hash
+    std::vector<std::string> keys;
+    const SubscriptionId uImmediate = cvarSyst.Subscribe(sFirstPath, [&](const std::string& _sKey, const Value*) {
+        keys.push_back(_sKey);
+    });
+    cvarSyst.Set<Int>(sSecondPath, 1);
+    CVAR_CHECK(keys.empty());
+    cvarSyst.Set<Int>(sFirstPath, 1);
+    CVAR_CHECK(keys == std::vector<std::string>({ sFirstPath }));
+    cvarSyst.Unsubscribe(uImmediate);
+
+    // pending changes of colliding keys are both delivered
+    keys.clear();
+    const SubscriptionId uDeferred = cvarSyst.Subscribe("notify", [&](const std::string& _sKey, const Value*) {
+        keys.push_back(_sKey);
+    }, NotifyMode::Deferred);
+    cvarSyst.Set<Int>(sFirstPath, 2);
+    cvarSyst.Set<Int>(sSecondPath, 2);
+    cvarSyst.DispatchNotifications();
+    std::sort(keys.begin(), keys.end());
+    std::vector<std::string> expected = { sFirstPath, sSecondPath };
+    std::sort(expected.begin(), expected.end());
+    CVAR_CHECK(keys == expected);
+    cvarSyst.Unsubscribe(uDeferred);
+}
+
+
+int main() {
+    TestImmediate();
+    TestPrefix();
+    TestDeferred();
+    TestUnsubscribeInCallback();
+    TestReload();
+    TestCollidingPaths();
+    return cvar_test::Report("SubscriptionTests");
+}
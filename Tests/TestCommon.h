@@ -0,0 +1,140 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: TestCommon.h - check macros and value comparison shared by unit tests
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cvar/CVarTypes.h>
+#include <bitset>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace cvar_test {
+
+    inline int& GetFailureCount() {
+        static int iFailures = 0;
+        return iFailures;
+    }
+
+    inline bool Check(bool _bCondition, const char* _szExpression, const char* _szFile, int _iLine) {
+        if (!_bCondition) {
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", _szFile, _iLine, _szExpression);
+            GetFailureCount()++;
+        }
+        return _bCondition;
+    }
+
+    // exit code of the test executable
+    inline int Report(const char* _szName) {
+        if (GetFailureCount())
+            std::fprintf(stderr, "%s: %d check(s) failed\n", _szName, GetFailureCount());
+        else std::printf("%s: all checks passed\n", _szName);
+        return GetFailureCount() ? 1 : 0;
+    }
+
+    // Two different strings of the same length whose RUNTIME_CRC values are equal. CRC of equal length messages is
+    // affine over GF(2), thus differences caused by single bit flips are eliminated until some combination of flips
+    // cancels out.
+    inline std::pair<std::string, std::string> FindCollision() {
+        const std::string sBase(16, '@');
+        const uint64_t uBaseHash = static_cast<uint64_t>(RUNTIME_CRC(sBase));
+
+        // basis indexed by the highest set bit, every row remembers the flips it consists of
+        uint64_t arrRows[64] = {};
+        std::bitset<96> arrFlips[64];
+        for (size_t i = 0; i < 96; i++) {
+            std::string sFlipped = sBase;
+            sFlipped[i / 6] ^= static_cast<char>(1 << (i % 6));
+            uint64_t uDiff = static_cast<uint64_t>(RUNTIME_CRC(sFlipped)) ^ uBaseHash;
+            std::bitset<96> flips;
+            flips.set(i);
+
+            for (int iBit = 63; iBit >= 0 && uDiff; iBit--) {
+                if (!((uDiff >> iBit) & 1))
+                    continue;
+
+                if (!arrRows[iBit]) {
+                    arrRows[iBit] = uDiff;
+                    arrFlips[iBit] = flips;
+                    break;
+                }
+                uDiff ^= arrRows[iBit];
+                flips ^= arrFlips[iBit];
+            }
+
+            if (!uDiff) {
+                std::string sColliding = sBase;
+                for (size_t j = 0; j < 96; j++) {
+                    if (flips[j])
+                        sColliding[j / 6] ^= static_cast<char>(1 << (j % 6));
+                }
+                return std::make_pair(sBase, sColliding);
+            }
+        }
+
+        return {};
+    }
+
+
+    bool Equal(const cvar::ObjectMap& _first, const cvar::ObjectMap& _second);
+
+    // deep comparison, packed and mixed lists with equal elements are considered equal
+    inline bool Equal(const cvar::Value& _first, const cvar::Value& _second) {
+        if (_first.index() != _second.index())
+            return false;
+
+        switch (_first.index()) {
+            case cvar::Type_None:
+                return true;
+
+            case cvar::Type_Int:
+                return std::get<cvar::Int>(_first) == std::get<cvar::Int>(_second);
+
+            case cvar::Type_Float:
+                return std::get<cvar::Float>(_first) == std::get<cvar::Float>(_second);
+
+            case cvar::Type_Bool:
+                return std::get<cvar::Bool>(_first) == std::get<cvar::Bool>(_second);
+
+            case cvar::Type_String:
+                return std::get<cvar::String>(_first) == std::get<cvar::String>(_second);
+
+            case cvar::Type_List:
+            {
+                const cvar::List& first = std::get<cvar::List>(_first);
+                const cvar::List& second = std::get<cvar::List>(_second);
+                if (first.Size() != second.Size())
+                    return false;
+
+                for (size_t i = 0; i < first.Size(); i++) {
+                    if (!Equal(first.At(i), second.At(i)))
+                        return false;
+                }
+                return true;
+            }
+
+            default:
+                return Equal(std::get<std::shared_ptr<cvar::Object>>(_first)->GetContents(),
+                             std::get<std::shared_ptr<cvar::Object>>(_second)->GetContents());
+        }
+    }
+
+    // entries are compared regardless of their order
+    inline bool Equal(const cvar::ObjectMap& _first, const cvar::ObjectMap& _second) {
+        if (_first.size() != _second.size())
+            return false;
+
+        for (auto it = _first.begin(); it != _first.end(); it++) {
+            auto itOther = _second.find(it->first);
+            if (itOther == _second.end() || !Equal(it->second, itOther->second))
+                return false;
+        }
+        return true;
+    }
+}
+
+#define CVAR_CHECK(x) cvar_test::Check(static_cast<bool>(x), #x, __FILE__, __LINE__)
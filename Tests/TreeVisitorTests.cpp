@@ -0,0 +1,151 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: TreeVisitorTests.cpp - prefix scoped tree iteration tests
+// author: Karl-Mihkel Ott
+
+#include "TestCommon.h"
+#include <cvar/CVarSystem.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace cvar;
+
+static void _Build() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    cvarSyst.Set<Int>("visit.video.width", 1280);
+    cvarSyst.Set<Int>("visit.video.height", 720);
+    cvarSyst.Set<Bool>("visit.video.advanced.hdr", true);
+    cvarSyst.Set<Float>("visit.audio.volume", 0.5f);
+    cvarSyst.Set<String>("visit.name", String("player"));
+    cvarSyst.Set<Int>("visited", 1);
+}
+
+
+static void TestOrder() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+
+    // objects are visited before their contents, in insertion order, visitors returning void see everything
+    std::vector<std::string> paths;
+    cvarSyst.ForEach("visit", [&](std::string_view _sPath, const Value&) {
+        paths.emplace_back(_sPath);
+    });
+    const std::vector<std::string> expected = { "visit.video", "visit.video.width", "visit.video.height", "visit.video.advanced",
+                                                "visit.video.advanced.hdr", "visit.audio", "visit.audio.volume", "visit.name" };
+    CVAR_CHECK(paths == expected);
+
+    // values are passed along with the paths
+    Int iWidth = 0;
+    cvarSyst.ForEach("visit.video", [&](std::string_view _sPath, const Value& _val) {
+        if (_sPath == "visit.video.width")
+            iWidth = std::get<Int>(_val);
+    });
+    CVAR_CHECK(iWidth == 1280);
+
+    // the empty prefix visits the whole tree, and keys that only share the beginning of a segment aren't included
+    size_t uCount = 0;
+    bool bVisited = false;
+    cvarSyst.ForEach("", [&](std::string_view _sPath, const Value&) {
+        uCount++;
+        bVisited |= _sPath == "visited";
+    });
+    CVAR_CHECK(bVisited && uCount == expected.size() + 2);
+}
+
+
+static void TestPruning() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+
+    // skipped objects are visited themselves, but not their contents
+    std::vector<std::string> paths;
+    cvarSyst.ForEach("visit", [&](std::string_view _sPath, const Value&) {
+        paths.emplace_back(_sPath);
+        return _sPath == "visit.video" ? VisitResult::Skip : VisitResult::Continue;
+    });
+    CVAR_CHECK(paths == std::vector<std::string>({ "visit.video", "visit.audio", "visit.audio.volume", "visit.name" }));
+
+    // skipping a leaf has no effect on the following nodes
+    paths.clear();
+    cvarSyst.ForEach("visit.video", [&](std::string_view _sPath, const Value&) {
+        paths.emplace_back(_sPath);
+        return VisitResult::Skip;
+    });
+    CVAR_CHECK(paths == std::vector<std::string>({ "visit.video.width", "visit.video.height", "visit.video.advanced" }));
+
+    // stopping ends the iteration right away, including the levels above
+    paths.clear();
+    cvarSyst.ForEach("visit", [&](std::string_view _sPath, const Value&) {
+        paths.emplace_back(_sPath);
+        return _sPath == "visit.video.advanced.hdr" ? VisitResult::Stop : VisitResult::Continue;
+    });
+    CVAR_CHECK(paths.size() == 5 && paths.back() == "visit.video.advanced.hdr");
+}
+
+
+static void TestPrefixes() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+
+    // a leaf prefix visits only the leaf itself
+    std::vector<std::string> paths;
+    Float fVolume = 0.0f;
+    cvarSyst.ForEach("visit.audio.volume", [&](std::string_view _sPath, const Value& _val) {
+        paths.emplace_back(_sPath);
+        fVolume = std::get<Float>(_val);
+        return VisitResult::Continue;
+    });
+    CVAR_CHECK(paths == std::vector<std::string>({ "visit.audio.volume" }));
+    CVAR_CHECK(fVolume == 0.5f);
+
+    // missing prefixes and prefixes below leaves visit nothing
+    paths.clear();
+    auto visitor = [&](std::string_view _sPath, const Value&) {
+        paths.emplace_back(_sPath);
+    };
+    cvarSyst.ForEach("visit.missing", visitor);
+    cvarSyst.ForEach("visit.name.child", visitor);
+    cvarSyst.ForEach("visit.vid", visitor);
+    CVAR_CHECK(paths.empty());
+
+    // snapshots are visited in the same way
+    Snapshot snapshot = cvarSyst.TakeSnapshot();
+    snapshot.ForEach("visit.audio", visitor);
+    CVAR_CHECK(paths == std::vector<std::string>({ "visit.audio.volume" }));
+}
+
+
+static void TestPathBuffer() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+
+    // every path is written into the same buffer, only the visited node's path is valid during the call
+    std::vector<const char*> buffers;
+    std::vector<std::string> paths;
+    cvarSyst.ForEach("visit.video", [&](std::string_view _sPath, const Value&) {
+        buffers.push_back(_sPath.data());
+        paths.emplace_back(_sPath);
+    });
+
+    CVAR_CHECK(paths.size() == 4);
+    CVAR_CHECK(paths[2] == "visit.video.advanced" && paths[3] == "visit.video.advanced.hdr");
+    for (size_t i = 1; i < buffers.size(); i++) {
+        // the buffer only grows for longer paths, it's never reallocated for shorter ones
+        if (paths[i].size() <= paths[i - 1].size())
+            CVAR_CHECK(buffers[i] == buffers[i - 1]);
+    }
+
+    // returning to a shorter path after a deeper one truncates the buffer
+    paths.clear();
+    cvarSyst.ForEach("visit", [&](std::string_view _sPath, const Value&) {
+        paths.emplace_back(_sPath);
+    });
+    CVAR_CHECK(paths[5] == "visit.audio" && paths[5].size() == std::string_view("visit.audio").size());
+}
+
+
+int main() {
+    _Build();
+    TestOrder();
+    TestPruning();
+    TestPrefixes();
+    TestPathBuffer();
+    return cvar_test::Report("TreeVisitorTests");
+}
@@ -0,0 +1,151 @@
+// CVar: Console variable systems support library
+// license: Apache, see LICENCE file
+// file: WriteTests.cpp - Set, Emplace and batched write tests
+// author: Karl-Mihkel Ott
+
+#include "TestCommon.h"
+#include <cvar/CVarSystem.h>
+#include <string>
+#include <utility>
+
+using namespace cvar;
+
+static void TestOverwrite() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    CVAR_CHECK(cvarSyst.Set<Int>("write.value", 1));
+    CVAR_CHECK(cvarSyst.Set<Int>("write.value", 2));
+    CVAR_CHECK(*cvarSyst.Get<Int>("write.value") == 2);
+
+    // values of another type replace the old one
+    CVAR_CHECK(cvarSyst.Set<String>("write.value", String("text")));
+    CVAR_CHECK(!cvarSyst.Get<Int>("write.value"));
+    CVAR_CHECK(*cvarSyst.Get<String>("write.value") == String("text"));
+
+    // objects are replaced as a whole, including the nodes below them
+    cvarSyst.Set<Bool>("write.object.child", true);
+    CVAR_CHECK(cvarSyst.Set<Float>("write.object", 0.5f));
+    CVAR_CHECK(*cvarSyst.Get<Float>("write.object") == 0.5f);
+    CVAR_CHECK(!cvarSyst.GetValue("write.object.child"));
+
+    // missing parents are created, but a scalar parent can't be written through
+    CVAR_CHECK(cvarSyst.Set<Int>("write.deep.a.b.c", 3));
+    CVAR_CHECK(std::holds_alternative<std::shared_ptr<Object>>(*cvarSyst.GetValue("write.deep.a.b")));
+    CVAR_CHECK(!cvarSyst.Set<Int>("write.object.child", 1));
+    CVAR_CHECK(*cvarSyst.Get<Float>("write.object") == 0.5f);
+}
+
+
+static void TestMoves() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+
+    // rvalue lists are moved into the node, the stored list keeps the original storage
+    const Int arrValues[] = { 1, 2, 3, 4, 5 };
+    List values(arrValues, 5);
+    const Int* pStorage = values.GetSpan<Int>().data();
+    CVAR_CHECK(cvarSyst.Set<List>("write.moved.list", std::move(values)));
+    CVAR_CHECK(values.Size() == 0);
+    const List* pList = cvarSyst.Get<List>("write.moved.list");
+    CVAR_CHECK(pList && pList->GetSpan<Int>().data() == pStorage);
+
+    // the same for strings whose text doesn't fit inline
+    String text("a string that is too long to be stored inline");
+    const char* pText = text.GetView().data();
+    CVAR_CHECK(cvarSyst.Set<String>("write.moved.text", std::move(text)));
+    CVAR_CHECK(text.GetView().empty());
+    CVAR_CHECK(cvarSyst.Get<String>("write.moved.text")->GetView().data() == pText);
+
+    // overwriting an existing value of the same type moves into it as well
+    List replacement(arrValues, 2);
+    pStorage = replacement.GetSpan<Int>().data();
+    CVAR_CHECK(cvarSyst.Set<List>("write.moved.list", std::move(replacement)));
+    CVAR_CHECK(cvarSyst.Get<List>("write.moved.list")->GetSpan<Int>().data() == pStorage);
+
+    // lvalues are copied and stay usable
+    List kept(arrValues, 3);
+    CVAR_CHECK(cvarSyst.Set<List>("write.copied.list", kept));
+    CVAR_CHECK(kept.Size() == 3);
+    CVAR_CHECK(cvarSyst.Get<List>("write.copied.list")->GetSpan<Int>().data() != kept.GetSpan<Int>().data());
+}
+
+
+static void TestEmplace() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    const Float arrWeights[] = { 0.25f, 0.5f, 0.25f };
+    CVAR_CHECK(cvarSyst.Emplace<List>("write.emplaced.weights", arrWeights, size_t(3)));
+    const List* pWeights = cvarSyst.Get<List>("write.emplaced.weights");
+    CVAR_CHECK(pWeights && pWeights->GetPackedType() == Type_Float && pWeights->GetSpan<Float>()[1] == 0.5f);
+
+    CVAR_CHECK(cvarSyst.Emplace<String>("write.emplaced.name", "emplaced text that needs its own block"));
+    CVAR_CHECK(*cvarSyst.Get<String>("write.emplaced.name") == String("emplaced text that needs its own block"));
+
+    // emplacing replaces a value of another type
+    CVAR_CHECK(cvarSyst.Emplace<Int>("write.emplaced.name", 5));
+    CVAR_CHECK(*cvarSyst.Get<Int>("write.emplaced.name") == 5);
+    CVAR_CHECK(!cvarSyst.Emplace<Int>("write.emplaced.name.child", 1));
+}
+
+
+static void TestApply() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    CVarBatch batch;
+    batch.Set<Int>("write.batch.width", 1280);
+    batch.Set<Int>("write.batch.height", 720);
+    batch.Set<String>("write.batch.title", String("window"));
+    CVAR_CHECK(cvarSyst.Apply(std::move(batch)));
+    CVAR_CHECK(batch.Size() == 0);
+    CVAR_CHECK(*cvarSyst.Get<Int>("write.batch.width") == 1280);
+    CVAR_CHECK(*cvarSyst.Get<Int>("write.batch.height") == 720);
+
+    // the last write to a duplicate key wins
+    batch.Set<Int>("write.batch.width", 800);
+    batch.Set<Int>("write.batch.width", 1024);
+    CVAR_CHECK(cvarSyst.Apply(std::move(batch)));
+    CVAR_CHECK(*cvarSyst.Get<Int>("write.batch.width") == 1024);
+}
+
+
+static void TestApplyRejected() {
+    CVarSystem& cvarSyst = CVarSystem::GetInstance();
+    cvarSyst.Set<Int>("write.rejected.scalar", 1);
+    cvarSyst.Set<Int>("write.rejected.kept", 2);
+    const Snapshot before = cvarSyst.TakeSnapshot();
+
+    // a single key below a non-object parent rejects the whole batch, including the keys before it
+    CVarBatch batch;
+    batch.Set<Int>("write.rejected.kept", 3);
+    batch.Set<Int>("write.rejected.created.value", 4);
+    batch.Set<Int>("write.rejected.scalar.child", 5);
+    CVAR_CHECK(!cvarSyst.Apply(std::move(batch)));
+    CVAR_CHECK(cvar_test::Equal(before.GetRoot(), cvarSyst.GetRoot()));
+    CVAR_CHECK(*cvarSyst.Get<Int>("write.rejected.kept") == 2);
+    CVAR_CHECK(!cvarSyst.GetValue("write.rejected.created"));
+
+    // a key can't be both a value and the parent of another key of the same batch
+    batch.Clear();
+    batch.Set<Int>("write.rejected.prefix.a", 1);
+    batch.Set<Int>("write.rejected.prefix", 2);
+    CVAR_CHECK(!cvarSyst.Apply(std::move(batch)));
+    CVAR_CHECK(!cvarSyst.GetValue("write.rejected.prefix"));
+
+    // keys that only share the beginning of a segment are unrelated
+    batch.Clear();
+    batch.Set<Int>("write.rejected.pre", 1);
+    batch.Set<Int>("write.rejected.prefix", 2);
+    CVAR_CHECK(cvarSyst.Apply(std::move(batch)));
+    CVAR_CHECK(*cvarSyst.Get<Int>("write.rejected.pre") == 1);
+
+    batch.Set<Int>("write.rejected.kept", 3);
+    batch.Set<Int>("", 1);
+    CVAR_CHECK(!cvarSyst.Apply(std::move(batch)));
+    CVAR_CHECK(*cvarSyst.Get<Int>("write.rejected.kept") == 2);
+}
+
+
+int main() {
+    TestOverwrite();
+    TestMoves();
+    TestEmplace();
+    TestApply();
+    TestApplyRejected();
+    return cvar_test::Report("WriteTests");
+}